@@ -1,19 +1,32 @@
 #version 460 core
+#ifndef TEXTURE_ARRAYS
 #extension GL_ARB_bindless_texture : require
+#endif
 
  //hi res HDR fbo stores result in vec3 since its GL_RGB16F, only rgb no alpha hence vec3
 layout (location = 0) out vec4 fragColor;							//last step used by default fbo etc, must be at index 0
 layout (location = 1) out vec3 RGB16FColor;							//used by fbos for their first default output of color data to write to their attached color buffer GL_COLOR_ATTACHMENT0 texture
+layout (location = 2) out uint PickID;								//R32UI gpu picking attachment, only a draw buffer while objects are drawn
 
 layout (binding=0) uniform sampler2D TexHDR;
 layout (binding=1) uniform sampler2D TexBlur1;
 layout (binding=2) uniform sampler2D TexBlur2;
 layout (binding=3) uniform sampler2D TexModel;						//sampler used by some non indirect meshes
 
+#ifndef TEXTURE_ARRAYS
 layout(binding = 2, std430) readonly buffer TextureHandles
 {
 	sampler2D samplerBindlessTex[];
 }textureHandles;
+#else
+//no bindless textures, every texture is a layer of a size bucketed array, same ssbo holds bucket / layer pairs
+layout (binding=4) uniform sampler2DArray TexArrays[6];				//units 4 - 9, TextureArrays::ciBuckets
+
+layout(binding = 2, std430) readonly buffer TextureLayers
+{
+	uvec2 bucketLayer[];
+}textureLayers;
+#endif
 
 layout(binding = 3, std430) readonly buffer KdColors
 {
@@ -31,6 +44,7 @@ in VS_OUT
 	vec3 Normal;
 	vec2 TexCoord;
 	flat int DrawID;
+	flat uint PickID;
 }fs_in;
 
 subroutine vec3 RenderType();
@@ -51,6 +65,26 @@ vec3 calculateADS()
 				vec3(.75f, .75f, .55f) * max(dot(v, n), 0.f) + 
 				vec3(.4f, .4f, .4f) * pow(max(dot(h, n), 0.f), 8.f);
 }
+vec3 sampleMaterial()
+{
+#ifndef TEXTURE_ARRAYS
+	return texture(textureHandles.samplerBindlessTex[fs_in.DrawID], fs_in.TexCoord).rgb;
+#else
+	//constant indices only, the bucket isnt guaranteed to be dynamically uniform
+	uvec2 bucketLayer = textureLayers.bucketLayer[fs_in.DrawID];
+	vec3 texCoord = vec3(fs_in.TexCoord, float(bucketLayer.y));
+	switch (bucketLayer.x)
+	{
+		case 0u: return texture(TexArrays[0], texCoord).rgb;
+		case 1u: return texture(TexArrays[1], texCoord).rgb;
+		case 2u: return texture(TexArrays[2], texCoord).rgb;
+		case 3u: return texture(TexArrays[3], texCoord).rgb;
+		case 4u: return texture(TexArrays[4], texCoord).rgb;
+		default: return texture(TexArrays[5], texCoord).rgb;
+	}
+#endif
+}
+
 subroutine(RenderType)
 vec3 basicKd()
 {
@@ -60,12 +94,12 @@ vec3 basicKd()
 subroutine(RenderType)
 vec3 textured()
 {
-	return calculateADS() * texture(textureHandles.samplerBindlessTex[fs_in.DrawID], fs_in.TexCoord).rgb;
+	return calculateADS() * sampleMaterial();
 }
 subroutine(RenderType)
 vec3 emissive()
 {
-	return texture(textureHandles.samplerBindlessTex[fs_in.DrawID], fs_in.TexCoord).rgb;
+	return sampleMaterial();
 }
 subroutine(RenderType)
 vec3 basicEmissive()
@@ -140,7 +174,10 @@ vec4 reinhardExtendedComposite()
 void main()	
 {
     if(Pass == 1)
+	{
 		RGB16FColor = renderType();
+		PickID = fs_in.PickID;
+	}
 	else if(Pass == 2)
     	fragColor = reinhardExtendedComposite();
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #version 460 core
+#ifndef TEXTURE_ARRAYS
 #extension GL_ARB_bindless_texture : require
+#endif
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
@@ -22,6 +24,7 @@ out VS_OUT
 	vec3 Normal;
 	vec2 TexCoord;
 	flat int DrawID;
+	flat uint PickID;												//transform slot + 1, 0 is left for nothing picked
 }vs_out;
 
 void main()
@@ -33,4 +36,5 @@ void main()
 	vs_out.Normal = (matModelView * vec4(aNormal, 0.f)).xyz;
 	vs_out.Position = (matModelView * vec4(aPos, 1.f)).xyz;
 	vs_out.DrawID = gl_DrawID;
+	vs_out.PickID = uint(gl_BaseInstance + gl_InstanceID) + 1u;
 }
\ No newline at end of file
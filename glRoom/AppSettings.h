@@ -6,5 +6,16 @@ struct AppSettings
 	int mWidth, mHeight;		
 	float fWindowSize;
 	std::string strAssetSrc;										//assets folder src 
-	AppSettings() : mWidth(0), mHeight(0), strAssetSrc("./assets/"), fWindowSize(1.f) {}
-};
\ No newline at end of file
+	float fFixedTimeStep;											//physics step in seconds, simulation always advances by this amount
+	int iMaxSubSteps;												//max physics steps per frame, excess time is dropped so a slow frame cant spiral
+	bool bInterpolateTransforms;									//blend the last 2 physics steps, off = render the latest step as is
+	int iPhysicsThreads;											//<= 1 single threaded world, otherwise btDiscreteDynamicsWorldMt
+	int iResourceBudgetMB;											//unreferenced scene resources are kept resident up to this size
+	int iFrameLatency;												//frames the simulation runs ahead of rendering, 0 = serial, 1 = simulate the next frame while this one renders
+	bool bGPUPicking;												//clicks read the object id under the cursor back from the gpu, off = ray test the whole world
+	bool bAxisSweepBroadphase;										//sweep and prune inside the room bounds instead of the dbvt broadphase
+	std::string strInputRecord;										//GLROOM_RECORD, every play session writes its input here
+	std::string strInputReplay;										//GLROOM_REPLAY, starts straight in the room and plays this log back at the fixed timestep
+	bool bReplayUncapped;											//GLROOM_REPLAY_UNCAPPED, no vsync so a replay runs as fast as it can
+	AppSettings() : mWidth(0), mHeight(0), strAssetSrc("./assets/"), fWindowSize(1.f), fFixedTimeStep(1.f / 60.f), iMaxSubSteps(5), bInterpolateTransforms(true), iPhysicsThreads(1), iResourceBudgetMB(256), iFrameLatency(1), bGPUPicking(true), bAxisSweepBroadphase(false), bReplayUncapped(false) {}
+};
@@ -0,0 +1,148 @@
+#include "FileWatcher.h"
+
+#include <spdlog/spdlog.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+FileWatcher::FileWatcher(std::string strRoot) :
+	pathRoot(strRoot),
+	fdInotify(-1),
+	timeLastScan(Clock::now())
+{
+	std::error_code ec;
+	if (!std::filesystem::is_directory(pathRoot, ec))
+	{
+		spdlog::error("FileWatcher : not a folder " + strRoot);
+		return;
+	}
+
+#ifdef __linux__
+	fdInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fdInotify >= 0)
+	{
+		addWatch(pathRoot);
+		for (auto iter = std::filesystem::recursive_directory_iterator(pathRoot, ec); iter != std::filesystem::recursive_directory_iterator(); iter.increment(ec))
+		{
+			if (iter->is_directory(ec))
+				addWatch(iter->path());
+		}
+		return;
+	}
+	spdlog::warn("inotify unavailable, polling for asset changes");
+#endif
+
+	//remember the current state, only changes from now on are reported
+	scan();
+	mapPending.clear();
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+	if (fdInotify >= 0)
+		close(fdInotify);
+#endif
+}
+
+bool FileWatcher::isNative() const
+{
+	return fdInotify >= 0;
+}
+
+void FileWatcher::poll(std::vector<std::string>& vcChanged)
+{
+	vcChanged.clear();
+	if (isNative())
+		readEvents();
+	else if (Clock::now() - timeLastScan >= std::chrono::milliseconds(ciScanMs))
+		scan();
+
+	//editors often save in several writes, wait until a file is quiet
+	const Clock::time_point timeNow = Clock::now();
+	for (auto iter = mapPending.begin(); iter != mapPending.end();)
+	{
+		if (timeNow - iter->second >= std::chrono::milliseconds(ciSettleMs))
+		{
+			vcChanged.emplace_back(iter->first);
+			iter = mapPending.erase(iter);
+		}
+		else
+			iter++;
+	}
+}
+
+void FileWatcher::readEvents()
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[4096];
+	while (true)
+	{
+		ssize_t iLength = read(fdInotify, buffer, sizeof(buffer));
+		if (iLength <= 0)
+			break;
+
+		for (char* ptr = buffer; ptr < buffer + iLength;)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+			ptr += sizeof(inotify_event) + event->len;
+
+			auto iterDir = mapWatchDirs.find(event->wd);
+			if (iterDir == mapWatchDirs.end() || event->len == 0)
+				continue;
+
+			const std::filesystem::path pathFile = iterDir->second / event->name;
+			if (event->mask & IN_ISDIR)
+			{
+				//new folders get watched too, files copied into them before the watch are missed
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+					addWatch(pathFile);
+				continue;
+			}
+			mapPending[getRelativePath(pathFile)] = Clock::now();
+		}
+	}
+#endif
+}
+
+void FileWatcher::scan()
+{
+	timeLastScan = Clock::now();
+	std::error_code ec;
+	for (auto iter = std::filesystem::recursive_directory_iterator(pathRoot, ec); iter != std::filesystem::recursive_directory_iterator(); iter.increment(ec))
+	{
+		if (!iter->is_regular_file(ec))
+			continue;
+
+		const std::string strPath = getRelativePath(iter->path());
+		const std::filesystem::file_time_type timeWrite = iter->last_write_time(ec);
+		auto iterStamp = mapStamps.find(strPath);
+		if (iterStamp == mapStamps.end() || iterStamp->second != timeWrite)
+		{
+			mapStamps[strPath] = timeWrite;
+			mapPending[strPath] = timeLastScan;
+		}
+	}
+}
+
+void FileWatcher::addWatch(const std::filesystem::path& pathDir)
+{
+#ifdef __linux__
+	//close_write catches in place saves, moved_to catches editors that save to a temp file and rename
+	int wd = inotify_add_watch(fdInotify, pathDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (wd < 0)
+	{
+		spdlog::warn("Failed to watch " + pathDir.string());
+		return;
+	}
+	mapWatchDirs[wd] = pathDir;
+#endif
+}
+
+std::string FileWatcher::getRelativePath(const std::filesystem::path& pathFile) const
+{
+	return pathFile.lexically_relative(pathRoot).generic_string();
+}
@@ -0,0 +1,40 @@
+//reports files changed under a folder, inotify on linux, timestamp polling everywhere else
+//events are held back until the file was quiet for a moment so half written saves arent picked up
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+class FileWatcher
+{
+public:
+	FileWatcher(std::string strRoot);
+	~FileWatcher();
+
+	//non blocking, fills paths relative to the root using / as separator, call once per frame
+	void poll(std::vector<std::string>& vcChanged);
+	bool isNative() const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+	static constexpr int ciSettleMs = 100;										//quiet time before a change is reported
+	static constexpr int ciScanMs = 500;										//polling fallback interval
+
+	void readEvents();
+	void scan();
+	void addWatch(const std::filesystem::path& pathDir);
+	std::string getRelativePath(const std::filesystem::path& pathFile) const;
+
+	std::filesystem::path pathRoot;
+	std::map<std::string, Clock::time_point> mapPending;						//changed files waiting to settle
+
+	//inotify
+	int fdInotify;
+	std::map<int, std::filesystem::path> mapWatchDirs;							//watch descriptor -> folder
+
+	//polling fallback
+	std::map<std::string, std::filesystem::file_time_type> mapStamps;
+	Clock::time_point timeLastScan;
+};
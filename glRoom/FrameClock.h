@@ -0,0 +1,28 @@
+//high resolution frame timer based on the performance counter
+//the counter is read only once per tick so no time is lost between two frames
+#pragma once
+#include <SDL_timer.h>
+
+class FrameClock
+{
+public:
+	FrameClock() :
+		uFrequency(SDL_GetPerformanceFrequency()),
+		uLastCounter(SDL_GetPerformanceCounter())
+	{}
+
+	//seconds elapsed since the last tick
+	double tick()
+	{
+		const Uint64 uCounter = SDL_GetPerformanceCounter();
+		const double dDeltaTime = static_cast<double>(uCounter - uLastCounter) / static_cast<double>(uFrequency);
+		uLastCounter = uCounter;
+		return dDeltaTime;
+	}
+
+	void reset() { uLastCounter = SDL_GetPerformanceCounter(); }
+
+private:
+	Uint64 uFrequency;
+	Uint64 uLastCounter;
+};
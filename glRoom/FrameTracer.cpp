@@ -0,0 +1,118 @@
+#include "FrameTracer.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+FrameTracer& FrameTracer::get()
+{
+	static FrameTracer frameTracer;
+	return frameTracer;
+}
+
+uint64_t FrameTracer::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FrameTracer::FrameTracer() :
+	bEnabled(false),
+	uEpochNs(now())
+{
+}
+
+TraceRingBuffer* FrameTracer::getThreadBuffer()
+{
+	//buffers are never freed while the app runs so the cached ptr stays valid
+	thread_local TraceRingBuffer* ptrBuffer = nullptr;
+	if (ptrBuffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(mtxBuffers);
+		vcBuffers.emplace_back(std::make_unique<TraceRingBuffer>(static_cast<uint32_t>(vcBuffers.size())));
+		ptrBuffer = vcBuffers.back().get();
+	}
+	return ptrBuffer;
+}
+
+void FrameTracer::record(const char* szName, uint64_t uStartNs, uint64_t uEndNs)
+{
+	getThreadBuffer()->push(TraceEvent{ szName, uStartNs, uEndNs });
+}
+
+void FrameTracer::registerMainThread()
+{
+	TraceRingBuffer* ptrBuffer = getThreadBuffer();
+	std::lock_guard<std::mutex> lock(mtxBuffers);
+	ptrBuffer->setMain();
+}
+
+bool FrameTracer::hasEvents()
+{
+	std::lock_guard<std::mutex> lock(mtxBuffers);
+	for (auto& buffer : vcBuffers)
+	{
+		if (buffer->getHead() != 0)
+			return true;
+	}
+	return false;
+}
+
+bool FrameTracer::exportJSON(const std::string& strPath)
+{
+	FILE* fileTrace = fopen(strPath.c_str(), "w");
+	if (fileTrace == nullptr)
+	{
+		spdlog::error("Failed to open trace file : " + strPath);
+		return false;
+	}
+
+	fprintf(fileTrace, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool bFirst = true;
+	size_t iTotalEvents = 0;
+
+	std::lock_guard<std::mutex> lock(mtxBuffers);
+	std::vector<TraceEvent> vcEvents;
+	for (auto& buffer : vcBuffers)
+	{
+		//copy the live window first, then drop whatever the owning thread overwrote while copying
+		const uint64_t uHead = buffer->getHead();
+		uint64_t uTail = uHead > TraceRingBuffer::ciCapacity ? uHead - TraceRingBuffer::ciCapacity : 0;
+		vcEvents.clear();
+		for (uint64_t i = uTail; i < uHead; i++)
+			vcEvents.emplace_back(buffer->at(i));
+
+		//a push still in progress at uHeadAfter is already writing the slot of uHeadAfter - ciCapacity
+		const uint64_t uHeadAfter = buffer->getHead();
+		size_t iSkip = 0;
+		if (uHeadAfter + 1 > TraceRingBuffer::ciCapacity && uHeadAfter + 1 - TraceRingBuffer::ciCapacity > uTail)
+			iSkip = std::min(vcEvents.size(), static_cast<size_t>(uHeadAfter + 1 - TraceRingBuffer::ciCapacity - uTail));
+
+		if (buffer->isMain())
+			fprintf(fileTrace, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"main\"}}",
+				bFirst ? "" : ",\n", buffer->getThreadID());
+		else
+			fprintf(fileTrace, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"worker %u\"}}",
+				bFirst ? "" : ",\n", buffer->getThreadID(), buffer->getThreadID());
+		bFirst = false;
+
+		for (size_t i = iSkip; i < vcEvents.size(); i++)
+		{
+			const TraceEvent& ev = vcEvents[i];
+			if (ev.uStartNs < uEpochNs)
+				continue;
+			fprintf(fileTrace, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				ev.szName,
+				buffer->getThreadID(),
+				static_cast<double>(ev.uStartNs - uEpochNs) / 1000.0,
+				static_cast<double>(ev.uEndNs - ev.uStartNs) / 1000.0);
+			iTotalEvents++;
+		}
+	}
+
+	fprintf(fileTrace, "\n]}\n");
+	fclose(fileTrace);
+
+	spdlog::info("Exported " + std::to_string(iTotalEvents) + " trace events to " + strPath);
+	return true;
+}
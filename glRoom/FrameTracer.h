@@ -0,0 +1,100 @@
+//lightweight scoped cpu instrumentation, exported as chrome trace event json (chrome://tracing or ui.perfetto.dev)
+//every thread records into its own ring buffer so recording never takes a lock
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TraceEvent
+{
+	const char* szName;																//only the pointer is stored, use string literals
+	uint64_t uStartNs;
+	uint64_t uEndNs;
+};
+
+//single producer ring buffer, only the owning thread pushes
+//oldest events are overwritten once the buffer is full
+class TraceRingBuffer
+{
+public:
+	static constexpr uint32_t ciCapacity = 1 << 15;									//must be power of 2
+
+	TraceRingBuffer(uint32_t uThreadID) : uThreadID(uThreadID), bMain(false), uHead(0) {}
+
+	void push(const TraceEvent& traceEvent)
+	{
+		const uint64_t head = uHead.load(std::memory_order_relaxed);
+		events[head & (ciCapacity - 1)] = traceEvent;
+		uHead.store(head + 1, std::memory_order_release);
+	}
+
+	uint64_t getHead() const { return uHead.load(std::memory_order_acquire); }
+	const TraceEvent& at(uint64_t index) const { return events[index & (ciCapacity - 1)]; }
+	uint32_t getThreadID() const { return uThreadID; }
+	bool isMain() const { return bMain; }
+	void setMain() { bMain = true; }
+
+private:
+	uint32_t uThreadID;
+	bool bMain;																		//labelled main in the export, any other thread is a worker
+	std::atomic<uint64_t> uHead;
+	TraceEvent events[ciCapacity];
+};
+
+class FrameTracer
+{
+public:
+	static FrameTracer& get();
+	static uint64_t now();
+
+	void setEnabled(bool bEnabled) { this->bEnabled.store(bEnabled, std::memory_order_relaxed); }
+	bool isEnabled() const { return bEnabled.load(std::memory_order_relaxed); }
+	void record(const char* szName, uint64_t uStartNs, uint64_t uEndNs);
+
+	//from the main thread at startup, whichever thread records first isnt necessarily the main one
+	void registerMainThread();
+
+	//can be called anytime from any thread, events recorded during the export may be skipped
+	bool exportJSON(const std::string& strPath);
+	bool hasEvents();
+
+private:
+	FrameTracer();
+	TraceRingBuffer* getThreadBuffer();
+
+	std::atomic<bool> bEnabled;
+	uint64_t uEpochNs;															//all timestamps are written relative to this
+	std::mutex mtxBuffers;														//only locked when a thread records its first event and on export
+	std::vector<std::unique_ptr<TraceRingBuffer>> vcBuffers;
+};
+
+//records the lifetime of the scope as a single complete event
+class ScopedTrace
+{
+public:
+	ScopedTrace(const char* szName) :
+		szName(szName),
+		uStartNs(FrameTracer::get().isEnabled() ? FrameTracer::now() : 0)
+	{}
+	~ScopedTrace()
+	{
+		if (uStartNs != 0)
+			FrameTracer::get().record(szName, uStartNs, FrameTracer::now());
+	}
+
+private:
+	const char* szName;
+	uint64_t uStartNs;
+};
+
+//compiled out entirely when GLROOM_TRACING is off, otherwise costs a relaxed atomic load while disabled
+#ifdef GLROOM_TRACING
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) ScopedTrace TRACE_CONCAT(scopedTrace, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
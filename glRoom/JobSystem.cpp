@@ -0,0 +1,263 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+//queue of the calling thread, only valid for threads owned by that job system
+thread_local const JobSystem* tlsOwner = nullptr;
+thread_local unsigned int tlsQueue = 0;
+
+JobSystem& JobSystem::get()
+{
+	static JobSystem jobSystem;
+	return jobSystem;
+}
+
+JobSystem::JobSystem(unsigned int iNumThreads) :
+	idMain(std::this_thread::get_id()),
+	iNextQueue(0),
+	iQueued(0),
+	iBackground(0),
+	bQuit(false),
+	uJobs(0),
+	uSteals(0)
+{
+	if (iNumThreads == 0)
+		iNumThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned int i = 0; i < iNumThreads; i++)
+		vcQueues.emplace_back(std::make_unique<WorkerQueue>());
+	tlsOwner = this;
+	tlsQueue = 0;
+
+	for (unsigned int i = 1; i < iNumThreads; i++)
+		vcThreads.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtxSleep);
+		bQuit = true;
+	}
+	cvSleep.notify_all();
+	for (auto& thread : vcThreads)
+		thread.join();
+	vcThreads.clear();
+
+	//workers only quit once the deques are empty, whatever got queued since runs here
+	while (tryRunOne(true) || runMainThreadJobs())
+		;
+	if (tlsOwner == this)
+		tlsOwner = nullptr;
+}
+
+void JobSystem::run(JobCounter& counter, std::function<void()> fnJob)
+{
+	counter.iPending.fetch_add(1, std::memory_order_relaxed);
+	push(Job{ std::move(fnJob), &counter });
+}
+
+void JobSystem::runOnMain(JobCounter& counter, std::function<void()> fnJob)
+{
+	counter.iPending.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(mtxMain);
+		dqMain.emplace_back(Job{ std::move(fnJob), &counter });
+	}
+	wake();
+}
+
+void JobSystem::runBackground(JobCounter& counter, std::function<void()> fnJob)
+{
+	counter.iPending.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(mtxBackground);
+		dqBackground.emplace_back(Job{ std::move(fnJob), &counter });
+	}
+	iBackground.fetch_add(1);
+	wake();
+}
+
+void JobSystem::push(Job job)
+{
+	//own deque if the caller is one of ours, otherwise spread them round robin
+	const unsigned int iQueue = tlsOwner == this ? tlsQueue : iNextQueue.fetch_add(1, std::memory_order_relaxed) % vcQueues.size();
+	{
+		std::lock_guard<std::mutex> lock(vcQueues[iQueue]->mtx);
+		vcQueues[iQueue]->dqJobs.emplace_back(std::move(job));
+	}
+	iQueued.fetch_add(1);
+	wake();
+}
+
+void JobSystem::wake()
+{
+	//taking the lock orders this against a thread that just checked its wait predicate
+	{
+		std::lock_guard<std::mutex> lock(mtxSleep);
+	}
+	cvSleep.notify_all();
+}
+
+void JobSystem::workerLoop(unsigned int iQueue)
+{
+	tlsOwner = this;
+	tlsQueue = iQueue;
+	while (true)
+	{
+		if (tryRunOne(true))
+			continue;
+
+		std::unique_lock<std::mutex> lock(mtxSleep);
+		cvSleep.wait(lock, [this] { return bQuit || hasQueuedJobs(); });
+		if (bQuit && !hasQueuedJobs())
+			return;
+	}
+}
+
+bool JobSystem::tryRunOne(bool bBackground)
+{
+	Job job;
+	const bool bOwned = tlsOwner == this;
+	const unsigned int iQueue = bOwned ? tlsQueue : 0;
+	if (!(bOwned && popLocal(iQueue, job)) && !steal(iQueue, bOwned, job))
+	{
+		if (!bBackground)
+			return false;
+
+		std::lock_guard<std::mutex> lock(mtxBackground);
+		if (dqBackground.empty())
+			return false;
+		job = std::move(dqBackground.front());
+		dqBackground.pop_front();
+		iBackground.fetch_sub(1);
+	}
+	execute(job);
+	return true;
+}
+
+bool JobSystem::popLocal(unsigned int iQueue, Job& job)
+{
+	//newest first, its data is most likely still in cache
+	WorkerQueue& queue = *vcQueues[iQueue];
+	std::lock_guard<std::mutex> lock(queue.mtx);
+	if (queue.dqJobs.empty())
+		return false;
+	job = std::move(queue.dqJobs.back());
+	queue.dqJobs.pop_back();
+	iQueued.fetch_sub(1);
+	return true;
+}
+
+bool JobSystem::steal(unsigned int iThief, bool bOwnQueue, Job& job)
+{
+	//oldest first, in fork join that is usually the biggest piece of work
+	//threads without a queue of their own take from all of them
+	for (size_t i = bOwnQueue ? 1 : 0; i < vcQueues.size(); i++)
+	{
+		WorkerQueue& queue = *vcQueues[(iThief + i) % vcQueues.size()];
+		std::lock_guard<std::mutex> lock(queue.mtx);
+		if (queue.dqJobs.empty())
+			continue;
+		job = std::move(queue.dqJobs.front());
+		queue.dqJobs.pop_front();
+		iQueued.fetch_sub(1);
+		uSteals.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::hasQueuedJobs() const
+{
+	return iQueued.load() > 0 || iBackground.load() > 0;
+}
+
+void JobSystem::execute(Job& job)
+{
+	job.fnJob();
+	uJobs.fetch_add(1, std::memory_order_relaxed);
+	if (job.counter->iPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		wake();
+}
+
+bool JobSystem::runMainThreadJobs()
+{
+	std::deque<Job> dqJobs;
+	{
+		std::lock_guard<std::mutex> lock(mtxMain);
+		dqJobs.swap(dqMain);
+	}
+	for (auto& job : dqJobs)
+		execute(job);
+
+	//one at a time, a level load is a single long job and the caller polls again next frame
+	const bool bRanQueued = vcThreads.empty() && tryRunOne(true);
+	return !dqJobs.empty() || bRanQueued;
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	const bool bMain = isMainThread();
+	while (!counter.isDone())
+	{
+		//without workers nobody else would ever pick up background jobs
+		bool bRan = bMain && runMainThreadJobs();
+		if (!counter.isDone() && tryRunOne(vcThreads.empty()))
+			bRan = true;
+		if (bRan)
+			continue;
+
+		//nothing to help with, sleep until a job is queued or finishes
+		//queued background jobs only count if this thread would run them, otherwise it would spin on them
+		std::unique_lock<std::mutex> lock(mtxSleep);
+		cvSleep.wait(lock, [this, &counter, bMain]
+			{
+				if (counter.isDone() || iQueued.load() > 0 || (vcThreads.empty() && iBackground.load() > 0))
+					return true;
+				if (!bMain)
+					return false;
+				std::lock_guard<std::mutex> lockMain(mtxMain);
+				return !dqMain.empty();
+			});
+	}
+}
+
+void JobSystem::parallelFor(int iBegin, int iEnd, int iGrainSize, const std::function<void(int, int)>& fnBody, unsigned int iMaxThreads)
+{
+	if (iEnd <= iBegin)
+		return;
+
+	iGrainSize = std::max(iGrainSize, 1);
+	const int iChunks = (iEnd - iBegin + iGrainSize - 1) / iGrainSize;
+	unsigned int iThreads = iMaxThreads == 0 ? getNumThreads() : std::min(iMaxThreads, getNumThreads());
+	iThreads = std::min(iThreads, static_cast<unsigned int>(iChunks));
+	if (iThreads <= 1)
+	{
+		fnBody(iBegin, iEnd);
+		return;
+	}
+
+	//each helper job pulls chunks until none are left, jobs starting late just find nothing to do
+	std::atomic<int> iNextChunk(0);
+	auto fnRunChunks = [&iNextChunk, &fnBody, iBegin, iEnd, iGrainSize, iChunks]()
+	{
+		int iChunk;
+		while ((iChunk = iNextChunk.fetch_add(1)) < iChunks)
+		{
+			const int iChunkBegin = iBegin + iChunk * iGrainSize;
+			fnBody(iChunkBegin, std::min(iChunkBegin + iGrainSize, iEnd));
+		}
+	};
+
+	JobCounter counter;
+	for (unsigned int i = 1; i < iThreads; i++)
+		run(counter, fnRunChunks);
+	fnRunChunks();
+	wait(counter);
+}
+
+JobStats JobSystem::getStats() const
+{
+	return JobStats{ uJobs.load(std::memory_order_relaxed), uSteals.load(std::memory_order_relaxed) };
+}
@@ -0,0 +1,103 @@
+//the one thread pool of the application, shared by loading, physics and the system scheduler
+//every worker owns a deque, it pushes and pops its own jobs at the back and steals from the front of the others
+//jobs are grouped by a JobCounter, whoever waits on a counter keeps running other jobs until it reaches 0
+//jobs posted with runOnMain only ever run on the main thread, for everything touching gl
+//background jobs (level loading) are only picked up by idle workers so a waiting frame never ends up running them
+//unless there are no workers at all
+//destroying it runs whatever is still queued before returning, so no counter is left pending
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct JobCounter
+{
+	std::atomic<int> iPending;
+	JobCounter() : iPending(0) {}
+	bool isDone() const { return iPending.load(std::memory_order_acquire) == 0; }
+};
+
+struct JobStats
+{
+	uint64_t uJobs;															//jobs run so far
+	uint64_t uSteals;														//of those, taken from another thread's deque
+};
+
+class JobSystem
+{
+public:
+	//created on first use, that thread becomes the main thread, so call it from main before anything else
+	static JobSystem& get();
+
+	//iNumThreads includes the main thread, 0 = hardware concurrency
+	JobSystem(unsigned int iNumThreads = 0);
+	~JobSystem();
+
+	unsigned int getNumThreads() const { return static_cast<unsigned int>(vcThreads.size()) + 1; }
+	bool isMainThread() const { return std::this_thread::get_id() == idMain; }
+
+	void run(JobCounter& counter, std::function<void()> fnJob);
+	void runOnMain(JobCounter& counter, std::function<void()> fnJob);
+	void runBackground(JobCounter& counter, std::function<void()> fnJob);
+
+	//helps out until counter is done, the main thread also runs its pinned jobs meanwhile
+	void wait(JobCounter& counter);
+
+	//main thread only, runs pinned jobs posted so far, returns false if there were none
+	//without workers it also runs one queued job, otherwise a background job nobody waits on would never run
+	bool runMainThreadJobs();
+
+	//splits [iBegin, iEnd) into chunks of iGrainSize and blocks until all of them ran
+	//iMaxThreads limits how many threads (caller included) work on it, 0 = all
+	void parallelFor(int iBegin, int iEnd, int iGrainSize, const std::function<void(int, int)>& fnBody, unsigned int iMaxThreads = 0);
+
+	JobStats getStats() const;
+
+private:
+	struct Job
+	{
+		std::function<void()> fnJob;
+		JobCounter* counter;
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex mtx;
+		std::deque<Job> dqJobs;
+	};
+
+	void workerLoop(unsigned int iQueue);
+	void push(Job job);
+	bool tryRunOne(bool bBackground);
+	bool popLocal(unsigned int iQueue, Job& job);
+	bool steal(unsigned int iThief, bool bOwnQueue, Job& job);
+	bool hasQueuedJobs() const;
+	void execute(Job& job);
+	void wake();
+
+	std::thread::id idMain;
+	std::vector<std::thread> vcThreads;
+	std::vector<std::unique_ptr<WorkerQueue>> vcQueues;						//0 is the main thread's, workers follow
+	std::atomic<unsigned int> iNextQueue;									//round robin target for threads without a queue
+
+	std::mutex mtxMain;
+	std::deque<Job> dqMain;
+	std::mutex mtxBackground;
+	std::deque<Job> dqBackground;
+
+	//sleeping workers and waiters, woken whenever a job is queued or finished
+	std::mutex mtxSleep;
+	std::condition_variable cvSleep;
+	std::atomic<int> iQueued;												//in the worker deques, any thread waiting can help with those
+	std::atomic<int> iBackground;											//in dqBackground, only idle workers run those
+	bool bQuit;
+
+	std::atomic<uint64_t> uJobs;
+	std::atomic<uint64_t> uSteals;
+};
@@ -0,0 +1,97 @@
+#include "MappedFile.h"
+
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+	data(nullptr),
+	iSize(0)
+#ifdef _WIN32
+	, file(INVALID_HANDLE_VALUE),
+	mapping(nullptr)
+#endif
+{
+}
+
+#ifdef _WIN32
+MappedFile::~MappedFile()
+{
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mapping != nullptr)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+}
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string& strPath)
+{
+	std::unique_ptr<MappedFile> mappedFile(new MappedFile());
+	mappedFile->file = CreateFileA(strPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mappedFile->file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER iFileSize;
+	if (!GetFileSizeEx(mappedFile->file, &iFileSize) || iFileSize.QuadPart == 0)
+		return nullptr;
+	mappedFile->iSize = static_cast<size_t>(iFileSize.QuadPart);
+
+	mappedFile->mapping = CreateFileMappingA(mappedFile->file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (mappedFile->mapping == nullptr)
+	{
+		spdlog::error("Failed to map " + strPath);
+		return nullptr;
+	}
+	mappedFile->data = static_cast<unsigned char*>(MapViewOfFile(mappedFile->mapping, FILE_MAP_COPY, 0, 0, 0));
+	if (mappedFile->data == nullptr)
+	{
+		spdlog::error("Failed to map " + strPath);
+		return nullptr;
+	}
+	return mappedFile;
+}
+#else
+MappedFile::~MappedFile()
+{
+	if (data != nullptr)
+		munmap(data, iSize);
+}
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string& strPath)
+{
+	int fd = ::open(strPath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(fd);
+		return nullptr;
+	}
+
+	//the mapping keeps the file alive on its own
+	void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		spdlog::error("Failed to map " + strPath);
+		return nullptr;
+	}
+
+	std::unique_ptr<MappedFile> mappedFile(new MappedFile());
+	mappedFile->data = static_cast<unsigned char*>(data);
+	mappedFile->iSize = static_cast<size_t>(fileStat.st_size);
+	return mappedFile;
+}
+#endif
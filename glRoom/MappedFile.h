@@ -0,0 +1,27 @@
+//whole file mapped into memory, nothing is read until a page is touched
+//the mapping is copy on write, writes land in private copies of the pages they touch and never reach the file
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+class MappedFile
+{
+public:
+	//nullptr if the file cant be opened or is empty
+	static std::unique_ptr<MappedFile> open(const std::string& strPath);
+	~MappedFile();
+
+	unsigned char* getData() const { return data; }								//page aligned
+	size_t getSize() const { return iSize; }
+
+private:
+	MappedFile();
+
+	unsigned char* data;
+	size_t iSize;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+};
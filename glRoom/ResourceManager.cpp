@@ -0,0 +1,85 @@
+#include "ResourceManager.h"
+
+#include <spdlog/spdlog.h>
+
+ResourceManager::ResourceManager(size_t iBudgetBytes) :
+	iBudgetBytes(iBudgetBytes),
+	iResidentBytes(0),
+	uUseClock(0)
+{
+}
+
+ResourceManager::~ResourceManager()
+{
+	std::lock_guard<std::recursive_mutex> lock(mtxResources);
+	while (!mapResources.empty())
+	{
+		//take it out first, fnFree may release other entries
+		auto iter = mapResources.begin();
+		std::function<void()> fnFree = std::move(iter->second.fnFree);
+		mapResources.erase(iter);
+		fnFree();
+	}
+}
+
+void ResourceManager::release(const std::string& strKey)
+{
+	std::lock_guard<std::recursive_mutex> lock(mtxResources);
+	auto iter = mapResources.find(strKey);
+	if (iter == mapResources.end() || iter->second.iRefs == 0)
+	{
+		spdlog::warn("Releasing unreferenced resource : " + strKey);
+		return;
+	}
+	iter->second.iRefs--;
+	if (iter->second.iRefs == 0 && iter->second.bStale)
+		evict(iter);
+}
+
+void ResourceManager::invalidate(const std::string& strKey)
+{
+	std::lock_guard<std::recursive_mutex> lock(mtxResources);
+	auto iter = mapResources.find(strKey);
+	if (iter == mapResources.end())
+		return;
+	if (iter->second.iRefs == 0)
+		evict(iter);
+	else
+		iter->second.bStale = true;
+}
+
+void ResourceManager::evict(std::map<std::string, Resource>::iterator iter)
+{
+	//take it out first, fnFree may release other entries
+	spdlog::info("Evicting resource : " + iter->first);
+	std::function<void()> fnFree = std::move(iter->second.fnFree);
+	iResidentBytes -= iter->second.iBytes;
+	mapResources.erase(iter);
+	fnFree();
+}
+
+void ResourceManager::trim()
+{
+	std::lock_guard<std::recursive_mutex> lock(mtxResources);
+	while (iResidentBytes > iBudgetBytes)
+	{
+		auto iterVictim = mapResources.end();
+		for (auto iter = mapResources.begin(); iter != mapResources.end(); iter++)
+		{
+			if (iter->second.iRefs == 0 && (iterVictim == mapResources.end() || iter->second.uLastUse < iterVictim->second.uLastUse))
+				iterVictim = iter;
+		}
+
+		//everything left is in use
+		if (iterVictim == mapResources.end())
+			break;
+
+		evict(iterVictim);
+	}
+}
+
+size_t ResourceManager::getResidentBytes()
+{
+	std::lock_guard<std::recursive_mutex> lock(mtxResources);
+	return iResidentBytes;
+}
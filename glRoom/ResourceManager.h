@@ -0,0 +1,92 @@
+//keeps loaded resources alive across state changes so re-entering a state doesnt reload from disk
+//every resource is reference counted by the systems using it, unreferenced ones stay resident
+//until the budget is exceeded, then the least recently used ones are freed first
+//gl resources must only be released / trimmed on the gl thread, acquire and insert may be called from loading threads
+#pragma once
+#include <any>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <spdlog/spdlog.h>
+#include <string>
+
+class ResourceManager
+{
+public:
+	ResourceManager(size_t iBudgetBytes);
+	~ResourceManager();																	//frees everything, referenced or not
+
+	//a hit adds a reference, false if nothing is cached under strKey
+	template<typename T>
+	bool acquire(const std::string& strKey, T& value)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mtxResources);
+		auto iter = mapResources.find(strKey);
+		if (iter == mapResources.end() || iter->second.bStale)
+			return false;
+		value = std::any_cast<T>(iter->second.value);
+		iter->second.iRefs++;
+		iter->second.uLastUse = ++uUseClock;
+		return true;
+	}
+
+	//starts with one reference, fnFree is called on eviction
+	template<typename T>
+	void insert(const std::string& strKey, T value, size_t iBytes, std::function<void(T&)> fnFree)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mtxResources);
+		auto iter = mapResources.find(strKey);
+		if (iter != mapResources.end())
+		{
+			//normally a stale entry nobody holds anymore, a referenced one is dropped without freeing it
+			if (iter->second.iRefs == 0)
+				evict(iter);
+			else
+			{
+				spdlog::warn("Replacing referenced resource, the old one leaks : " + strKey);
+				iResidentBytes -= iter->second.iBytes;
+				mapResources.erase(iter);
+			}
+		}
+		Resource& resource = mapResources[strKey];
+		resource.value = value;
+		resource.fnFree = [value, fnFree]() mutable { fnFree(value); };
+		resource.iBytes = iBytes;
+		resource.iRefs = 1;
+		resource.uLastUse = ++uUseClock;
+		iResidentBytes += iBytes;
+	}
+
+	void release(const std::string& strKey);
+
+	//the source changed on disk, acquire misses from now on and it is freed once unreferenced
+	void invalidate(const std::string& strKey);
+
+	//evict unreferenced resources, least recently used first, until back under budget
+	void trim();
+
+	size_t getResidentBytes();
+	size_t getBudgetBytes() const { return iBudgetBytes; }
+
+private:
+	struct Resource
+	{
+		std::any value;
+		std::function<void()> fnFree;
+		size_t iBytes;
+		int iRefs;
+		uint64_t uLastUse;
+		bool bStale;
+		Resource() : iBytes(0), iRefs(0), uLastUse(0), bStale(false) {}
+	};
+
+	void evict(std::map<std::string, Resource>::iterator iter);
+
+	//recursive since freeing a resource may release the ones it references
+	std::recursive_mutex mtxResources;
+	std::map<std::string, Resource> mapResources;
+	size_t iBudgetBytes;
+	size_t iResidentBytes;
+	uint64_t uUseClock;
+};
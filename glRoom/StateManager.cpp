@@ -1,9 +1,13 @@
  #include "StateManager.h"
 #include "states/MainMenuState.h"
 #include "states/PlayState.h"
+#include "FrameTracer.h"
+#include "JobSystem.h"
+#include "systems/TextureArrays.h"
 
 #include <spdlog/spdlog.h>
 #include <SDL_mixer.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -19,17 +23,32 @@ void StateManager::run()
 {
 	init();
 
-	//init main menu
-	stkStates.push(std::make_unique<MainMenuState>(appSettings, smQueue, mWindow));
+	//a replay skips the menu, quitting once the log is played back
+	if (!appSettings->strInputReplay.empty())
+		stkStates.push(std::make_unique<PlayState>(appSettings, smQueue, resourceManager));
+	else
+		stkStates.push(std::make_unique<MainMenuState>(appSettings, smQueue, mWindow, resourceManager, sceneLoadTask));
 
 	while (!stkStates.empty())
 	{
 		stkStates.top()->run(mWindow);
 		processQueue();
+
+		//whatever the popped state released is evicted once the budget is exceeded
+		resourceManager->trim();
 	}
 
+	//an unfinished load still holds gl textures, free them while the context is alive
+	sceneLoadTask.reset();
+	delete resourceManager;
+	TextureArrays::shutdown();
+
 	//write to ini file
 	writeINIFile();
+
+	//dump whatever the tracer caught before quitting
+	if (FrameTracer::get().hasEvents())
+		FrameTracer::get().exportJSON("glRoom_trace.json");
 }
 
 void StateManager::processQueue()
@@ -43,11 +62,11 @@ void StateManager::processQueue()
 			break;
 
 		case SMMessage::PUSH_MAINMENU_STATE:
-			stkStates.push(std::make_unique<MainMenuState>(appSettings, smQueue, mWindow));
+			stkStates.push(std::make_unique<MainMenuState>(appSettings, smQueue, mWindow, resourceManager, sceneLoadTask));
 			break;
 
 		case SMMessage::PUSH_PLAY_STATE:
-			stkStates.push(std::make_unique<PlayState>(appSettings, smQueue));
+			stkStates.push(std::make_unique<PlayState>(appSettings, smQueue, resourceManager, std::move(sceneLoadTask)));
 			break;
 
 		case SMMessage::QUIT:
@@ -67,6 +86,21 @@ void StateManager::init()
 {
 	initAppSettings();
 
+	//start recording right away, useful to catch hitches during loading
+	FrameTracer::get().registerMainThread();
+	if (SDL_getenv("GLROOM_TRACE") != nullptr)
+		FrameTracer::get().setEnabled(true);
+
+	//the job system treats whichever thread creates it as the main (gl) thread
+	JobSystem::get();
+
+	//input record / replay for repeatable perf runs
+	if (const char* szPath = SDL_getenv("GLROOM_RECORD"))
+		appSettings->strInputRecord = szPath;
+	if (const char* szPath = SDL_getenv("GLROOM_REPLAY"))
+		appSettings->strInputReplay = szPath;
+	appSettings->bReplayUncapped = !appSettings->strInputReplay.empty() && SDL_getenv("GLROOM_REPLAY_UNCAPPED") != nullptr;
+
 	//sdl glew
 	SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
 	if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
@@ -87,12 +121,18 @@ void StateManager::init()
 
 	glewExperimental = true;
 	glewInit();
+
+	//mesa software rasterizers and most integrated gpus have no bindless textures, GLROOM_TEXTURE_ARRAYS forces the fallback
+	TextureArrays::init(SDL_getenv("GLROOM_TEXTURE_ARRAYS") != nullptr);
 	//vsync
-	if (SDL_GL_SetSwapInterval(1) > 0)
+	if (SDL_GL_SetSwapInterval(appSettings->bReplayUncapped ? 0 : 1) > 0)
 		spdlog::warn("vsync disabled");
 
 	//state message queue
 	smQueue = new SMQueue();
+
+	//needs the gl context, everything it holds is freed before the context goes away
+	resourceManager = new ResourceManager(static_cast<size_t>(appSettings->iResourceBudgetMB) * 1024 * 1024);
 }
 
 void StateManager::initAppSettings()
@@ -108,6 +148,24 @@ void StateManager::initAppSettings()
 		appSettings->fWindowSize = std::stof(str);
 		std::getline(fileINI, str);
 		appSettings->strAssetSrc = str;
+
+		//physics timestep settings, older ini files dont have them so keep the defaults
+		if (std::getline(fileINI, str) && !str.empty())
+			appSettings->fFixedTimeStep = std::stof(str);
+		if (std::getline(fileINI, str) && !str.empty())
+			appSettings->iMaxSubSteps = std::stoi(str);
+		if (std::getline(fileINI, str) && !str.empty())
+			appSettings->bInterpolateTransforms = std::stoi(str) != 0;
+		if (std::getline(fileINI, str) && !str.empty())
+			appSettings->iPhysicsThreads = std::stoi(str);
+		if (std::getline(fileINI, str) && !str.empty())
+			appSettings->iResourceBudgetMB = std::stoi(str);
+		if (std::getline(fileINI, str) && !str.empty())
+			appSettings->iFrameLatency = std::clamp(std::stoi(str), 0, 1);
+		if (std::getline(fileINI, str) && !str.empty())
+			appSettings->bGPUPicking = std::stoi(str) != 0;
+		if (std::getline(fileINI, str) && !str.empty())
+			appSettings->bAxisSweepBroadphase = std::stoi(str) != 0;
 		fileINI.close();
 
 		//should have / at the end
@@ -132,7 +190,15 @@ void StateManager::writeINIFile()
 	if (fileINI != nullptr)
 	{
 		fprintf(fileINI, "%f\n", appSettings->fWindowSize);
-		fprintf(fileINI, "%s", appSettings->strAssetSrc);
+		fprintf(fileINI, "%s\n", appSettings->strAssetSrc.c_str());
+		fprintf(fileINI, "%f\n", appSettings->fFixedTimeStep);
+		fprintf(fileINI, "%d\n", appSettings->iMaxSubSteps);
+		fprintf(fileINI, "%d\n", appSettings->bInterpolateTransforms ? 1 : 0);
+		fprintf(fileINI, "%d\n", appSettings->iPhysicsThreads);
+		fprintf(fileINI, "%d\n", appSettings->iResourceBudgetMB);
+		fprintf(fileINI, "%d\n", appSettings->iFrameLatency);
+		fprintf(fileINI, "%d\n", appSettings->bGPUPicking ? 1 : 0);
+		fprintf(fileINI, "%d", appSettings->bAxisSweepBroadphase ? 1 : 0);
 		fclose(fileINI);
 	}
 }
@@ -1,5 +1,7 @@
 #pragma once
 #include "states/State.h"
+#include "systems/SceneLoadTask.h"
+#include "ResourceManager.h"
 
 #include <GL/glew.h>
 #include <SDL.h>
@@ -23,4 +25,6 @@ private:
 	std::stack<std::unique_ptr<State>> stkStates;
 	SMQueue* smQueue;
 	AppSettings* appSettings;
+	std::unique_ptr<SceneLoadTask> sceneLoadTask;								//level being loaded while the menu runs
+	ResourceManager* resourceManager;											//scene data, gl objects and shapes kept between play sessions
 };
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "SystemScheduler.h"
+#include "FrameTracer.h"
+
+#include <algorithm>
+
+static bool containsAny(const std::vector<std::type_index>& vcA, const std::vector<std::type_index>& vcB)
+{
+	for (auto& type : vcA)
+	{
+		if (std::find(vcB.begin(), vcB.end(), type) != vcB.end())
+			return true;
+	}
+	return false;
+}
+
+bool SystemAccess::conflicts(const SystemAccess& other) const
+{
+	//reads never conflict with reads
+	return containsAny(vcWrites, other.vcWrites) || containsAny(vcWrites, other.vcReads) || containsAny(vcReads, other.vcWrites);
+}
+
+SystemScheduler::SystemScheduler(JobSystem* jobSystem) :
+	jobSystem(jobSystem),
+	bGraphDirty(true)
+{
+}
+
+void SystemScheduler::addSystem(const char* szName, const SystemAccess& access, bool bMainThread, std::function<void(float)> fnUpdate)
+{
+	SystemNode node;
+	node.szName = szName;
+	node.access = access;
+	node.bMainThread = bMainThread;
+	node.fnUpdate = std::move(fnUpdate);
+	node.iDependencies = 0;
+	node.iPending = 0;
+	vcNodes.emplace_back(std::move(node));
+	bGraphDirty = true;
+}
+
+void SystemScheduler::buildGraph()
+{
+	//an edge from every earlier system a later one conflicts with, so conflicting systems run in registration order
+	for (auto& node : vcNodes)
+	{
+		node.vcDependents.clear();
+		node.iDependencies = 0;
+	}
+	for (size_t j = 0; j < vcNodes.size(); j++)
+	{
+		for (size_t i = 0; i < j; i++)
+		{
+			if (vcNodes[i].access.conflicts(vcNodes[j].access))
+			{
+				vcNodes[i].vcDependents.emplace_back(j);
+				vcNodes[j].iDependencies++;
+			}
+		}
+	}
+	bGraphDirty = false;
+}
+
+void SystemScheduler::run(float fDeltaTime)
+{
+	if (bGraphDirty)
+		buildGraph();
+
+	for (auto& node : vcNodes)
+		node.iPending = node.iDependencies;
+	for (size_t i = 0; i < vcNodes.size(); i++)
+	{
+		if (vcNodes[i].iDependencies == 0)
+			dispatch(i, fDeltaTime);
+	}
+
+	//the main thread runs its pinned systems as they become ready and helps the workers otherwise
+	//dependents are dispatched before the finishing system's job counts as done, so the counter only drops to 0 at the end
+	jobSystem->wait(frameCounter);
+}
+
+void SystemScheduler::dispatch(size_t iNode, float fDeltaTime)
+{
+	auto fnJob = [this, iNode, fDeltaTime]()
+		{
+			{
+				TRACE_SCOPE(vcNodes[iNode].szName);
+				vcNodes[iNode].fnUpdate(fDeltaTime);
+			}
+			onFinished(iNode, fDeltaTime);
+		};
+	if (vcNodes[iNode].bMainThread)
+		jobSystem->runOnMain(frameCounter, std::move(fnJob));
+	else
+		jobSystem->run(frameCounter, std::move(fnJob));
+}
+
+void SystemScheduler::onFinished(size_t iNode, float fDeltaTime)
+{
+	std::vector<size_t> vcReady;
+	{
+		std::lock_guard<std::mutex> lock(mtxFrame);
+		for (size_t iDependent : vcNodes[iNode].vcDependents)
+		{
+			if (--vcNodes[iDependent].iPending == 0)
+				vcReady.emplace_back(iDependent);
+		}
+	}
+	for (size_t iReady : vcReady)
+		dispatch(iReady, fDeltaTime);
+}
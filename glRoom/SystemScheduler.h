@@ -0,0 +1,69 @@
+//runs the per frame systems of a state as a dependency graph instead of a fixed sequence
+//every system declares the components, SC* singletons and shared objects it reads and writes
+//two systems conflict if one writes something the other touches, conflicting systems keep their registration order
+//everything else may overlap, systems touching gl are pinned to the calling (main) thread
+//systems must not create / destroy entities or add / remove components while the graph runs
+#pragma once
+#include "JobSystem.h"
+
+#include <functional>
+#include <mutex>
+#include <typeindex>
+#include <vector>
+
+struct SystemAccess
+{
+	std::vector<std::type_index> vcReads;
+	std::vector<std::type_index> vcWrites;
+
+	template<typename... T>
+	SystemAccess& reads()
+	{
+		(vcReads.emplace_back(typeid(T)), ...);
+		return *this;
+	}
+
+	template<typename... T>
+	SystemAccess& writes()
+	{
+		(vcWrites.emplace_back(typeid(T)), ...);
+		return *this;
+	}
+
+	bool conflicts(const SystemAccess& other) const;
+};
+
+class SystemScheduler
+{
+public:
+	SystemScheduler(JobSystem* jobSystem);
+
+	//szName must be a string literal, it names the system's trace event
+	void addSystem(const char* szName, const SystemAccess& access, bool bMainThread, std::function<void(float)> fnUpdate);
+
+	//blocks until every system ran once
+	void run(float fDeltaTime);
+
+private:
+	struct SystemNode
+	{
+		const char* szName;
+		SystemAccess access;
+		bool bMainThread;
+		std::function<void(float)> fnUpdate;
+		std::vector<size_t> vcDependents;										//systems waiting on this one
+		size_t iDependencies;
+		size_t iPending;														//dependencies not finished this frame
+	};
+
+	void buildGraph();
+	void dispatch(size_t iNode, float fDeltaTime);
+	void onFinished(size_t iNode, float fDeltaTime);
+
+	std::vector<SystemNode> vcNodes;
+	JobSystem* jobSystem;
+	bool bGraphDirty;
+
+	std::mutex mtxFrame;
+	JobCounter frameCounter;													//every system dispatched this frame
+};
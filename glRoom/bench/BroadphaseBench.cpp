@@ -0,0 +1,247 @@
+//headless broadphase benchmark, no window or gl context
+//builds generated rooms of about 1k, 10k and 100k bodies and measures only the pair finding, no narrowphase or solver
+//every frame a scripted share of the dynamic bodies moves a little, the rest sleep like a settled room does,
+//then the aabbs are updated and the overlapping pairs recomputed
+//  dbvt all : dbvt refreshing every aabb every step, how the world used to be set up
+//  dbvt     : dbvt with the static tree built once after the load, only awake bodies are refreshed
+//  sweep    : sweep and prune bounded by the level
+//usage : glRoomBroadphaseBench [--bodies n] [--frames n] [--moving percent]
+#include "../systems/PhysicsWorld.h"
+#include "../systems/LevelFile.h"
+#include "../systems/RigidBodySpec.h"
+
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletDynamics/Dynamics/btRigidBody.h>
+#include <LinearMath/btDefaultMotionState.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+struct BroadphaseConfig
+{
+	const char* szName;
+	BroadphaseType broadphaseType;
+	bool bUpdateAllAabbs;
+};
+
+struct BenchScene
+{
+	std::vector<btRigidBody*> vcBodies;
+	std::vector<btRigidBody*> vcMovingBodies;
+	std::vector<btVector3> vcMovingOrigins;
+	std::vector<btCollisionShape*> vcShapes;
+	std::map<std::string, btCollisionShape*> mapTypeShapes;					//one per type, only the aabbs matter here
+};
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//same mix as the default generated room, 2 shelves of 24 books and 2 boards each per pile of 10 mugs
+static LevelGenParams scaledLevel(int iBodies)
+{
+	LevelGenParams params;
+	params.iBookShelves = std::max(1, iBodies / 31);
+	params.iMugPiles = std::max(1, params.iBookShelves / 2);
+	return params;
+}
+
+static BenchScene buildScene(PhysicsWorld& physicsWorld, const std::vector<LevelEntity>& vcEntities, int iMovingPercent)
+{
+	BenchScene scene;
+	CollisionShapeBuilder shapeBuilder("./assets/");
+	btDiscreteDynamicsWorld* dynamicsWorld = physicsWorld.getDynamicsWorld();
+	const int iMoveEvery = iMovingPercent > 0 ? std::max(1, 100 / iMovingPercent) : 0;
+	int iDynamic = 0;
+
+	for (const auto& entity : vcEntities)
+	{
+		btCollisionShape* shape = nullptr;
+		btTransform transBody;
+		btScalar fMass = 0.f;
+		if (entity.strEntityType == "wall")
+		{
+			shape = new btBoxShape(entity.vDimensions);
+			scene.vcShapes.emplace_back(shape);
+			transBody.setIdentity();
+			transBody.setOrigin(entity.vOrigin);
+		}
+		else
+		{
+			const RigidBodySpec* spec = findRigidBodySpec(entity.strEntityType);
+			if (spec == nullptr)
+				continue;
+			//generated rooms only hold primitive shapes, nothing is read from the assets
+			btCollisionShape*& typeShape = scene.mapTypeShapes[entity.strEntityType];
+			if (typeShape == nullptr)
+			{
+				TriangleMeshData meshData;
+				typeShape = shapeBuilder.createShape(*spec, meshData);
+				scene.vcShapes.emplace_back(typeShape);
+			}
+			shape = typeShape;
+			fMass = spec->fMass;
+			transBody = createSpawnTransform(*spec, entity.vOrigin, entity.fYaw);
+		}
+
+		btVector3 vLocalInertia(0.f, 0.f, 0.f);
+		if (fMass > 0.f)
+			shape->calculateLocalInertia(fMass, vLocalInertia);
+		btRigidBody::btRigidBodyConstructionInfo info(fMass, new btDefaultMotionState(transBody), shape, vLocalInertia);
+		btRigidBody* rigidBody = new btRigidBody(info);
+		const int iGroup = entity.strEntityType == "wall" ? ciGroupWall : fMass > 0.f ? ciGroupDynamic : ciGroupStatic;
+		dynamicsWorld->addRigidBody(rigidBody, iGroup, getCollisionMask(iGroup));
+		scene.vcBodies.emplace_back(rigidBody);
+
+		if (fMass <= 0.f)
+			continue;
+
+		//a settled room, only the scripted ones stay awake
+		if (iMoveEvery > 0 && iDynamic++ % iMoveEvery == 0)
+		{
+			rigidBody->setActivationState(DISABLE_DEACTIVATION);
+			scene.vcMovingBodies.emplace_back(rigidBody);
+			scene.vcMovingOrigins.emplace_back(transBody.getOrigin());
+		}
+		else
+			rigidBody->setActivationState(ISLAND_SLEEPING);
+	}
+	return scene;
+}
+
+static void destroyScene(PhysicsWorld& physicsWorld, BenchScene& scene)
+{
+	for (auto rigidBody : scene.vcBodies)
+	{
+		physicsWorld.getDynamicsWorld()->removeRigidBody(rigidBody);
+		delete rigidBody->getMotionState();
+		delete rigidBody;
+	}
+	for (auto shape : scene.vcShapes)
+		delete shape;
+}
+
+//small circles around the spawn point, far enough to change neighbours in a packed shelf
+static void moveBodies(BenchScene& scene, int iFrame)
+{
+	for (size_t i = 0; i < scene.vcMovingBodies.size(); i++)
+	{
+		const float fAngle = iFrame * 0.05f + i * 0.7f;
+		btTransform transBody = scene.vcMovingBodies[i]->getWorldTransform();
+		transBody.setOrigin(scene.vcMovingOrigins[i] + btVector3(std::cos(fAngle), 0.f, std::sin(fAngle)) * 0.6f);
+		scene.vcMovingBodies[i]->setWorldTransform(transBody);
+	}
+}
+
+static double percentile(std::vector<double> vcValues, double fPercentile)
+{
+	std::sort(vcValues.begin(), vcValues.end());
+	const size_t index = std::min(vcValues.size() - 1, static_cast<size_t>(fPercentile * (vcValues.size() - 1) + 0.5));
+	return vcValues[index];
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<int> vcBodyCounts;
+	int iFrames = 300;
+	int iMovingPercent = 5;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--bodies") == 0 && i + 1 < argc)
+			vcBodyCounts.emplace_back(std::max(1, std::atoi(argv[++i])));
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			iFrames = std::max(1, std::atoi(argv[++i]));
+		else if (strcmp(argv[i], "--moving") == 0 && i + 1 < argc)
+			iMovingPercent = std::clamp(std::atoi(argv[++i]), 0, 100);
+		else
+		{
+			spdlog::error(std::string("Unknown argument : ") + argv[i]);
+			return 1;
+		}
+	}
+	if (vcBodyCounts.empty())
+		vcBodyCounts = { 1000, 10000, 100000 };
+
+	const BroadphaseConfig configs[] =
+	{
+		{ "dbvt all", BroadphaseType::DBVT, true },
+		{ "dbvt", BroadphaseType::DBVT, false },
+		{ "sweep", BroadphaseType::AXIS_SWEEP, false }
+	};
+	const int iWarmupFrames = 10;														//the first pass finds every pair from scratch
+
+	printf("%d frames, %d%% of dynamic bodies moving\n", iFrames, iMovingPercent);
+	printf("%8s %8s %8s %10s %10s %10s %10s %10s %10s %10s\n",
+		"bodies", "moving", "config", "build ms", "optim ms", "mean ms", "p50 ms", "p95 ms", "max ms", "pairs");
+
+	for (int iBodies : vcBodyCounts)
+	{
+		const std::vector<LevelEntity> vcEntities = generateLevel(scaledLevel(iBodies));
+		btVector3 vWorldMin, vWorldMax;
+		getLevelBounds(vcEntities, vWorldMin, vWorldMax);
+		if (vcEntities.size() > PhysicsWorld::ciMaxSweepHandles)
+			spdlog::warn(std::to_string(vcEntities.size()) + " bodies are more than the sweep and prune broadphase holds");
+
+		for (const BroadphaseConfig& config : configs)
+		{
+			if (config.broadphaseType == BroadphaseType::AXIS_SWEEP && vcEntities.size() > PhysicsWorld::ciMaxSweepHandles)
+				continue;
+
+			PhysicsWorld physicsWorld(1, config.broadphaseType, vWorldMin, vWorldMax);
+			btDiscreteDynamicsWorld* dynamicsWorld = physicsWorld.getDynamicsWorld();
+			dynamicsWorld->setForceUpdateAllAabbs(config.bUpdateAllAabbs);
+
+			auto start = std::chrono::steady_clock::now();
+			BenchScene scene = buildScene(physicsWorld, vcEntities, iMovingPercent);
+			const double fBuildMs = elapsedMs(start);
+
+			double fOptimizeMs = 0.0;
+			if (!config.bUpdateAllAabbs)
+			{
+				start = std::chrono::steady_clock::now();
+				physicsWorld.optimizeBroadphase();
+				fOptimizeMs = elapsedMs(start);
+			}
+
+			std::vector<double> vcFrameMs;
+			vcFrameMs.reserve(iFrames);
+			for (int frame = 0; frame < iWarmupFrames + iFrames; frame++)
+			{
+				moveBodies(scene, frame);
+
+				start = std::chrono::steady_clock::now();
+				dynamicsWorld->updateAabbs();
+				dynamicsWorld->computeOverlappingPairs();
+				if (frame >= iWarmupFrames)
+					vcFrameMs.emplace_back(elapsedMs(start));
+			}
+
+			double fSum = 0.0;
+			for (double fMs : vcFrameMs)
+				fSum += fMs;
+			printf("%8zu %8zu %8s %10.2f %10.2f %10.3f %10.3f %10.3f %10.3f %10d\n",
+				scene.vcBodies.size(),
+				scene.vcMovingBodies.size(),
+				config.szName,
+				fBuildMs,
+				fOptimizeMs,
+				fSum / vcFrameMs.size(),
+				percentile(vcFrameMs, 0.5),
+				percentile(vcFrameMs, 0.95),
+				percentile(vcFrameMs, 1.0),
+				dynamicsWorld->getBroadphase()->getOverlappingPairCache()->getNumOverlappingPairs());
+
+			destroyScene(physicsWorld, scene);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+//JobSystem micro benchmark, no window or gl context
+//measures what a job costs to spawn and wait for, and how much gets stolen, against the thread count
+//  spawn    : the main thread posts n empty jobs to one counter and waits
+//  forkjoin : binary tree of jobs, every job spawns two children and waits for them
+//  parallel : parallelFor over an array with a small grain size
+//usage : glRoomJobBench [--jobs n] [--depth n] [--grain n] [--threads n]
+#include "../JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static double elapsedNs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void forkJoin(JobSystem& jobSystem, int iDepth, std::atomic<int>& iLeaves)
+{
+	if (iDepth == 0)
+	{
+		iLeaves.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	JobCounter counter;
+	jobSystem.run(counter, [&jobSystem, iDepth, &iLeaves]() { forkJoin(jobSystem, iDepth - 1, iLeaves); });
+	jobSystem.run(counter, [&jobSystem, iDepth, &iLeaves]() { forkJoin(jobSystem, iDepth - 1, iLeaves); });
+	jobSystem.wait(counter);
+}
+
+int main(int argc, char** argv)
+{
+	int iJobs = 100000;
+	int iDepth = 16;
+	int iGrain = 64;
+	int iFixedThreads = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+			iJobs = std::max(1, std::atoi(argv[++i]));
+		else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc)
+			iDepth = std::max(1, std::atoi(argv[++i]));
+		else if (strcmp(argv[i], "--grain") == 0 && i + 1 < argc)
+			iGrain = std::max(1, std::atoi(argv[++i]));
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			iFixedThreads = std::max(1, std::atoi(argv[++i]));
+		else
+		{
+			fprintf(stderr, "Unknown argument : %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::vector<int> vcThreadCounts;
+	if (iFixedThreads > 0)
+		vcThreadCounts.emplace_back(iFixedThreads);
+	else
+	{
+		const int iMaxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+		for (int i = 1; i < iMaxThreads; i *= 2)
+			vcThreadCounts.emplace_back(i);
+		vcThreadCounts.emplace_back(iMaxThreads);
+	}
+
+	std::vector<float> vcData(1 << 20, 1.f);
+	printf("%d spawned jobs, fork join depth %d, parallelFor over %zu floats with grain %d\n", iJobs, iDepth, vcData.size(), iGrain);
+	printf("%8s %12s %12s %12s %12s %12s %12s\n",
+		"threads", "spawn ns", "spawn steal", "fork ns", "fork steal", "pfor ns", "pfor steal");
+
+	for (int iThreads : vcThreadCounts)
+	{
+		JobSystem jobSystem(static_cast<unsigned int>(iThreads));
+
+		//spawn, ns per job including the wait
+		JobStats statsBefore = jobSystem.getStats();
+		auto start = std::chrono::steady_clock::now();
+		{
+			JobCounter counter;
+			for (int i = 0; i < iJobs; i++)
+				jobSystem.run(counter, []() {});
+			jobSystem.wait(counter);
+		}
+		const double fSpawnNs = elapsedNs(start) / iJobs;
+		JobStats statsSpawn = jobSystem.getStats();
+
+		//fork join, ns per job
+		std::atomic<int> iLeaves(0);
+		start = std::chrono::steady_clock::now();
+		forkJoin(jobSystem, iDepth, iLeaves);
+		const double fForkNs = elapsedNs(start) / ((2 << iDepth) - 2);
+		JobStats statsFork = jobSystem.getStats();
+
+		//parallelFor, ns per element
+		start = std::chrono::steady_clock::now();
+		jobSystem.parallelFor(0, static_cast<int>(vcData.size()), iGrain,
+			[&vcData](int iBegin, int iEnd)
+			{
+				for (int i = iBegin; i < iEnd; i++)
+					vcData[i] = vcData[i] * 0.5f + 1.f;
+			});
+		const double fForNs = elapsedNs(start) / vcData.size();
+		JobStats statsFor = jobSystem.getStats();
+
+		if (iLeaves.load() != (1 << iDepth))
+			fprintf(stderr, "fork join lost jobs : %d of %d leaves ran\n", iLeaves.load(), 1 << iDepth);
+
+		printf("%8d %12.1f %12llu %12.1f %12llu %12.3f %12llu\n",
+			jobSystem.getNumThreads(),
+			fSpawnNs,
+			static_cast<unsigned long long>(statsSpawn.uSteals - statsBefore.uSteals),
+			fForkNs,
+			static_cast<unsigned long long>(statsFork.uSteals - statsSpawn.uSteals),
+			fForNs,
+			static_cast<unsigned long long>(statsFor.uSteals - statsFork.uSteals));
+	}
+
+	return 0;
+}
@@ -0,0 +1,287 @@
+//headless physics benchmark, no window or gl context
+//builds the collision world from a level file or a generated room, knocks it over with scripted impulses
+//and measures step time, broadphase pairs and contact manifolds against the physics thread count
+//--runs n restores a physics snapshot between runs instead of rebuilding, and checks every run ends where the first did,
+//         both broadphases get that check since each keeps its pairs across a restore in its own way
+//--sweep only uses the sweep and prune broadphase bounded by the level instead of dbvt
+//usage : glRoomPhysicsBench [--level assetSrc levelFile] [--gen bookShelves booksPerShelf mugPiles mugsPerPile]
+//                           [--steps n] [--threads n] [--runs n] [--sweep]
+#include "../systems/PhysicsWorld.h"
+#include "../systems/LevelFile.h"
+#include "../systems/RigidBodySpec.h"
+
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletDynamics/Dynamics/btRigidBody.h>
+#include <LinearMath/btDefaultMotionState.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct BenchScene
+{
+	std::vector<btRigidBody*> vcBodies;
+	std::vector<btRigidBody*> vcDynamicBodies;
+	std::vector<btCollisionShape*> vcShapes;
+	std::vector<TriangleMeshData> vcMeshData;
+};
+
+static void addBody(PhysicsWorld& physicsWorld, BenchScene& scene, btCollisionShape* shape, const btTransform& transBody, btScalar fMass, btScalar fFriction, int iGroup)
+{
+	btVector3 vLocalInertia(0.f, 0.f, 0.f);
+	if (fMass > 0.f)
+		shape->calculateLocalInertia(fMass, vLocalInertia);
+	btRigidBody::btRigidBodyConstructionInfo info(fMass, new btDefaultMotionState(transBody), shape, vLocalInertia);
+	btRigidBody* rigidBody = new btRigidBody(info);
+	rigidBody->setFriction(fFriction);
+
+	//same as GeometryLoader, everything starts asleep until something hits it and only pairs the game would get are counted
+	rigidBody->setActivationState(0);
+	physicsWorld.getDynamicsWorld()->addRigidBody(rigidBody, iGroup, getCollisionMask(iGroup));
+
+	scene.vcShapes.emplace_back(shape);
+	scene.vcBodies.emplace_back(rigidBody);
+	if (fMass > 0.f)
+		scene.vcDynamicBodies.emplace_back(rigidBody);
+}
+
+static BenchScene buildScene(PhysicsWorld& physicsWorld, CollisionShapeBuilder& shapeBuilder, const std::vector<LevelEntity>& vcEntities)
+{
+	BenchScene scene;
+	for (const auto& entity : vcEntities)
+	{
+		if (entity.strEntityType == "wall")
+		{
+			btTransform transWall;
+			transWall.setIdentity();
+			transWall.setOrigin(entity.vOrigin);
+			addBody(physicsWorld, scene, new btBoxShape(entity.vDimensions), transWall, 0.f, .5f, ciGroupWall);
+			continue;
+		}
+
+		//the room entry is render only
+		const RigidBodySpec* spec = findRigidBodySpec(entity.strEntityType);
+		if (spec == nullptr)
+			continue;
+
+		TriangleMeshData meshData;
+		btCollisionShape* shape = shapeBuilder.createShape(*spec, meshData);
+		if (meshData.meshInterface != nullptr)
+			scene.vcMeshData.emplace_back(meshData);
+		addBody(physicsWorld, scene, shape, createSpawnTransform(*spec, entity.vOrigin, entity.fYaw), spec->fMass, spec->fFriction, spec->fMass > 0.f ? ciGroupDynamic : ciGroupStatic);
+	}
+	return scene;
+}
+
+static void destroyScene(PhysicsWorld& physicsWorld, BenchScene& scene)
+{
+	for (auto rigidBody : scene.vcBodies)
+	{
+		physicsWorld.getDynamicsWorld()->removeRigidBody(rigidBody);
+		delete rigidBody->getMotionState();
+		delete rigidBody;
+	}
+	for (auto shape : scene.vcShapes)
+		delete shape;
+	for (auto& meshData : scene.vcMeshData)
+		freeTriangleMeshData(meshData);
+}
+
+//every 7th dynamic body gets pushed away from the room centre, same bodies and same impulses every run
+static void applyScriptedImpulses(BenchScene& scene)
+{
+	for (size_t i = 0; i < scene.vcDynamicBodies.size(); i += 7)
+	{
+		btRigidBody* rigidBody = scene.vcDynamicBodies[i];
+		btVector3 vDir = rigidBody->getCenterOfMassPosition();
+		vDir.setY(0.f);
+		vDir = vDir.fuzzyZero() ? btVector3(1.f, 0.f, 0.f) : vDir.normalized();
+		rigidBody->activate(true);
+		rigidBody->applyCentralImpulse((vDir * 4.f + btVector3(0.f, 2.f, 0.f)) / rigidBody->getInvMass());
+	}
+}
+
+//bit pattern of every dynamic body's position, equal only if two runs ended exactly the same
+static uint64_t hashPositions(const BenchScene& scene)
+{
+	uint64_t uHash = 14695981039346656037ull;
+	for (btRigidBody* rigidBody : scene.vcDynamicBodies)
+	{
+		const btVector3& vPos = rigidBody->getCenterOfMassPosition();
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vPos);
+		for (size_t i = 0; i < sizeof(btScalar) * 3; i++)
+			uHash = (uHash ^ bytes[i]) * 1099511628211ull;
+	}
+	return uHash;
+}
+
+static double percentile(std::vector<double> vcValues, double fPercentile)
+{
+	std::sort(vcValues.begin(), vcValues.end());
+	const size_t index = std::min(vcValues.size() - 1, static_cast<size_t>(fPercentile * (vcValues.size() - 1) + 0.5));
+	return vcValues[index];
+}
+
+int main(int argc, char** argv)
+{
+	std::string strAssetSrc = "./assets/";
+	std::string strLevelFile;
+	LevelGenParams genParams;
+	int iSteps = 600;
+	int iFixedThreads = 0;
+	int iRuns = 1;
+	bool bSweepOnly = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--level") == 0 && i + 2 < argc)
+		{
+			strAssetSrc = argv[++i];
+			strLevelFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--gen") == 0 && i + 4 < argc)
+		{
+			genParams.iBookShelves = std::atoi(argv[++i]);
+			genParams.iBooksPerShelf = std::atoi(argv[++i]);
+			genParams.iMugPiles = std::atoi(argv[++i]);
+			genParams.iMugsPerPile = std::atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+			iSteps = std::max(1, std::atoi(argv[++i]));
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			iFixedThreads = std::max(1, std::atoi(argv[++i]));
+		else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+			iRuns = std::max(1, std::atoi(argv[++i]));
+		else if (strcmp(argv[i], "--sweep") == 0)
+			bSweepOnly = true;
+		else
+		{
+			spdlog::error(std::string("Unknown argument : ") + argv[i]);
+			return 1;
+		}
+	}
+
+	std::vector<LevelEntity> vcEntities;
+	if (strLevelFile.empty())
+		vcEntities = generateLevel(genParams);
+	else if (!loadLevelFile(strAssetSrc + strLevelFile, vcEntities))
+		return 1;
+
+	std::vector<int> vcThreadCounts;
+	if (iFixedThreads > 0)
+		vcThreadCounts.emplace_back(iFixedThreads);
+	else
+	{
+		const int iMaxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+		for (int i = 1; i < iMaxThreads; i *= 2)
+			vcThreadCounts.emplace_back(i);
+		vcThreadCounts.emplace_back(iMaxThreads);
+	}
+
+	const float fFixedTimeStep = 1.f / 60.f;
+	const int iKnockStep = 30;															//let stacks settle for half a second first
+	const int iKnockInterval = 120;
+	CollisionShapeBuilder shapeBuilder(strAssetSrc);
+	btVector3 vWorldMin, vWorldMax;
+	getLevelBounds(vcEntities, vWorldMin, vWorldMax);
+
+	std::vector<BroadphaseType> vcBroadphaseTypes;
+	if (!bSweepOnly)
+		vcBroadphaseTypes.emplace_back(BroadphaseType::DBVT);
+	if (bSweepOnly || iRuns > 1)
+	{
+		if (vcEntities.size() > PhysicsWorld::ciMaxSweepHandles)
+			spdlog::warn(std::to_string(vcEntities.size()) + " bodies are more than the sweep and prune broadphase holds");
+		else
+			vcBroadphaseTypes.emplace_back(BroadphaseType::AXIS_SWEEP);
+	}
+	if (vcBroadphaseTypes.empty())
+		return 1;
+
+	printf("scene : %s, %d steps, %d runs\n", strLevelFile.empty() ? "generated" : (strAssetSrc + strLevelFile).c_str(), iSteps, iRuns);
+	printf("%8s %6s %8s %8s %10s %10s %10s %10s %10s %10s %10s %10s %11s %8s\n",
+		"threads", "broad", "static", "dynamic", "mean ms", "p50 ms", "p95 ms", "p99 ms", "max ms", "pairs avg", "pairs max", "manifolds", "restore us", "repeats");
+
+	for (BroadphaseType broadphaseType : vcBroadphaseTypes)
+	{
+		for (int iThreads : vcThreadCounts)
+		{
+			PhysicsWorld physicsWorld(iThreads, broadphaseType, vWorldMin, vWorldMax);
+			BenchScene scene = buildScene(physicsWorld, shapeBuilder, vcEntities);
+			physicsWorld.optimizeBroadphase();
+			btDiscreteDynamicsWorld* dynamicsWorld = physicsWorld.getDynamicsWorld();
+
+			//every run starts from the state right after building, no reload in between
+			PhysicsSnapshot snapshot;
+			physicsWorld.saveSnapshot(snapshot);
+
+			std::vector<double> vcStepMs;
+			vcStepMs.reserve(static_cast<size_t>(iSteps) * iRuns);
+			double fPairSum = 0.0;
+			int iPairMax = 0;
+			int iManifoldMax = 0;
+			double fRestoreUs = 0.0;
+			uint64_t uFirstHash = 0;
+			bool bRepeats = true;
+			for (int run = 0; run < iRuns; run++)
+			{
+				if (run > 0)
+				{
+					auto start = std::chrono::steady_clock::now();
+					physicsWorld.restoreSnapshot(snapshot);
+					fRestoreUs = std::max(fRestoreUs, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+				}
+
+				for (int step = 0; step < iSteps; step++)
+				{
+					if (step >= iKnockStep && (step - iKnockStep) % iKnockInterval == 0)
+						applyScriptedImpulses(scene);
+
+					auto start = std::chrono::steady_clock::now();
+					dynamicsWorld->stepSimulation(fFixedTimeStep, 0, fFixedTimeStep);
+					vcStepMs.emplace_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+					const int iPairs = dynamicsWorld->getBroadphase()->getOverlappingPairCache()->getNumOverlappingPairs();
+					fPairSum += iPairs;
+					iPairMax = std::max(iPairMax, iPairs);
+					iManifoldMax = std::max(iManifoldMax, dynamicsWorld->getDispatcher()->getNumManifolds());
+				}
+
+				const uint64_t uHash = hashPositions(scene);
+				if (run == 0)
+					uFirstHash = uHash;
+				else
+					bRepeats = bRepeats && uHash == uFirstHash;
+			}
+
+			double fSum = 0.0;
+			for (double fMs : vcStepMs)
+				fSum += fMs;
+			printf("%8d %6s %8zu %8zu %10.3f %10.3f %10.3f %10.3f %10.3f %10.1f %10d %10d %11.1f %8s%s\n",
+				physicsWorld.getNumThreads(),
+				broadphaseType == BroadphaseType::AXIS_SWEEP ? "sweep" : "dbvt",
+				scene.vcBodies.size() - scene.vcDynamicBodies.size(),
+				scene.vcDynamicBodies.size(),
+				fSum / vcStepMs.size(),
+				percentile(vcStepMs, 0.5),
+				percentile(vcStepMs, 0.95),
+				percentile(vcStepMs, 0.99),
+				percentile(vcStepMs, 1.0),
+				fPairSum / vcStepMs.size(),
+				iPairMax,
+				iManifoldMax,
+				fRestoreUs,
+				iRuns == 1 ? "-" : bRepeats ? "exact" : "differ",
+				physicsWorld.isMultithreaded() || iThreads == 1 ? "" : " (single threaded world)");
+
+			destroyScene(physicsWorld, scene);
+		}
+	}
+
+	return 0;
+}
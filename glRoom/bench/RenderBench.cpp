@@ -0,0 +1,328 @@
+//headless render benchmark, no window, renders into an offscreen fbo through a surfaceless egl context
+//runs on mesa's llvmpipe as well (EGL_PLATFORM=surfaceless or LIBGL_ALWAYS_SOFTWARE=1), bindless textures then fall back to texture arrays
+//loads the level the same way PlayState does and renders a scripted orbit through the full hdr / bloom pipeline
+//reports cpu submit, gpu and finished frame times, optionally dumping every nth frame as png
+//usage : glRoomRenderBench [--assets assetSrc] [--level levelFile] [--frames n] [--warmup n] [--size width height]
+//                          [--dump dir every] [--texture-arrays]
+#include "../systems/RenderingSys.h"
+#include "../systems/PhysicsSys.h"
+#include "../systems/GeometryLoader.h"
+#include "../systems/SceneLoadTask.h"
+#include "../systems/TextureArrays.h"
+#include "../ResourceManager.h"
+#include "../JobSystem.h"
+#include "../AppSettings.h"
+
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+#include <spdlog/spdlog.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct BenchContext
+{
+	EGLDisplay display;
+	EGLContext context;
+	EGLSurface surface;
+	BenchContext() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT), surface(EGL_NO_SURFACE) {}
+};
+
+struct BenchTarget
+{
+	GLuint fbo;
+	GLuint texColor;
+};
+
+static bool createContext(BenchContext& ctx)
+{
+	//mesa's surfaceless platform needs neither a display server nor a gpu, the default display is tried otherwise
+	auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (getPlatformDisplay != nullptr)
+		ctx.display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (ctx.display == EGL_NO_DISPLAY)
+		ctx.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint iMajor, iMinor;
+	if (ctx.display == EGL_NO_DISPLAY || !eglInitialize(ctx.display, &iMajor, &iMinor))
+	{
+		spdlog::error("Could not initialize an EGL display");
+		return false;
+	}
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		spdlog::error("EGL display does not support desktop OpenGL");
+		return false;
+	}
+
+	const EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config = nullptr;
+	EGLint iConfigs = 0;
+	eglChooseConfig(ctx.display, configAttribs, &config, 1, &iConfigs);
+
+	//same version and profile StateManager asks SDL for
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 6,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE };
+	ctx.context = eglCreateContext(ctx.display, iConfigs > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+	if (ctx.context == EGL_NO_CONTEXT)
+	{
+		spdlog::error("Could not create an OpenGL 4.6 core context, EGL error " + std::to_string(eglGetError()));
+		return false;
+	}
+
+	//everything is drawn into fbos, a tiny pbuffer only stands in where surfaceless contexts are missing
+	if (eglMakeCurrent(ctx.display, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx.context))
+		return true;
+	if (iConfigs > 0)
+	{
+		const EGLint pbufferAttribs[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+		ctx.surface = eglCreatePbufferSurface(ctx.display, config, pbufferAttribs);
+		if (ctx.surface != EGL_NO_SURFACE && eglMakeCurrent(ctx.display, ctx.surface, ctx.surface, ctx.context))
+			return true;
+	}
+	spdlog::error("Could not make the context current without a surface");
+	return false;
+}
+
+static void destroyContext(BenchContext& ctx)
+{
+	if (ctx.display == EGL_NO_DISPLAY)
+		return;
+	eglMakeCurrent(ctx.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (ctx.surface != EGL_NO_SURFACE)
+		eglDestroySurface(ctx.display, ctx.surface);
+	if (ctx.context != EGL_NO_CONTEXT)
+		eglDestroyContext(ctx.display, ctx.context);
+	eglTerminate(ctx.display);
+}
+
+static BenchTarget createTarget(int iWidth, int iHeight)
+{
+	//stands in for the window's default framebuffer, ldr like the swap chain would be
+	BenchTarget target;
+	glCreateTextures(GL_TEXTURE_2D, 1, &target.texColor);
+	glTextureStorage2D(target.texColor, 1, GL_RGBA8, iWidth, iHeight);
+	glCreateFramebuffers(1, &target.fbo);
+	glNamedFramebufferTexture(target.fbo, GL_COLOR_ATTACHMENT0, target.texColor, 0);
+	if (glCheckNamedFramebufferStatus(target.fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		spdlog::error("Output framebuffer is not complete");
+	return target;
+}
+
+//the scripted camera path, one full orbit around the same target CameraSys looks at while slowly dollying in and out
+static glm::mat4 cameraPath(int iFrame, int iFrames)
+{
+	const float t = static_cast<float>(iFrame) / static_cast<float>(std::max(1, iFrames));
+	const float fYaw = glm::radians(45.f + 360.f * t);
+	const float fPitch = glm::radians(36.f + 10.f * std::sin(glm::two_pi<float>() * t));
+	const float fRadius = 45.f + 15.f * std::sin(glm::two_pi<float>() * 2.f * t);
+	const glm::vec3 vPos(
+		fRadius * std::cos(fPitch) * std::sin(fYaw),
+		fRadius * std::sin(fPitch),
+		fRadius * std::cos(fPitch) * std::cos(fYaw));
+	return glm::lookAt(vPos, glm::vec3(0.f, 5.f, 0.f), glm::vec3(0.f, 1.f, 0.f));
+}
+
+static bool dumpFrame(const BenchTarget& target, int iWidth, int iHeight, const std::string& strDir, int iFrame)
+{
+	std::vector<unsigned char> vcPixels(static_cast<size_t>(iWidth) * iHeight * 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTextureImage(target.texColor, 0, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(vcPixels.size()), vcPixels.data());
+
+	char szName[32];
+	snprintf(szName, sizeof(szName), "frame_%05d.png", iFrame);
+	const std::string strPath = strDir + "/" + szName;
+	stbi_flip_vertically_on_write(1);												//gl rows start at the bottom
+	if (!stbi_write_png(strPath.c_str(), iWidth, iHeight, 4, vcPixels.data(), iWidth * 4))
+	{
+		spdlog::error("Could not write " + strPath);
+		return false;
+	}
+	return true;
+}
+
+static double percentile(std::vector<double> vcValues, double fPercentile)
+{
+	std::sort(vcValues.begin(), vcValues.end());
+	const size_t index = std::min(vcValues.size() - 1, static_cast<size_t>(fPercentile * (vcValues.size() - 1) + 0.5));
+	return vcValues[index];
+}
+
+static void printRow(const char* szName, const std::vector<double>& vcMs)
+{
+	double fSum = 0.0;
+	for (double fMs : vcMs)
+		fSum += fMs;
+	printf("%-14s %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+		szName,
+		fSum / vcMs.size(),
+		percentile(vcMs, 0.5),
+		percentile(vcMs, 0.95),
+		percentile(vcMs, 0.99),
+		percentile(vcMs, 1.0));
+}
+
+int main(int argc, char** argv)
+{
+	AppSettings appSettings;
+	appSettings.mWidth = 1280;
+	appSettings.mHeight = 720;
+	std::string strLevelFile = "level.txt";
+	std::string strDumpDir;
+	int iDumpEvery = 0;
+	int iFrames = 600;
+	int iWarmup = 30;
+	bool bForceArrays = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--assets") == 0 && i + 1 < argc)
+			appSettings.strAssetSrc = argv[++i];
+		else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+			strLevelFile = argv[++i];
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			iFrames = std::max(1, std::atoi(argv[++i]));
+		else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+			iWarmup = std::max(0, std::atoi(argv[++i]));
+		else if (strcmp(argv[i], "--size") == 0 && i + 2 < argc)
+		{
+			appSettings.mWidth = std::max(16, std::atoi(argv[++i]));
+			appSettings.mHeight = std::max(16, std::atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--dump") == 0 && i + 2 < argc)
+		{
+			strDumpDir = argv[++i];
+			iDumpEvery = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--texture-arrays") == 0)
+			bForceArrays = true;
+		else
+		{
+			spdlog::error(std::string("Unknown argument : ") + argv[i]);
+			return 1;
+		}
+	}
+
+	//the job system treats whichever thread creates it as the main (gl) thread
+	JobSystem::get();
+
+	BenchContext ctx;
+	if (!createContext(ctx))
+	{
+		destroyContext(ctx);
+		return 1;
+	}
+
+	//glew built against glx reports the missing x display after it already loaded everything through the current context
+	glewExperimental = GL_TRUE;
+	const GLenum glewError = glewInit();
+	if (glewError != GLEW_OK && glewError != GLEW_ERROR_NO_GLX_DISPLAY)
+	{
+		spdlog::error(std::string("glewInit failed : ") + reinterpret_cast<const char*>(glewGetErrorString(glewError)));
+		destroyContext(ctx);
+		return 1;
+	}
+	TextureArrays::init(bForceArrays);
+
+	printf("renderer : %s, %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)), reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+	printf("scene : %s, %dx%d, %d frames after %d warmup, %s\n",
+		(appSettings.strAssetSrc + strLevelFile).c_str(), appSettings.mWidth, appSettings.mHeight, iFrames, iWarmup,
+		TextureArrays::get() != nullptr ? "texture arrays" : "bindless textures");
+
+	ResourceManager* resourceManager = new ResourceManager(static_cast<size_t>(appSettings.iResourceBudgetMB) * 1024 * 1024);
+	entt::registry* mRegistry = new entt::registry();
+	LBtnPressedSubject lBtnPressedSubject;
+	LBtnMotionSubject lBtnMotionSubject;
+	LBtnReleasedSubject lBtnReleasedSubject;
+	PhysicsSnapshotSubject physicsSnapshotSubject;
+
+	//same load order as PlayState, minus input, audio and the crt displays
+	PhysicsSys* physicsSys = new PhysicsSys(mRegistry, &appSettings, &lBtnPressedSubject, &lBtnMotionSubject, &lBtnReleasedSubject, &physicsSnapshotSubject);
+	std::unique_ptr<SceneLoadTask> sceneLoadTask = std::make_unique<SceneLoadTask>(resourceManager, appSettings.strAssetSrc, strLevelFile);
+	sceneLoadTask->finish();
+	std::unique_ptr<GeometryLoader> geometryLoader = std::make_unique<GeometryLoader>(mRegistry, physicsSys->getDynamicsWorld(), physicsSys->getMotionSync(), appSettings.strAssetSrc, resourceManager, sceneLoadTask->getLoadedScene());
+	RenderingSys* renderingSys = new RenderingSys(mRegistry, geometryLoader, physicsSys->getDynamicsWorld(), &appSettings, resourceManager);
+	sceneLoadTask.reset();
+
+	BenchTarget target = createTarget(appSettings.mWidth, appSettings.mHeight);
+	renderingSys->setOutputFramebuffer(target.fbo);
+
+	GLuint queryGPU;
+	glCreateQueries(GL_TIME_ELAPSED, 1, &queryGPU);
+
+	RenderSnapshot snapshot;
+	snapshot.bBackgroundQuad = false;
+	std::vector<double> vcSubmitMs, vcGPUMs, vcFrameMs;
+	vcSubmitMs.reserve(iFrames);
+	vcGPUMs.reserve(iFrames);
+	vcFrameMs.reserve(iFrames);
+	const float fDeltaTime = appSettings.fFixedTimeStep;
+	for (int frame = 0; frame < iWarmup + iFrames; frame++)
+	{
+		const int iFrame = frame - iWarmup;
+		snapshot.matView = cameraPath(std::max(0, iFrame), iFrames);
+
+		//physics still writes the staging ring the transforms are uploaded from, nothing moves unless the scene wakes up
+		physicsSys->update(fDeltaTime);
+		geometryLoader->getTransformStaging()->seal();
+
+		//glFinish stands in for the swap, the frame only counts once the gpu is done with it
+		auto start = std::chrono::steady_clock::now();
+		glBeginQuery(GL_TIME_ELAPSED, queryGPU);
+		renderingSys->update(fDeltaTime, snapshot);
+		glEndQuery(GL_TIME_ELAPSED);
+		auto submitted = std::chrono::steady_clock::now();
+		glFinish();
+		auto finished = std::chrono::steady_clock::now();
+
+		if (iFrame < 0)
+			continue;
+		GLuint64 iGPUNs = 0;
+		glGetQueryObjectui64v(queryGPU, GL_QUERY_RESULT, &iGPUNs);
+		vcSubmitMs.emplace_back(std::chrono::duration<double, std::milli>(submitted - start).count());
+		vcGPUMs.emplace_back(static_cast<double>(iGPUNs) / 1e6);
+		vcFrameMs.emplace_back(std::chrono::duration<double, std::milli>(finished - start).count());
+
+		if (iDumpEvery > 0 && iFrame % iDumpEvery == 0)
+			dumpFrame(target, appSettings.mWidth, appSettings.mHeight, strDumpDir, iFrame);
+	}
+
+	printf("%-14s %10s %10s %10s %10s %10s\n", "", "mean ms", "p50 ms", "p95 ms", "p99 ms", "max ms");
+	printRow("cpu submit", vcSubmitMs);
+	printRow("gpu", vcGPUMs);
+	printRow("frame", vcFrameMs);
+	double fFrameSum = 0.0;
+	for (double fMs : vcFrameMs)
+		fFrameSum += fMs;
+	printf("%.1f fps\n", 1000.0 * vcFrameMs.size() / fFrameSum);
+
+	glDeleteQueries(1, &queryGPU);
+	glDeleteFramebuffers(1, &target.fbo);
+	glDeleteTextures(1, &target.texColor);
+
+	//physics frees the bodies before the loader drops the shapes and scene buffers, like the PlayState destructor
+	delete physicsSys;
+	delete renderingSys;
+	geometryLoader.reset();
+	mRegistry->clear();
+	delete mRegistry;
+	delete resourceManager;
+
+	TextureArrays::shutdown();
+	destroyContext(ctx);
+	return 0;
+}
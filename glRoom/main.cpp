@@ -1,6 +1,8 @@
 #include "StateManager.h"
-#include <wtypes.h>
 
+//hybrid laptops, ask the driver for the discrete gpu
+#ifdef _WIN32
+#include <wtypes.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,6 +14,7 @@ extern "C" {
 #ifdef __cplusplus
 }
 #endif
+#endif
 
 
 int main(int argc, char** argv)
@@ -1,4 +1,5 @@
 #include "MainMenuState.h"
+#include "../FrameClock.h"
 
 #include <GL/glew.h>
 #include <SDL.h>
@@ -21,8 +22,10 @@ struct nk_context* ctx;
 #define MAX_VERTEX_MEMORY 512 * 1024
 #define MAX_ELEMENT_MEMORY 128 * 1024
 
-MainMenuState::MainMenuState(AppSettings* appSettings, SMQueue* smQueue, SDL_Window* mWindow) :
+MainMenuState::MainMenuState(AppSettings* appSettings, SMQueue* smQueue, SDL_Window* mWindow, ResourceManager* resourceManager, std::unique_ptr<SceneLoadTask>& sceneLoadTask) :
 	State(appSettings, smQueue),
+	resourceManager(resourceManager),
+	sceneLoadTask(sceneLoadTask),
 	fCurTime(0.f)
 {
 	audioCueSubject = new AudioCueSubject();
@@ -53,7 +56,7 @@ MainMenuState::~MainMenuState()
 
 void MainMenuState::run(SDL_Window* mWindow)
 {
-	Uint32 uTicksLastFrame = SDL_GetTicks();
+	FrameClock frameClock;
 	while (true)
 	{
 		//update
@@ -70,8 +73,10 @@ void MainMenuState::run(SDL_Window* mWindow)
 				switch (e.key.keysym.sym)
 				{
 				case SDLK_RETURN:
-					smQueue->push(SMMessage::PUSH_PLAY_STATE);
-					return;
+					//start loading in the background, the menu keeps running until it is done
+					if (!sceneLoadTask)
+						sceneLoadTask = std::make_unique<SceneLoadTask>(resourceManager, appSettings->strAssetSrc, "level.txt");
+					break;
 
 				case SDLK_ESCAPE:
 					smQueue->push(SMMessage::POP);
@@ -87,8 +92,14 @@ void MainMenuState::run(SDL_Window* mWindow)
 		}
 		nk_input_end(ctx);
 
-		float fDeltaTime = static_cast<float>(SDL_GetTicks() - uTicksLastFrame) / 1000.f;
-		uTicksLastFrame = SDL_GetTicks();
+		//texture uploads are spread over frames, a few ms each so the menu stays smooth
+		if (sceneLoadTask && sceneLoadTask->update(4.0))
+		{
+			smQueue->push(SMMessage::PUSH_PLAY_STATE);
+			return;
+		}
+
+		float fDeltaTime = static_cast<float>(frameClock.tick());
 
 		fCurTime += fDeltaTime;
 		if (fCurTime > 3.f)
@@ -104,7 +115,14 @@ void MainMenuState::run(SDL_Window* mWindow)
 			nk_layout_row_dynamic(ctx, 22, 1);
 			nk_label_colored(ctx, "Controls :", NK_TEXT_ALIGN_LEFT, nk_color(255, 0, 0, 255));
 
-			nk_label(ctx, "Enter - Play", 1);
+			if (sceneLoadTask)
+			{
+				nk_label_colored(ctx, "Loading...", NK_TEXT_ALIGN_LEFT, nk_color(0, 255, 0, 255));
+				nk_size iProgress = static_cast<nk_size>(sceneLoadTask->getProgress() * 100.f);
+				nk_progress(ctx, &iProgress, 100, NK_FIXED);
+			}
+			else
+				nk_label(ctx, "Enter - Play", 1);
 			nk_label(ctx, "Left Click - Pick/Move objects", 1);
 			nk_label(ctx, "Right Click - Camera Motion", 1);
 			nk_label(ctx, "Scroll - Camera Zoom", 1);
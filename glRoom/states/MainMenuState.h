@@ -3,13 +3,15 @@
 #include "../systems/Shader.h"
 #include "../systems/AudioSys.h"
 #include "../systems/Subjects.h"
+#include "../systems/SceneLoadTask.h"
 
 #include <GL/glew.h>
+#include <memory>
 
 class MainMenuState : public State
 {
 public:
-	MainMenuState(AppSettings* appSettings, SMQueue* smQueue, SDL_Window* mWindow);
+	MainMenuState(AppSettings* appSettings, SMQueue* smQueue, SDL_Window* mWindow, ResourceManager* resourceManager, std::unique_ptr<SceneLoadTask>& sceneLoadTask);
 	~MainMenuState();
 	void run(SDL_Window* mWindow) override;
 
@@ -17,6 +19,8 @@ private:
 	AudioSys* mAudioSys;
 
 	AudioCueSubject* audioCueSubject;
+	ResourceManager* resourceManager;
+	std::unique_ptr<SceneLoadTask>& sceneLoadTask;								//owned by the state manager, handed to PlayState once loaded
 
 	//nuklear window properties
 	float fNukWidth, fNukHeight, fNukX, fNukY;
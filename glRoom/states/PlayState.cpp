@@ -1,16 +1,23 @@
 #include "PlayState.h"
+#include "../FrameTracer.h"
+#include "../FrameClock.h"
 
 #include <GL/glew.h>
 #include <SDL.h>
+#include <spdlog/spdlog.h>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 #include <map>
 
 
-PlayState::PlayState(AppSettings* appSettings, SMQueue* smQueue):
+PlayState::PlayState(AppSettings* appSettings, SMQueue* smQueue, ResourceManager* resourceManager, std::unique_ptr<SceneLoadTask> sceneLoadTask):
 	State(appSettings, smQueue),
 	bRBtnDown(false),
-	bLBtnDown(false)
+	bLBtnDown(false),
+	iSimSnapshot(0),
+	iRenderSnapshot(1),
+	bSimAhead(false)
 {
 	mRegistry = new entt::registry();
 
@@ -22,10 +29,21 @@ PlayState::PlayState(AppSettings* appSettings, SMQueue* smQueue):
 	mBtnMotionSubject = new MBtnMotionSubject();
 	mouseScrollSubject = new MouseScrollSubject();
 	audioCueSubject = new AudioCueSubject();
+	physicsSnapshotSubject = new PhysicsSnapshotSubject();
+
+	//a replay wins if both are set, recording would just overwrite the log it reads
+	if (!appSettings->strInputReplay.empty())
+	{
+		inputLog = InputLog::replay(appSettings->strInputReplay);
+		if (inputLog && inputLog->getFixedTimeStep() != appSettings->fFixedTimeStep)
+			spdlog::warn("Input log was recorded with a different physics timestep, the replay wont match the recording");
+	}
+	else if (!appSettings->strInputRecord.empty())
+		inputLog = InputLog::record(appSettings->strInputRecord, appSettings->fFixedTimeStep);
 
 	//maintain load order
 	mCameraSys = new CameraSys(mRegistry, rBtnMotionSubject, mouseScrollSubject);
-	mPhysicsSys = new PhysicsSys(mRegistry, appSettings, lBtnPressedSubject, lBtnMotionSubject, lBtnReleasedSubject);
+	mPhysicsSys = new PhysicsSys(mRegistry, appSettings, lBtnPressedSubject, lBtnMotionSubject, lBtnReleasedSubject, physicsSnapshotSubject);
 	mInputSys = new InputSys(
 		smQueue,
 		mRegistry,
@@ -35,12 +53,58 @@ PlayState::PlayState(AppSettings* appSettings, SMQueue* smQueue):
 		lBtnReleasedSubject,
 		rBtnMotionSubject,
 		mBtnMotionSubject,
-		mouseScrollSubject);
-
-	mGeometryLoader = std::make_unique<GeometryLoader>(mRegistry, mPhysicsSys->getDynamicsWorld(), appSettings->strAssetSrc, "level.txt");
-	mRenderingSys = new RenderingSys(mRegistry, mGeometryLoader, mPhysicsSys->getDynamicsWorld(), appSettings);
+		mouseScrollSubject,
+		physicsSnapshotSubject,
+		inputLog.get());
+
+	//normally preloaded by the main menu, otherwise load it right here
+	if (!sceneLoadTask)
+		sceneLoadTask = std::make_unique<SceneLoadTask>(resourceManager, appSettings->strAssetSrc, "level.txt");
+	sceneLoadTask->finish();
+	mGeometryLoader = std::make_unique<GeometryLoader>(mRegistry, mPhysicsSys->getDynamicsWorld(), mPhysicsSys->getMotionSync(), appSettings->strAssetSrc, resourceManager, sceneLoadTask->getLoadedScene());
+	mPhysicsSys->optimizeBroadphase();
+	mPhysicsSys->quickSave();														//F6 resets the room as loaded until F5 saves another state
+	mRenderingSys = new RenderingSys(mRegistry, mGeometryLoader, mPhysicsSys->getDynamicsWorld(), appSettings, resourceManager);
 	mAudioSys = new AudioSys(audioCueSubject, appSettings->strAssetSrc);
 	mDisplaySys = new CRTDisplaySys(mRegistry, mGeometryLoader, audioCueSubject, appSettings->strAssetSrc);
+	mHotReloadSys = new HotReloadSys(mGeometryLoader, mRenderingSys, appSettings->strAssetSrc, "level.txt");
+	initSystemScheduler();
+
+	//the crt letters are picked with rand, seeded from the log so they flip the same way on every replay
+	if (inputLog)
+		srand(inputLog->getSeed());
+}
+
+void PlayState::initSystemScheduler()
+{
+	//the simulation stage, none of it touches gl so it can run on a worker while the gl thread renders the previous frame
+	//physics only touches bullet and the persistently mapped staging ring, so camera and crt animation overlap it
+	//serial frames keep bullet's own multithreaded world on the main thread
+	const bool bPipelined = appSettings->iFrameLatency > 0;
+	systemScheduler = std::make_unique<SystemScheduler>(&JobSystem::get());
+	systemScheduler->addSystem("CameraSys::update",
+		SystemAccess().writes<SCView, CBackgroundQuad>(),
+		false, [this](float fDeltaTime) { mCameraSys->update(fDeltaTime); });
+	systemScheduler->addSystem("PhysicsSys::update",
+		SystemAccess().writes<CPhysicsBody, MotionSync, TransformStaging, btDiscreteDynamicsWorld>(),
+		mPhysicsSys->isMultithreaded() && !bPipelined, [this](float fDeltaTime) { mPhysicsSys->update(fDeltaTime); });
+	systemScheduler->addSystem("CRTDisplaySys::update",
+		SystemAccess().writes<CCRTDisplay, RenderSnapshot>(),
+		false, [this](float fDeltaTime) { mDisplaySys->update(fDeltaTime, snapshots[iSimSnapshot]); });
+	systemScheduler->addSystem("PlayState::captureSnapshot",
+		SystemAccess().reads<SCView, SCDrawMode, CBackgroundQuad>().writes<RenderSnapshot>(),
+		false, [this](float) { captureSnapshot(snapshots[iSimSnapshot]); });
+}
+
+void PlayState::captureSnapshot(RenderSnapshot& snapshot)
+{
+	snapshot.matView = mRegistry->get<SCView>(mRegistry->view<SCView>()[0]).matView;
+	snapshot.drawMode = mRegistry->get<SCDrawMode>(mRegistry->view<SCDrawMode>()[0]).drawMode;
+	mRegistry->view<CBackgroundQuad>().each([&snapshot](CBackgroundQuad& cQuad)
+		{
+			snapshot.bBackgroundQuad = true;
+			std::copy_n(cQuad.texCoords, 8, snapshot.backgroundTexCoords);
+		});
 }
 
 PlayState::~PlayState()
@@ -51,12 +115,14 @@ PlayState::~PlayState()
 	delete rBtnMotionSubject;
 	delete mBtnMotionSubject;
 	delete mouseScrollSubject;
+	delete physicsSnapshotSubject;
 
 	delete mCameraSys;
 	delete mPhysicsSys;
 	delete mRenderingSys;
 	delete mInputSys;
 	delete mAudioSys;
+	delete mHotReloadSys;
 
 	delete audioCueSubject;
 
@@ -64,25 +130,88 @@ PlayState::~PlayState()
 	delete mRegistry;
 }
 
+void PlayState::simulate(float fDeltaTime)
+{
+	snapshots[iSimSnapshot].clearEvents();
+	systemScheduler->run(fDeltaTime);
+}
+
+void PlayState::render(float fDeltaTime)
+{
+	const RenderSnapshot& snapshot = snapshots[iRenderSnapshot];
+	{
+		TRACE_SCOPE("CRTDisplaySys::apply");
+		mDisplaySys->apply(snapshot);
+	}
+	{
+		TRACE_SCOPE("RenderingSys::update");
+		mRenderingSys->update(fDeltaTime, snapshot);
+	}
+}
+
 void PlayState::run(SDL_Window* mWindow)
 {
-	Uint32 uTicksLastFrame = SDL_GetTicks();
+	FrameClock frameClock;
+	JobSystem& jobSystem = JobSystem::get();
+	const bool bReplaying = inputLog && inputLog->isReplaying();
+	FrameClock replayClock;
 	while (true)
 	{
-		if (mInputSys->update())
-			return;
-
-		float fDeltaTime = static_cast<float>(SDL_GetTicks() - uTicksLastFrame) / 1000.f;
-		uTicksLastFrame = SDL_GetTicks();
-
-		//mDisplaySys->update(fDeltaTime);
-		mCameraSys->update(fDeltaTime);
-		mPhysicsSys->update(fDeltaTime);
-		mDisplaySys->update(fDeltaTime);
-
-		mRenderingSys->update(fDeltaTime);
-
-		SDL_GL_SwapWindow(mWindow);
+		TRACE_SCOPE("Frame");
+
+		//sync point, the frame simulated ahead is done and nothing but the gl thread touches the scene now
+		{
+			TRACE_SCOPE("PlayState::waitSimulation");
+			jobSystem.wait(simCounter);
+		}
+
+		//input is sampled as late as possible, it feeds the next simulation
+		{
+			TRACE_SCOPE("InputSys::update");
+			if (mInputSys->update())
+			{
+				if (bReplaying)
+				{
+					const double dSeconds = replayClock.tick();
+					spdlog::info("Replayed " + std::to_string(inputLog->getFrame()) + " frames in " + std::to_string(dSeconds) + " s, " + std::to_string(inputLog->getFrame() / dSeconds) + " fps");
+				}
+				return;
+			}
+		}
+		{
+			//gpu picking, a click becomes a readback of the id under the cursor and resolves once it arrived
+			//replays wait for it so the pick lands on the same frame every run
+			TRACE_SCOPE("PlayState::resolvePick");
+			int iMouseX, iMouseY;
+			if (mPhysicsSys->takePickRequest(iMouseX, iMouseY))
+				mRenderingSys->requestPick(iMouseX, iMouseY);
+			GLuint iPickID;
+			if (mRenderingSys->pollPick(iPickID, bReplaying))
+				mPhysicsSys->pickEntity(iPickID == 0 ? entt::null : mGeometryLoader->getSlotEntity(iPickID - 1));
+		}
+		{
+			TRACE_SCOPE("HotReloadSys::update");
+			mHotReloadSys->update();
+		}
+
+		//replays step exactly one fixed timestep per frame, however long the frame really took
+		float fDeltaTime = bReplaying ? appSettings->fFixedTimeStep : static_cast<float>(frameClock.tick());
+		if (!bSimAhead)
+			simulate(fDeltaTime);
+
+		//the simulated frame becomes the one to render, its transforms are sealed in the staging ring
+		mGeometryLoader->getTransformStaging()->seal();
+		std::swap(iSimSnapshot, iRenderSnapshot);
+
+		//debug lines read the bullet world while rendering, so those draw modes stay serial
+		bSimAhead = appSettings->iFrameLatency > 0 && snapshots[iRenderSnapshot].drawMode == DrawMode::NORMAL;
+		if (bSimAhead)
+			jobSystem.run(simCounter, [this, fDeltaTime]() { simulate(fDeltaTime); });
+
+		render(fDeltaTime);
+		{
+			TRACE_SCOPE("SDL_GL_SwapWindow");
+			SDL_GL_SwapWindow(mWindow);
+		}
 	}
 }
-
@@ -4,9 +4,13 @@
 #include "../systems/RenderingSys.h"
 #include "../systems/PhysicsSys.h"
 #include "../systems/InputSys.h"
+#include "../systems/InputLog.h"
 #include "../systems/AudioSys.h"
 #include "../systems/CRTDisplaySys.h"
 #include "../systems/GeometryLoader.h"
+#include "../systems/HotReloadSys.h"
+#include "../systems/RenderSnapshot.h"
+#include "../SystemScheduler.h"
 
 #include <entt/entity/registry.hpp>
 #include <memory>
@@ -15,11 +19,19 @@
 class PlayState : public State
 {
 public:
-	PlayState(AppSettings* appSettings, SMQueue* smQueue);
+	PlayState(AppSettings* appSettings, SMQueue* smQueue, ResourceManager* resourceManager, std::unique_ptr<SceneLoadTask> sceneLoadTask = nullptr);
 	~PlayState();
 	void run(SDL_Window* mWindow) override;
 
 private:
+	void initSystemScheduler();
+	void captureSnapshot(RenderSnapshot& snapshot);
+
+	//simulates into snapshots[iSimSnapshot] on the calling thread
+	void simulate(float fDeltaTime);
+
+	//gl thread, draws snapshots[iRenderSnapshot]
+	void render(float fDeltaTime);
 
 	bool bLBtnDown, bRBtnDown, bMBtnDown;
 	entt::registry* mRegistry;
@@ -30,7 +42,17 @@ private:
 	InputSys* mInputSys;
 	CRTDisplaySys* mDisplaySys;
 	AudioSys* mAudioSys;
+	HotReloadSys* mHotReloadSys;
+	std::unique_ptr<SystemScheduler> systemScheduler;							//simulation stage only, rendering stays outside the graph
+
+	//two stage pipeline, the simulation of frame n + 1 runs as a job while frame n renders and swaps
+	RenderSnapshot snapshots[2];
+	unsigned int iSimSnapshot;
+	unsigned int iRenderSnapshot;
+	JobCounter simCounter;
+	bool bSimAhead;																//snapshots[iSimSnapshot] is being / was simulated ahead
 	std::unique_ptr<GeometryLoader> mGeometryLoader;
+	std::unique_ptr<InputLog> inputLog;											//recording or replaying this session's input, nullptr otherwise
 
 	LBtnPressedSubject* lBtnPressedSubject;
 	LBtnMotionSubject* lBtnMotionSubject;
@@ -39,4 +61,5 @@ private:
 	MBtnMotionSubject* mBtnMotionSubject;
 	MouseScrollSubject* mouseScrollSubject;
 	AudioCueSubject* audioCueSubject;
+	PhysicsSnapshotSubject* physicsSnapshotSubject;
 };
\ No newline at end of file
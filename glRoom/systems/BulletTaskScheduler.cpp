@@ -0,0 +1,48 @@
+#include "BulletTaskScheduler.h"
+
+#include <algorithm>
+#include <mutex>
+
+BulletTaskScheduler::BulletTaskScheduler(JobSystem* jobSystem, int iNumThreads) :
+	btITaskScheduler("glRoomJobSystem"),
+	jobSystem(jobSystem),
+	iNumThreads(1)
+{
+	setNumThreads(iNumThreads);
+}
+
+int BulletTaskScheduler::getMaxNumThreads() const
+{
+	//bullet keeps per thread storage for at most BT_MAX_THREAD_COUNT threads
+	return std::min(static_cast<int>(jobSystem->getNumThreads()), static_cast<int>(BT_MAX_THREAD_COUNT));
+}
+
+void BulletTaskScheduler::setNumThreads(int iNumThreads)
+{
+	this->iNumThreads = std::max(1, std::min(iNumThreads, getMaxNumThreads()));
+}
+
+void BulletTaskScheduler::parallelFor(int iBegin, int iEnd, int iGrainSize, const btIParallelForBody& body)
+{
+	jobSystem->parallelFor(iBegin, iEnd, iGrainSize,
+		[&body](int iChunkBegin, int iChunkEnd)
+		{
+			body.forLoop(iChunkBegin, iChunkEnd);
+		},
+		static_cast<unsigned int>(iNumThreads));
+}
+
+btScalar BulletTaskScheduler::parallelSum(int iBegin, int iEnd, int iGrainSize, const btIParallelSumBody& body)
+{
+	btScalar fSum = 0.f;
+	std::mutex mtxSum;
+	jobSystem->parallelFor(iBegin, iEnd, iGrainSize,
+		[&body, &fSum, &mtxSum](int iChunkBegin, int iChunkEnd)
+		{
+			btScalar fPartial = body.sumLoop(iChunkBegin, iChunkEnd);
+			std::lock_guard<std::mutex> lock(mtxSum);
+			fSum += fPartial;
+		},
+		static_cast<unsigned int>(iNumThreads));
+	return fSum;
+}
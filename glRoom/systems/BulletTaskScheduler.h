@@ -0,0 +1,23 @@
+//btITaskScheduler running bullet's parallel loops on the shared JobSystem
+//any pool thread may end up in bullet code, so bullet sizes its per thread storage for the whole pool
+//iNumThreads only limits how many of them work on one loop
+#pragma once
+#include "../JobSystem.h"
+#include <LinearMath/btThreads.h>
+
+class BulletTaskScheduler : public btITaskScheduler
+{
+public:
+	BulletTaskScheduler(JobSystem* jobSystem, int iNumThreads);
+
+	int getMaxNumThreads() const override;
+	int getNumThreads() const override { return getMaxNumThreads(); }
+	int getConcurrency() const { return iNumThreads; }
+	void setNumThreads(int iNumThreads) override;
+	void parallelFor(int iBegin, int iEnd, int iGrainSize, const btIParallelForBody& body) override;
+	btScalar parallelSum(int iBegin, int iEnd, int iGrainSize, const btIParallelSumBody& body) override;
+
+private:
+	JobSystem* jobSystem;
+	int iNumThreads;
+};
@@ -24,10 +24,19 @@ CRTDisplaySys::CRTDisplaySys(entt::registry* mRegistry, std::unique_ptr<Geometry
 	//blank texture
 	loadDisplyTexHandle('0', mGeometryLoader->loadTexture(strSrc, "0.png"));
 
-	for (auto iter = mGeometryLoader->getEntityDrawIDs().begin(); iter != mGeometryLoader->getEntityDrawIDs().end(); iter++)
+	//every crt owns a draw of its type's screen mesh, so each can show its own letter
+	const EntityTypeTable& entityTypes = mGeometryLoader->getEntityTypes();
+	auto view = mRegistry->view<CCRTDisplay, CEntityType, CGeometryInstance>();
+	for (auto entity : view)
 	{
-		if (iter->first.substr(0, 3) == "crt")
-			vcCRTDrawIDs.emplace_back(iter->second);
+		const EntityTypeDesc& typeDesc = entityTypes[view.get<CEntityType>(entity).typeID];
+		if (!typeDesc.bDrawPerInstance)
+			continue;
+		for (auto& meshRef : typeDesc.vcMeshes)
+		{
+			if (meshRef.rsType == RSType::EMISSIVE)
+				vcCRTDrawIDs.emplace_back(meshRef.drawID + view.get<CGeometryInstance>(entity).instanceID);
+		}
 	}
 
 	//emissive textures 
@@ -36,9 +45,7 @@ CRTDisplaySys::CRTDisplaySys(entt::registry* mRegistry, std::unique_ptr<Geometry
 
 void CRTDisplaySys::loadDisplyTexHandle(char keyHandle, GLuint texture)
 {
-	GLuint64 handle = glGetTextureHandleARB(texture);
-	glMakeTextureHandleResidentARB(handle);
-	mapDisplayTexHandle[keyHandle] = handle;
+	mapDisplayTexHandle[keyHandle] = GeometryLoader::getTextureHandle(texture);
 }
 
 void CRTDisplaySys::updateTextureHandle(const GLuint& drawID, const GLuint64 handle)
@@ -48,8 +55,12 @@ void CRTDisplaySys::updateTextureHandle(const GLuint& drawID, const GLuint64 han
 	glUnmapNamedBuffer(ssboTexHandle);
 }
 
-void CRTDisplaySys::update(const float& fDeltaTime)
+void CRTDisplaySys::update(const float& fDeltaTime, RenderSnapshot& snapshot)
 {
+	//levels dont have to contain monitors
+	if (vcCRTDrawIDs.empty())
+		return;
+
 	fCurTime += fDeltaTime;
 	if (fCurTime >= fTimer)
 	{
@@ -58,28 +69,38 @@ void CRTDisplaySys::update(const float& fDeltaTime)
 		if (strDisplay[charID] == ' ')
 		{
 			for (auto& drawID : vcCRTDrawIDs)
-				updateTextureHandle(drawID, mapDisplayTexHandle['0']);
+				snapshot.vcTexHandleWrites.emplace_back(drawID, mapDisplayTexHandle['0']);
 
 			fTimer = 3.f;
 		}
 		else if (fTimer == 3.f)
 		{
 			for (auto& drawID : vcCRTDrawIDs)
-				updateTextureHandle(drawID, mapDisplayTexHandle[strDisplay[charID]]);
+				snapshot.vcTexHandleWrites.emplace_back(drawID, mapDisplayTexHandle[strDisplay[charID]]);
 			
 			fTimer = 4.f;
-			audioCueSubject->notify();
+			snapshot.iAudioCues++;
 		}
 		else
 		{
-			int iRand = rand() % vcCRTDrawIDs.size();																	//4 = num monitors
-			updateTextureHandle(vcCRTDrawIDs[iRand], mapDisplayTexHandle[strDisplay[charID]]);
+			int iRand = rand() % vcCRTDrawIDs.size();
+			snapshot.vcTexHandleWrites.emplace_back(vcCRTDrawIDs[iRand], mapDisplayTexHandle[strDisplay[charID]]);
 			fTimer = 4.f;
-			audioCueSubject->notify();
+			snapshot.iAudioCues++;
 
 		}
 		charID++;
 		if (charID >= strDisplay.length())
 			charID = 0;
 	}
-}
\ No newline at end of file
+}
+
+void CRTDisplaySys::apply(const RenderSnapshot& snapshot)
+{
+	for (auto& texHandleWrite : snapshot.vcTexHandleWrites)
+		updateTextureHandle(texHandleWrite.first, texHandleWrite.second);
+
+	//the cue plays when the letter actually shows up
+	for (unsigned int i = 0; i < snapshot.iAudioCues; i++)
+		audioCueSubject->notify();
+}
@@ -1,7 +1,9 @@
 //update the crt display
+//update only decides what the monitors show next and records it in the snapshot, apply writes it on the gl thread
 #pragma once
 #include "Subjects.h"
 #include "GeometryLoader.h"
+#include "RenderSnapshot.h"
 #include <entt/entity/registry.hpp>
 #include <string>
 
@@ -9,7 +11,8 @@ class CRTDisplaySys
 {
 public:
 	CRTDisplaySys(entt::registry* mRegistry, std::unique_ptr<GeometryLoader>& mGeometryLoader, AudioCueSubject* audioCueSubject, std::string strAssetSrc);
-	void update(const float& fDeltaTime);
+	void update(const float& fDeltaTime, RenderSnapshot& snapshot);
+	void apply(const RenderSnapshot& snapshot);
 
 private:
 	void loadDisplyTexHandle(const char keyHandle, const GLuint texture);
@@ -115,13 +115,9 @@ void CameraSys::animateForeground(const float& fDeltaRelX)
 			y0 += 0.5f;
 
 
+		//uploaded by the render stage from the frame's snapshot, camera runs off the gl thread
 		cQuad.texCoords[1] = cQuad.texCoords[3] = y0;
 		cQuad.texCoords[5] = cQuad.texCoords[7] = y0 + 0.5f;
-
-		float* ptrBuffer = (float*)glMapNamedBufferRange(cQuad.vboTex, 0, sizeof(float) * 8, GL_MAP_WRITE_BIT);
-		for (int i = 0; i < 8; i++)
-			ptrBuffer[i] = cQuad.texCoords[i];
-		glUnmapNamedBuffer(cQuad.vboTex);
 	});
 	
 }
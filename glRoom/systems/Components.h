@@ -1,11 +1,12 @@
 #pragma once
 #include <BulletDynamics/Dynamics/btRigidBody.h>
+#include "MotionState.h"
 #include <LinearMath/btDefaultMotionState.h>
 #include <BulletCollision/CollisionShapes/btBoxShape.h>
 #include <BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h>
 #include <glm/mat4x4.hpp>
 #include <GL/glew.h>
-#include <string>
+#include "SceneDesc.h"
 
 //Geometry data components
 //given to entities with renderable mesh
@@ -16,20 +17,19 @@ struct CGeometryInstance
 	CGeometryInstance() : baseInstance(0), instanceID(0) {}
 };
 
-//distinguish entities by str names. makes easier to load data in buffers by identifying num instances
-//also useful to get model file name and path
-struct CEntityType								
+//distinguish entities by their interned type, indexes the scene's EntityTypeTable for name, model path and spec
+struct CEntityType
 {
-	std::string strEntityType;
-	CEntityType(std::string strEntityType) : strEntityType(strEntityType) {}
+	EntityTypeID typeID;
+	CEntityType(EntityTypeID typeID) : typeID(typeID) {}
 };
 
 
+//spawn transform, moving bodies are synced to the gpu by their motion state
 struct CTransform
 {
-	bool bUpdate;														//update ssbo data if true, done by renderingsys before drawing
 	glm::mat4 matModel;								//model matrix
-	CTransform(glm::mat4 matModel = glm::mat4(1.f)) : matModel(matModel), bUpdate(false)
+	CTransform(glm::mat4 matModel = glm::mat4(1.f)) : matModel(matModel)
 	{
 	}
 };
@@ -41,22 +41,15 @@ struct CCRTDisplay
 //scrolling foreground
 struct CBackgroundQuad
 {
-	GLuint vboTex;
-
-	//update render area
+	//update render area, renderingsys writes them into the quad's vertices
 	float texCoords[8];
-
-	~CBackgroundQuad()
-	{
-		glDeleteBuffers(1, &vboTex);
-	}
 };
 
 //btPhysics Rigid body component
 struct CPhysicsBody
 {
 	btRigidBody* rigidBody;
-	btDefaultMotionState* motionState;
+	btMotionState* motionState;											//InterpMotionState for dynamic bodies, btDefaultMotionState for static ones
 	btCollisionShape* collisionShape;
 
 	//if collision shape is btBvhTriangleMeshShape, set bTriangleShape true
@@ -66,6 +59,9 @@ struct CPhysicsBody
 	btScalar* vertices;
 	short* indices;
 
+	//shape is shared between bodies and owned by the ResourceManager, dont delete it
+	bool bSharedShape;
+
 	CPhysicsBody() : 
 		rigidBody(nullptr),
 		motionState(nullptr),
@@ -73,7 +69,8 @@ struct CPhysicsBody
 		bTriangleShape(false),
 		meshInterface(nullptr),
 		vertices(nullptr),
-		indices(nullptr)
+		indices(nullptr),
+		bSharedShape(false)
 	{}
 };
 
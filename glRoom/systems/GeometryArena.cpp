@@ -0,0 +1,193 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+#include <numeric>
+
+GeometryArena::GeometryArena(GLuint iVertexCapacity, GLuint iIndexCapacity) :
+	iVertexCapacity(std::max(iVertexCapacity, 1u)),
+	iIndexCapacity(std::max(iIndexCapacity, 1u))
+{
+	glCreateVertexArrays(1, &vao);
+	glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(vao, 0, 0);
+	glEnableVertexArrayAttrib(vao, 0);
+	glVertexArrayAttribFormat(vao, 1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3);
+	glVertexArrayAttribBinding(vao, 1, 0);
+	glEnableVertexArrayAttrib(vao, 1);
+	glVertexArrayAttribFormat(vao, 2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 6);
+	glVertexArrayAttribBinding(vao, 2, 0);
+	glEnableVertexArrayAttrib(vao, 2);
+
+	createBuffers(this->iVertexCapacity, this->iIndexCapacity, vbo, ebo);
+	bindBuffers();
+}
+
+GeometryArena::~GeometryArena()
+{
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &ebo);
+}
+
+void GeometryArena::createBuffers(GLuint iVertices, GLuint iIndices, GLuint& vboNew, GLuint& eboNew)
+{
+	//dynamic storage so meshes can be written after creation
+	glCreateBuffers(1, &vboNew);
+	glNamedBufferStorage(vboNew, sizeof(float) * ciVertexFloats * iVertices, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glCreateBuffers(1, &eboNew);
+	glNamedBufferStorage(eboNew, sizeof(unsigned int) * iIndices, nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+void GeometryArena::bindBuffers()
+{
+	//the vao stays the same, only its buffers are swapped
+	glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(float) * ciVertexFloats);
+	glVertexArrayElementBuffer(vao, ebo);
+}
+
+void GeometryArena::reserve(GLuint iVertexEnd, GLuint iIndexEnd)
+{
+	if (iVertexEnd <= iVertexCapacity && iIndexEnd <= iIndexCapacity)
+		return;
+
+	GLuint iNewVertices = iVertexCapacity, iNewIndices = iIndexCapacity;
+	while (iNewVertices < iVertexEnd)
+		iNewVertices *= 2;
+	while (iNewIndices < iIndexEnd)
+		iNewIndices *= 2;
+
+	GLuint vboNew, eboNew;
+	createBuffers(iNewVertices, iNewIndices, vboNew, eboNew);
+	glCopyNamedBufferSubData(vbo, vboNew, 0, 0, sizeof(float) * ciVertexFloats * vertexRanges.getEnd());
+	glCopyNamedBufferSubData(ebo, eboNew, 0, 0, sizeof(unsigned int) * indexRanges.getEnd());
+	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &ebo);
+	vbo = vboNew;
+	ebo = eboNew;
+	iVertexCapacity = iNewVertices;
+	iIndexCapacity = iNewIndices;
+	bindBuffers();
+}
+
+GeometryHandle GeometryArena::allocate(const float* vertices, GLuint iVertices, const unsigned int* indices, GLuint iIndices)
+{
+	GeometryRange range;
+	range.baseVertex = vertexRanges.allocate(iVertices);
+	range.iVertices = iVertices;
+	range.firstIndex = indexRanges.allocate(iIndices);
+	range.iIndices = iIndices;
+	reserve(vertexRanges.getEnd(), indexRanges.getEnd());
+	glNamedBufferSubData(vbo, sizeof(float) * ciVertexFloats * range.baseVertex, sizeof(float) * ciVertexFloats * iVertices, vertices);
+	glNamedBufferSubData(ebo, sizeof(unsigned int) * range.firstIndex, sizeof(unsigned int) * iIndices, indices);
+
+	GeometryHandle handle;
+	if (vcFreeHandles.empty())
+	{
+		handle = static_cast<GeometryHandle>(vcRanges.size());
+		vcRanges.emplace_back(range);
+		vcVertexAllocs.emplace_back(iVertices);
+		vcIndexAllocs.emplace_back(iIndices);
+		vcLive.emplace_back(true);
+	}
+	else
+	{
+		handle = vcFreeHandles.back();
+		vcFreeHandles.pop_back();
+		vcRanges[handle] = range;
+		vcVertexAllocs[handle] = iVertices;
+		vcIndexAllocs[handle] = iIndices;
+		vcLive[handle] = true;
+	}
+	return handle;
+}
+
+void GeometryArena::free(GeometryHandle handle)
+{
+	if (handle == ciInvalidGeometry || !vcLive[handle])
+		return;
+
+	vertexRanges.free(vcRanges[handle].baseVertex, vcVertexAllocs[handle]);
+	indexRanges.free(vcRanges[handle].firstIndex, vcIndexAllocs[handle]);
+	vcLive[handle] = false;
+	vcFreeHandles.emplace_back(handle);
+}
+
+void GeometryArena::update(GeometryHandle handle, const float* vertices, GLuint iVertices, const unsigned int* indices, GLuint iIndices)
+{
+	GeometryRange& range = vcRanges[handle];
+	if (iVertices > vcVertexAllocs[handle])
+	{
+		vertexRanges.free(range.baseVertex, vcVertexAllocs[handle]);
+		range.baseVertex = vertexRanges.allocate(iVertices);
+		vcVertexAllocs[handle] = iVertices;
+	}
+	if (iIndices > vcIndexAllocs[handle])
+	{
+		indexRanges.free(range.firstIndex, vcIndexAllocs[handle]);
+		range.firstIndex = indexRanges.allocate(iIndices);
+		vcIndexAllocs[handle] = iIndices;
+	}
+	range.iVertices = iVertices;
+	range.iIndices = iIndices;
+	reserve(vertexRanges.getEnd(), indexRanges.getEnd());
+	glNamedBufferSubData(vbo, sizeof(float) * ciVertexFloats * range.baseVertex, sizeof(float) * ciVertexFloats * iVertices, vertices);
+	glNamedBufferSubData(ebo, sizeof(unsigned int) * range.firstIndex, sizeof(unsigned int) * iIndices, indices);
+}
+
+void GeometryArena::writeVertices(GeometryHandle handle, GLuint iFirstVertex, const float* vertices, GLuint iVertices)
+{
+	const GLuint baseVertex = vcRanges[handle].baseVertex + iFirstVertex;
+	glNamedBufferSubData(vbo, sizeof(float) * ciVertexFloats * baseVertex, sizeof(float) * ciVertexFloats * iVertices, vertices);
+}
+
+bool GeometryArena::isFragmented() const
+{
+	return vertexRanges.getFreeSize() * 4 > vertexRanges.getEnd() || indexRanges.getFreeSize() * 4 > indexRanges.getEnd();
+}
+
+void GeometryArena::defragment()
+{
+	//in order of their current place, so meshes loaded together stay together
+	std::vector<GeometryHandle> vcHandles;
+	for (GeometryHandle handle = 0; handle < vcRanges.size(); handle++)
+	{
+		if (vcLive[handle])
+			vcHandles.emplace_back(handle);
+	}
+	std::sort(vcHandles.begin(), vcHandles.end(), [this](GeometryHandle a, GeometryHandle b) { return vcRanges[a].baseVertex < vcRanges[b].baseVertex; });
+
+	//copies cant overlap within one buffer, so pack into new ones
+	GLuint vboNew, eboNew;
+	createBuffers(iVertexCapacity, iIndexCapacity, vboNew, eboNew);
+	GLuint iVertexEnd = 0, iIndexEnd = 0;
+	for (GeometryHandle handle : vcHandles)
+	{
+		GeometryRange& range = vcRanges[handle];
+		glCopyNamedBufferSubData(vbo, vboNew, sizeof(float) * ciVertexFloats * range.baseVertex, sizeof(float) * ciVertexFloats * iVertexEnd, sizeof(float) * ciVertexFloats * range.iVertices);
+		glCopyNamedBufferSubData(ebo, eboNew, sizeof(unsigned int) * range.firstIndex, sizeof(unsigned int) * iIndexEnd, sizeof(unsigned int) * range.iIndices);
+		range.baseVertex = iVertexEnd;
+		range.firstIndex = iIndexEnd;
+		vcVertexAllocs[handle] = range.iVertices;
+		vcIndexAllocs[handle] = range.iIndices;
+		iVertexEnd += range.iVertices;
+		iIndexEnd += range.iIndices;
+	}
+	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &ebo);
+	vbo = vboNew;
+	ebo = eboNew;
+	bindBuffers();
+	vertexRanges.reset(iVertexEnd);
+	indexRanges.reset(iIndexEnd);
+}
+
+GeometryStats GeometryArena::getStats() const
+{
+	GeometryStats stats;
+	const size_t iVertexBytes = sizeof(float) * ciVertexFloats;
+	stats.iUsedBytes = (vertexRanges.getEnd() - vertexRanges.getFreeSize()) * iVertexBytes + (indexRanges.getEnd() - indexRanges.getFreeSize()) * sizeof(unsigned int);
+	stats.iFreeBytes = vertexRanges.getFreeSize() * iVertexBytes + indexRanges.getFreeSize() * sizeof(unsigned int);
+	stats.iCapacityBytes = iVertexCapacity * iVertexBytes + iIndexCapacity * sizeof(unsigned int);
+	stats.iRanges = vcRanges.size() - vcFreeHandles.size();
+	return stats;
+}
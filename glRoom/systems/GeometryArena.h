@@ -0,0 +1,78 @@
+//one vbo / ebo pair shared by every mesh of a scene, drawn through a single vao
+//vertices are position / normal / tex coord, indices stay local to their mesh and draws add the range's baseVertex
+//ranges are sub allocated first fit from free lists, both buffers double when they run out
+//handles stay valid for the life of the arena, ranges behind them move on defragment and update
+#pragma once
+#include "RangeAllocator.h"
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <vector>
+
+typedef uint32_t GeometryHandle;
+constexpr GeometryHandle ciInvalidGeometry = 0xffffffff;
+
+struct GeometryRange
+{
+	GLuint baseVertex;
+	GLuint iVertices;
+	GLuint firstIndex;
+	GLuint iIndices;
+};
+
+struct GeometryStats
+{
+	size_t iUsedBytes;															//allocated vertex and index ranges
+	size_t iFreeBytes;															//holes between them
+	size_t iCapacityBytes;														//both buffers
+	size_t iRanges;
+};
+
+class GeometryArena
+{
+public:
+	static constexpr GLuint ciVertexFloats = 8;
+
+	GeometryArena(GLuint iVertexCapacity, GLuint iIndexCapacity);
+	~GeometryArena();
+
+	GeometryHandle allocate(const float* vertices, GLuint iVertices, const unsigned int* indices, GLuint iIndices);
+	void free(GeometryHandle handle);
+
+	//new contents for a mesh, written in place while they fit its allocation, otherwise it moves
+	void update(GeometryHandle handle, const float* vertices, GLuint iVertices, const unsigned int* indices, GLuint iIndices);
+
+	//overwrites part of a mesh's vertices, the vertex count stays
+	void writeVertices(GeometryHandle handle, GLuint iFirstVertex, const float* vertices, GLuint iVertices);
+
+	const GeometryRange& getRange(GeometryHandle handle) const { return vcRanges[handle]; }
+	GLuint getVAO() const { return vao; }
+
+	//holes make up more than a quarter of the used extent of either buffer
+	bool isFragmented() const;
+
+	//packs every live range to the front of fresh buffers, every range may change
+	void defragment();
+
+	GeometryStats getStats() const;
+
+private:
+	void reserve(GLuint iVertexEnd, GLuint iIndexEnd);
+	void createBuffers(GLuint iVertices, GLuint iIndices, GLuint& vboNew, GLuint& eboNew);
+	void bindBuffers();
+
+	GLuint vao;
+	GLuint vbo;
+	GLuint ebo;
+	GLuint iVertexCapacity;
+	GLuint iIndexCapacity;
+	RangeAllocator vertexRanges;
+	RangeAllocator indexRanges;
+
+	//indexed by handle
+	std::vector<GeometryRange> vcRanges;
+	std::vector<GLuint> vcVertexAllocs;											//allocated sizes, the range may use less after an update
+	std::vector<GLuint> vcIndexAllocs;
+	std::vector<bool> vcLive;
+	std::vector<GeometryHandle> vcFreeHandles;
+};
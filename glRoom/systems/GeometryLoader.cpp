@@ -1,112 +1,241 @@
 #include "GeometryLoader.h"
+#include "PhysicsWorld.h"
 
 #include <GL/glew.h>
-#ifndef TINYOBJLOADER_IMPLEMENTATION
-#define TINYOBJLOADER_IMPLEMENTATION
-#endif
-#include <tiny_obj_loader.h>
-#ifndef STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#endif
-
-#include <stb_image.h>
 #include <spdlog/spdlog.h>
-#include <unordered_map>
-#include <BulletCollision/CollisionShapes/btBoxShape.h>
 #include <LinearMath/btDefaultMotionState.h>
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
 #include <BulletDynamics/Dynamics/btRigidBody.h>
-#include <BulletCollision/CollisionShapes/btTriangleMesh.h>
-#include <BulletCollision/CollisionShapes/btSphereShape.h>
-#include <BulletCollision/CollisionShapes/btCylinderShape.h>
-#include <BulletCollision/CollisionShapes/btCompoundShape.h>
-#include <glm/gtc/type_ptr.hpp>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <algorithm>
+#include <cstddef>
 
 GeometryLoader::GeometryLoader(
 	entt::registry* mRegistry,
 	btDiscreteDynamicsWorld* dynamicsWorld,
+	MotionSync* motionSync,
 	std::string strAssetSrc,
-	std::string strLevelFile) :
+	ResourceManager* resourceManager,
+	LoadedScene& loadedScene) :
 	mRegistry(mRegistry),
 	dynamicsWorld(dynamicsWorld),
+	motionSync(motionSync),
 	strAssetSrc(strAssetSrc),
-	strLevelFile(strLevelFile),
-	iTotalInstances(0),
-	ciTotalDrawCmd(0)
+	resourceManager(resourceManager),
+	iSlotCapacity(std::max(loadedScene.sceneDesc->iTotalInstances, 1u))
 {
-	initGeometryInstances();
-	initGeometryInstanceData();
-	initGeometryBaseInstances();
-	initSSBOInstanceTransforms();
-	initBufferStorage();
+	//take over the references loading acquired, they are released when this is destroyed
+	sceneDesc = loadedScene.sceneDesc;
+	strSceneKey = loadedScene.strSceneKey;
+	loadedScene.strSceneKey.clear();
+	mapShapes = std::move(loadedScene.mapShapes);
+	loadedScene.mapShapes.clear();
+	mapTextures = std::move(loadedScene.mapTextures);
+	loadedScene.mapTextures.clear();
+
+	//resolved once per type, entities only index into it
+	vcTypeShapes.resize(sceneDesc->entityTypes.size(), nullptr);
+	for (EntityTypeID typeID = 0; typeID < sceneDesc->entityTypes.size(); typeID++)
+	{
+		auto iterShape = mapShapes.find(sceneDesc->entityTypes[typeID].strName);
+		if (iterShape != mapShapes.end())
+			vcTypeShapes[typeID] = iterShape->second;
+	}
+
+	//instance blocks start out exactly as the scene laid them out
+	for (const auto& typeDesc : sceneDesc->entityTypes)
+		instanceAllocator.addType(typeDesc.baseInstance, typeDesc.iInstances, typeDesc.bDrawPerInstance);
+	vcDirtyDraws.resize(sceneDesc->entityTypes.size(), false);
+	vcMovedDraws.resize(sceneDesc->entityTypes.size(), false);
+
+	initEntities(*sceneDesc);
+	initTextures(*sceneDesc);
+	initSSBOInstanceTransforms(*sceneDesc);
+	initSceneBuffers(*sceneDesc);
 }
 
 GeometryLoader::~GeometryLoader()
 {
-	glDeleteBuffers(1, &drawIndirectBuffer);
-
+	glDeleteBuffers(1, &ssboTransforms);
+
+	//gl buffers, textures and shapes stay resident in the resource manager for the next session
+	restoreDrawCommands();
+	resourceManager->release(strBuffersKey);
+	resourceManager->release(strSceneKey);
+	for (auto& shape : mapShapes)
+		resourceManager->release(shapeResourceKey(shape.first));
 	for (auto& tex : mapTextures)
-		glDeleteTextures(1, &tex.second);
+		resourceManager->release(tex.first);
 }
 
-void GeometryLoader::initGeometryBaseInstances()
+void GeometryLoader::initEntities(const SceneDesc& sceneDesc)
 {
-	//update baseInstances into entities so physics system can update transforms for instances
-	mRegistry->view<CEntityType, CGeometryInstance  >().each([this](CEntityType& et, CGeometryInstance& gi)
-		{
-			gi.baseInstance = mapEntityBaseInstances[et.strEntityType];
-		});
+	for (const auto& entityDesc : sceneDesc.vcEntities)
+	{
+		LiveEntity liveEntity;
+		liveEntity.typeID = entityDesc.typeID;
+		liveEntity.vOrigin = entityDesc.vOrigin;
+		liveEntity.fYaw = entityDesc.fYaw;
+		liveEntity.vDimensions = entityDesc.vDimensions;
+		liveEntity.bRenderable = entityDesc.bRenderable;
+		if (entityDesc.bRenderable)
+			liveEntity.e = createInstance(entityDesc.typeID, entityDesc.instanceID, entityDesc.vOrigin, entityDesc.fYaw, entityDesc.matModel);
+		else
+			liveEntity.e = createInvisibleWall(entityDesc.vOrigin, entityDesc.vDimensions);
+		vcLiveEntities.emplace_back(liveEntity);
+	}
 }
 
-void GeometryLoader::initSSBOInstanceTransforms()
+entt::entity GeometryLoader::createInstance(EntityTypeID typeID, GLuint instanceID, const btVector3& vOrigin, float fYaw, const glm::mat4& matModel)
+{
+	auto e = mRegistry->create();
+	mRegistry->emplace<CEntityType>(e, typeID);
+
+	//baseInstances are stored in entities so physics system can update transforms for instances
+	CGeometryInstance& cInstance = mRegistry->emplace<CGeometryInstance>(e);
+	cInstance.baseInstance = instanceAllocator.getBlock(typeID).base;
+	cInstance.instanceID = instanceID;
+	setSlotEntity(cInstance.baseInstance + instanceID, e);
+
+	CPhysicsBody& physicsBody = mRegistry->emplace<CPhysicsBody>(e);
+	physicsBody = createPhysicsBody(typeID, vOrigin, fYaw);
+	addRigidBody(physicsBody.rigidBody, e, physicsBody.rigidBody->isStaticObject() ? ciGroupStatic : ciGroupDynamic);
+
+	mRegistry->emplace<CTransform>(e, matModel);
+
+	//init emissive display for animation, only crts get a draw of their own
+	if (sceneDesc->entityTypes[typeID].bDrawPerInstance)
+		mRegistry->emplace<CCRTDisplay>(e);
+	return e;
+}
+
+void GeometryLoader::initTextures(const SceneDesc& sceneDesc)
+{
+	//loading normally uploaded all of them already
+	for (auto& texture : sceneDesc.mapTextures)
+	{
+		const std::string strKey = textureResourceKey(strAssetSrc + "models/" + texture.first);
+		if (mapTextures.find(strKey) == mapTextures.end())
+			mapTextures[strKey] = acquireTexture(strKey, texture.second);
+	}
+}
+
+void GeometryLoader::initSSBOInstanceTransforms(const SceneDesc& sceneDesc)
 {
 	glCreateBuffers(1, &ssboTransforms);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboTransforms);
-	glNamedBufferStorage(ssboTransforms, sizeof(glm::mat4) * iTotalInstances, nullptr, GL_MAP_WRITE_BIT);
-	glm::mat4* ptrBuffer = (glm::mat4*)glMapNamedBufferRange(ssboTransforms, 0, sizeof(glm::mat4) * iTotalInstances, GL_MAP_WRITE_BIT);
-	unsigned int index = 0;
-	for (auto iter = mapEntityTransforms.begin(); iter != mapEntityTransforms.end(); iter++)
+	glNamedBufferStorage(ssboTransforms, sizeof(glm::mat4) * iSlotCapacity, sceneDesc.vcInstanceTransforms.empty() ? nullptr : sceneDesc.vcInstanceTransforms.data(), 0);
+
+	//from now on motion states write moving bodies into the staging ring, renderingsys copies them over
+	transformStaging = std::make_unique<TransformStaging>(iSlotCapacity);
+	mRegistry->view<CGeometryInstance, CPhysicsBody>().each([this](CGeometryInstance& gi, CPhysicsBody& physicsBody)
+		{
+			if (!physicsBody.rigidBody->isStaticObject())
+				static_cast<InterpMotionState*>(physicsBody.motionState)->setStagingSlot(transformStaging.get(), gi.baseInstance + gi.instanceID);
+		});
+}
+
+void GeometryLoader::initSceneBuffers(const SceneDesc& sceneDesc)
+{
+	//vertex / index / indirect buffers only depend on the scene, reuse them when still resident
+	strBuffersKey = "buffers:" + strSceneKey;
+	SceneBuffers sceneBuffers;
+	if (!resourceManager->acquire(strBuffersKey, sceneBuffers))
 	{
-		for (auto matModel : iter->second)
-			ptrBuffer[index++] = matModel;
+		sceneBuffers = createSceneBuffers(sceneDesc);
+		resourceManager->insert<SceneBuffers>(strBuffersKey, sceneBuffers, sceneBuffers.iBytes, [](SceneBuffers& sceneBuffers)
+			{
+				glDeleteBuffers(1, &sceneBuffers.drawIndirectBuffer);
+				delete sceneBuffers.geometryArena;
+				for (auto iter = sceneBuffers.mapRenderStates.begin(); iter != sceneBuffers.mapRenderStates.end(); iter++)
+					glDeleteBuffers(1, &iter->second.ssboFrag);
+			});
+	}
+	mapRenderStates = sceneBuffers.mapRenderStates;
+	drawIndirectBuffer = sceneBuffers.drawIndirectBuffer;
+	geometryArena = sceneBuffers.geometryArena;
+	vcTypeGeometry = sceneBuffers.vcTypeGeometry;
+	geoStateStencilDraw = sceneBuffers.geoStateStencilDraw;
+
+	//kd colors never change, texture handles are written every session since textures may have been evicted and reloaded meanwhile
+	for (auto iter = sceneDesc.mapRSBatches.begin(); iter != sceneDesc.mapRSBatches.end(); iter++)
+	{
+		if (iter->second.vcDrawCmd.empty())
+			continue;
+
+		const GLuint ssboFrag = mapRenderStates[iter->first].ssboFrag;
+		if (iter->first == RSType::BASIC_KD)
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, ssboFrag);
+		else
+		{
+			GLuint64* ptrBuffer = (GLuint64*)glMapNamedBufferRange(ssboFrag, 0, sizeof(GLuint64) * iter->second.vcTexNames.size(), GL_MAP_WRITE_BIT);
+			for (size_t i = 0; i < iter->second.vcTexNames.size(); i++)
+				ptrBuffer[i] = getTextureHandle(mapTextures[textureResourceKey(strAssetSrc + "models/" + iter->second.vcTexNames[i])]);
+			glUnmapNamedBuffer(ssboFrag);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ssboFrag);
+		}
 	}
-	glUnmapNamedBuffer(ssboTransforms);
 }
 
-void GeometryLoader::initBufferStorage()
+SceneBuffers GeometryLoader::createSceneBuffers(const SceneDesc& sceneDesc)
 {
+	SceneBuffers sceneBuffers;
+	std::map<RSType, RenderState>& mapRenderStates = sceneBuffers.mapRenderStates;
+	GLuint& drawIndirectBuffer = sceneBuffers.drawIndirectBuffer;
+
+	//sized for the scene and the two screen quads of a session, hot reload grows it by doubling
+	GLuint iVertices = static_cast<GLuint>(sceneDesc.stencilMesh.vertices.size() / GeometryArena::ciVertexFloats) + 8;
+	GLuint iIndices = static_cast<GLuint>(sceneDesc.stencilMesh.indices.size()) + 12;
+	for (auto iter = sceneDesc.mapRSBatches.begin(); iter != sceneDesc.mapRSBatches.end(); iter++)
+	{
+		iVertices += static_cast<GLuint>(iter->second.vertices.size() / GeometryArena::ciVertexFloats);
+		iIndices += static_cast<GLuint>(iter->second.indices.size());
+	}
+	sceneBuffers.geometryArena = new GeometryArena(iVertices, iIndices);
+	GeometryArena* geometryArena = sceneBuffers.geometryArena;
+	if (!sceneDesc.stencilMesh.indices.empty())
+		sceneBuffers.geoStateStencilDraw.geometry = geometryArena->allocate(
+			sceneDesc.stencilMesh.vertices.data(), static_cast<GLuint>(sceneDesc.stencilMesh.vertices.size() / GeometryArena::ciVertexFloats),
+			sceneDesc.stencilMesh.indices.data(), static_cast<GLuint>(sceneDesc.stencilMesh.indices.size()));
+
+	//every submesh gets a range of its own so hot reload can resize it, per instance draws share their mesh's range
+	std::map<RSType, std::vector<DrawElementsIndirectCommand>> mapDrawCmds;
+	for (auto iter = sceneDesc.mapRSBatches.begin(); iter != sceneDesc.mapRSBatches.end(); iter++)
+		mapDrawCmds[iter->first] = iter->second.vcDrawCmd;
+	sceneBuffers.vcTypeGeometry.resize(sceneDesc.entityTypes.size());
+	for (EntityTypeID typeID = 0; typeID < sceneDesc.entityTypes.size(); typeID++)
+	{
+		const EntityTypeDesc& typeDesc = sceneDesc.entityTypes[typeID];
+		for (const MeshRef& meshRef : typeDesc.vcMeshes)
+		{
+			const RSLoader& batch = sceneDesc.mapRSBatches.at(meshRef.rsType);
+			const DrawElementsIndirectCommand& cmd = batch.vcDrawCmd[meshRef.drawID];
+			const GeometryHandle geometry = geometryArena->allocate(
+				batch.vertices.data() + GeometryArena::ciVertexFloats * cmd.baseVertex, meshRef.iVertices,
+				batch.indices.data() + cmd.firstIndex, cmd.count);
+			sceneBuffers.vcTypeGeometry[typeID].emplace_back(geometry);
+
+			const GeometryRange& range = geometryArena->getRange(geometry);
+			for (GLuint iDraw = 0; iDraw < typeDesc.getDrawsPerMesh(); iDraw++)
+			{
+				DrawElementsIndirectCommand& drawCmd = mapDrawCmds[meshRef.rsType][meshRef.drawID + iDraw];
+				drawCmd.baseVertex = range.baseVertex;
+				drawCmd.firstIndex = range.firstIndex;
+			}
+		}
+	}
+
 	glGenBuffers(1, &drawIndirectBuffer);
 	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawIndirectBuffer);
-	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * ciTotalDrawCmd, NULL, GL_STATIC_DRAW);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * sceneDesc.iTotalDrawCmd, NULL, GL_STATIC_DRAW);
 
 	unsigned int drawCmdOffset = 0;
-	for (auto iter = mapRSLoaders.begin(); iter != mapRSLoaders.end(); iter++)
+	for (auto iter = sceneDesc.mapRSBatches.begin(); iter != sceneDesc.mapRSBatches.end(); iter++)
 	{
 		if (!iter->second.vcDrawCmd.empty())
 		{
 			RenderState& mapRenderState = mapRenderStates[iter->first];
-			glCreateVertexArrays(1, &mapRenderState.vao);
-
-			GLuint vbo;
-			glCreateBuffers(1, &vbo);
-			glNamedBufferStorage(vbo, sizeof(float) * iter->second.vertices.size(), &iter->second.vertices[0], 0);
-			glVertexArrayVertexBuffer(mapRenderState.vao, 0, vbo, 0, sizeof(float) * 8);
-			glVertexArrayAttribFormat(mapRenderState.vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
-			glVertexArrayAttribBinding(mapRenderState.vao, 0, 0);
-			glEnableVertexArrayAttrib(mapRenderState.vao, 0);
-			glVertexArrayAttribFormat(mapRenderState.vao, 1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3);
-			glVertexArrayAttribBinding(mapRenderState.vao, 1, 0);
-			glEnableVertexArrayAttrib(mapRenderState.vao, 1);
-			glVertexArrayAttribFormat(mapRenderState.vao, 2, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 6);
-			glVertexArrayAttribBinding(mapRenderState.vao, 2, 0);
-			glEnableVertexArrayAttrib(mapRenderState.vao, 2);
-			glDeleteBuffers(1, &vbo);
-
-			glCreateBuffers(1, &mapRenderState.ebo);
-			glNamedBufferStorage(mapRenderState.ebo, sizeof(unsigned int) * iter->second.indices.size(), &iter->second.indices[0], 0);
-			glVertexArrayElementBuffer(mapRenderState.vao, mapRenderState.ebo);
-
 			mapRenderState.drawCmdOffset = (void*)(sizeof(DrawElementsIndirectCommand) * drawCmdOffset);
 			mapRenderState.primCount = iter->second.vcDrawCmd.size();
 
@@ -119,790 +248,687 @@ void GeometryLoader::initBufferStorage()
 					GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
 
 			int index = 0;
-			for (const auto& drawCmd : iter->second.vcDrawCmd)
+			for (const auto& drawCmd : mapDrawCmds[iter->first])
 				ptrBuffer[index++] = drawCmd;
 			glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
 
 			drawCmdOffset += iter->second.vcDrawCmd.size();
 
-			//bindless tex ssbo
+			//kd colors or bindless tex handles, handles are filled in by initSceneBuffers
 			GLuint ssboFrag;
+			glCreateBuffers(1, &ssboFrag);
 			if (iter->first == RSType::BASIC_KD)
-			{
-				glCreateBuffers(1, &ssboFrag);
-				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, ssboFrag);
-				glNamedBufferStorage(ssboFrag, sizeof(glm::vec4) * iter->second.vcMeshKdColors.size(), &iter->second.vcMeshKdColors[0], 0);
-			}
+				glNamedBufferStorage(ssboFrag, sizeof(glm::vec4) * iter->second.vcMeshKdColors.size(), &iter->second.vcMeshKdColors[0], GL_DYNAMIC_STORAGE_BIT);
 			else
-			{
-				std::vector<GLuint64> vcHandles;
-				GLuint64 texHandle;
-				vcHandles.reserve(iter->second.vcTexNames.size());
-				for (auto& strTex : iter->second.vcTexNames)
-				{
-					texHandle = glGetTextureHandleARB(mapTextures[strTex]);
-					glMakeTextureHandleResidentARB(texHandle);
-					vcHandles.emplace_back(texHandle);
-				}
-				glCreateBuffers(1, &ssboFrag);
-				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ssboFrag);
-				glNamedBufferStorage(ssboFrag, sizeof(GLuint64) * vcHandles.size() * 2, &vcHandles[0], GL_MAP_WRITE_BIT);
-			}
+				glNamedBufferStorage(ssboFrag, sizeof(GLuint64) * iter->second.vcTexNames.size() * 2, nullptr, GL_MAP_WRITE_BIT);
 			mapRenderState.ssboFrag = ssboFrag;
 		}
 	}
+
+	const GeometryStats stats = geometryArena->getStats();
+	spdlog::info("Scene geometry : " + std::to_string(stats.iRanges) + " meshes, " + std::to_string(stats.iUsedBytes / 1024) + " of " + std::to_string(stats.iCapacityBytes / 1024) + " KB used");
+	sceneBuffers.iBytes = stats.iCapacityBytes + sizeof(DrawElementsIndirectCommand) * sceneDesc.iTotalDrawCmd;
+	return sceneBuffers;
 }
 
-void GeometryLoader::initGeometryInstanceData()
+CPhysicsBody GeometryLoader::createPhysicsBody(EntityTypeID typeID, const btVector3& vOrigin, float fYaw)
 {
-	for (auto iter = mapEntityTransforms.begin(); iter != mapEntityTransforms.end(); iter++)
+	CPhysicsBody physicsBody;
+	const RigidBodySpec* spec = sceneDesc->entityTypes[typeID].spec;
+	if (spec == nullptr || vcTypeShapes[typeID] == nullptr)
 	{
-		mapEntityBaseInstances[iter->first] = iTotalInstances;
-
-		tinyobj::ObjReaderConfig readerConfig;
-		readerConfig.mtl_search_path = "./";
-		tinyobj::ObjReader reader;
-		if (!reader.ParseFromFile(strAssetSrc + mapEntityModelList[iter->first]))
-		{
-			if (!reader.Error().empty())
-				spdlog::error("Reader : " + reader.Error());
-		}
-		if (!reader.Warning().empty())
-			spdlog::warn("Warning : " + reader.Warning());
+		spdlog::error("No rigid body spec for entity type : " + sceneDesc->entityTypes[typeID].strName);
+		return physicsBody;
+	}
 
-		const tinyobj::attrib_t attrib = reader.GetAttrib();
-		auto& materials = reader.GetMaterials();
-		auto& shapes = reader.GetShapes();
+	//shared by every body of this type, owned by the resource manager
+	physicsBody.collisionShape = vcTypeShapes[typeID];
+	physicsBody.bSharedShape = true;
 
-		//process textures from materials, store id to map with texname as key so the same tex isnt loaded into memory again
-		for (auto& material : materials)
-		{
-			if (!material.diffuse_texname.empty() && mapTextures.find(material.diffuse_texname) == mapTextures.end())
-				mapTextures[material.diffuse_texname] = loadTexture(strAssetSrc + "models/", material.diffuse_texname);
-		}
-
-		//load each submesh inside model
-		for (size_t s = 0; s < shapes.size(); s++)
-		{
-			//if mesh doesnt have texture, use Kd
-			RSType rsType = RSType::TEXTURED;
-			if (materials[shapes[s].mesh.material_ids[0]].diffuse_texname.empty())
-			{
-				rsType = RSType::BASIC_KD;
-				mapRSLoaders[RSType::BASIC_KD].vcMeshKdColors.emplace_back(glm::vec4(materials[shapes[s].mesh.material_ids[0]].diffuse[0], materials[shapes[s].mesh.material_ids[0]].diffuse[1], materials[shapes[s].mesh.material_ids[0]].diffuse[2], 1.f));
-			}
-			else
-			{
-				//check if mesh has emissive tex, set rendertype and use diffuse texture anyways
-				if (!materials[shapes[s].mesh.material_ids[0]].emissive_texname.empty())
-					rsType = RSType::EMISSIVE;
+	btVector3 vLocalInertia(0.f, 0.f, 0.f);
+	if (spec->fMass > 0.f)
+		physicsBody.collisionShape->calculateLocalInertia(spec->fMass, vLocalInertia);
+	btTransform transBody = createSpawnTransform(*spec, vOrigin, fYaw);
 
-				mapRSLoaders[rsType].vcTexNames.emplace_back(materials[shapes[s].mesh.material_ids[0]].diffuse_texname);
-			}
+	//only dynamic bodies go through the interpolated transform pipeline
+	if (spec->fMass > 0.f)
+		physicsBody.motionState = new InterpMotionState(transBody, motionSync);
+	else
+		physicsBody.motionState = new btDefaultMotionState(transBody);
+	btRigidBody::btRigidBodyConstructionInfo info(spec->fMass, physicsBody.motionState, physicsBody.collisionShape, vLocalInertia);
+	physicsBody.rigidBody = new btRigidBody(info);
+	physicsBody.rigidBody->setFriction(spec->fFriction);
 
-			RSLoader& rsLoader = mapRSLoaders[rsType];
-			mapEntityDrawIDs[iter->first] = rsLoader.drawID++;							//update drawID
+	return physicsBody;
+}
 
-			uint32_t count = 0;
-			std::unordered_map<VertexTupple, unsigned int, VertexTuppleHash> mapTupples;
-			unsigned int index = 0;
-			size_t iOffset = 0;
-			for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++)
-			{
-				//num vertices on each face (3 by default)
-				size_t fv = shapes[s].mesh.num_face_vertices[f];
-
-				//read each vertex attrib 
-				//in the form of tupples (v/t/n) which contain element id 
-				//and convert them into a single vertex index
-				for (size_t v = 0; v < fv; v++)
-				{
-					tinyobj::index_t idx = shapes[s].mesh.indices[iOffset + v];						//index of each tupple in file 
-
-					//check if this vertex is already loaded in buffer and given index in map
-					VertexTupple tupple(idx.vertex_index, idx.texcoord_index, idx.normal_index);
-					if (mapTupples.find(tupple) == mapTupples.end())
-					{
-						//v/n/t interleaved
-						rsLoader.vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index)]);
-						rsLoader.vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index) + 1]);
-						rsLoader.vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index) + 2]);
-
-						rsLoader.vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index)]);
-						rsLoader.vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index) + 1]);
-						rsLoader.vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index) + 2]);
-
-						rsLoader.vertices.emplace_back(attrib.texcoords[2 * size_t(idx.texcoord_index)]);
-						rsLoader.vertices.emplace_back(attrib.texcoords[2 * size_t(idx.texcoord_index) + 1]);
-
-						rsLoader.indices.emplace_back(index);
-						mapTupples[tupple] = index++;
-					}
-					else
-						rsLoader.indices.emplace_back(mapTupples[tupple]);
-
-					count++;
-				}
-
-				iOffset += fv;
-			}
+entt::entity GeometryLoader::createInvisibleWall(const btVector3& vPosition, const btVector3& vDimensions)
+{
+	auto e = mRegistry->create();
+	CPhysicsBody& physicsBody = mRegistry->emplace<CPhysicsBody>(e);
 
-			DrawElementsIndirectCommand cmd;
-			cmd.count = count;
-			cmd.instanceCount = iter->second.size();
-			cmd.baseInstance = iTotalInstances;
-			cmd.baseVertex = rsLoader.baseVertex;
-			cmd.firstIndex = rsLoader.firstIndex;
-			rsLoader.vcDrawCmd.emplace_back(cmd);
-			ciTotalDrawCmd++;										//for the indirect buffer
-
-			//update for next geometry
-			rsLoader.baseVertex = rsLoader.vertices.size() / 8;
-			rsLoader.firstIndex = rsLoader.indices.size();
-		}
+	physicsBody.collisionShape = new btBoxShape(vDimensions);
+	btTransform transform;
+	transform.setIdentity();
+	transform.setOrigin(vPosition);
+	physicsBody.motionState = new btDefaultMotionState(transform);
+	btRigidBody::btRigidBodyConstructionInfo info(0.f, physicsBody.motionState, physicsBody.collisionShape, btVector3(0.f, 0.f, 0.f));
+	physicsBody.rigidBody = new btRigidBody(info);
+	addRigidBody(physicsBody.rigidBody, e, ciGroupWall);
+	return e;
+}
 
-		//set base instance
-		iTotalInstances += iter->second.size();
-	}
+void GeometryLoader::destroyInvisibleWall(entt::entity e)
+{
+	CPhysicsBody& physicsBody = mRegistry->get<CPhysicsBody>(e);
+	dynamicsWorld->removeRigidBody(physicsBody.rigidBody);
+	delete physicsBody.motionState;
+	delete physicsBody.collisionShape;
+	delete physicsBody.rigidBody;
+	mRegistry->destroy(e);
 }
 
-void GeometryLoader::initGeometryInstances()
+//foreground quad around its scrolled tex coords, the positions never change
+static void buildBackgroundQuad(const float* texCoords, float* vertices)
 {
-	FILE* fileLevel = fopen(std::string(strAssetSrc + strLevelFile).c_str(), "r");
-	if (fileLevel != nullptr)
+	const float positions[] =
 	{
-		char szEntityType[64] = "";
-		float x = 0.f, y = 0.f, z = 0.f, yaw = 0.f;
-		float xDim = 0.f, yDim = 0.f, zDim = 0.f;
-		while (true)
-		{
-			if (fscanf(fileLevel, "%s", &szEntityType) == EOF)
-				break;
-			fscanf(fileLevel, "%f,%f,%f", &x, &y, &z);
-
-			if (strcmp(szEntityType, "wall") == 0)
-			{
-				fscanf(fileLevel, "%f,%f,%f", &xDim, &yDim, &zDim);
-				createInvisibleWall(btVector3(x, y, z), btVector3(xDim, yDim, zDim));
-			}
-			else
-			{
-				fscanf(fileLevel, "%f", &yaw);
-				if (strcmp(szEntityType, "book") == 0)
-					createBook(btVector3(x, y, z), yaw);
-				else if (strcmp(szEntityType, "desk") == 0)
-					createDesk(btVector3(x, y, z), yaw);
-				else if (strcmp(szEntityType, "keyboard") == 0)
-					createKeyboard(btVector3(x, y, z), yaw);
-				else if (strcmp(szEntityType, "shelf") == 0)
-					createShelf(btVector3(x, y, z), yaw);
-				else if (strcmp(szEntityType, "chair") == 0)
-					createChair(btVector3(x, y, z), yaw);
-				else if (strcmp(szEntityType, "monitor") == 0)
-					createMonitor(btVector3(x, y, z), yaw);
-				else if (strcmp(szEntityType, "moonLamp") == 0)
-					createMoonLamp(btVector3(x, y, z), yaw);
-				else if (strcmp(szEntityType, "plant") == 0)
-					createPlantPot(btVector3(x, y, z), yaw);
-				else if (strcmp(szEntityType, "bookShelf") == 0)
-					createBookShelf(btVector3(x, y, z), yaw);
-				else if (strcmp(szEntityType, "mug") == 0)
-					createMug(btVector3(x, y, z), yaw);
-				else  if (strcmp(szEntityType, "room") == 0)
-					createRoom(btVector3(x, y, z), yaw);
-			}
-		}
+		-1.f, 1.f, 0.f,
+		1.f, 1.f, 0.f,
+		1.f, -1.f, 0.f,
+		-1.f, -1.f, 0.f
+	};
+	for (int i = 0; i < 4; i++)
+	{
+		float* vertex = vertices + GeometryArena::ciVertexFloats * i;
+		std::copy_n(positions + 3 * i, 3, vertex);
+		std::fill_n(vertex + 3, 3, 0.f);
+		std::copy_n(texCoords + 2 * i, 2, vertex + 6);
 	}
-	else
-		spdlog::error("Failed to open Level file : " + strAssetSrc + strLevelFile);
 }
 
-entt::entity GeometryLoader::createRenderableEntity(std::string strEntityType, std::string strModelPath, const CPhysicsBody cPhysicsBody, const glm::mat4 matModel)
+GeometryState GeometryLoader::createGSBackgroundQuad(std::string strTexture)
 {
-	//entity type
-	auto e = mRegistry->create();
-	CEntityType& cEntityType = mRegistry->emplace<CEntityType>(e, strEntityType);
-
-	//instance ID
-	CGeometryInstance& cInstance = mRegistry->emplace<CGeometryInstance>(e);
-	cInstance.instanceID = mapEntityTransforms[strEntityType].size();
-
-	CPhysicsBody& physicsBody = mRegistry->emplace<CPhysicsBody>(e);
-	physicsBody = cPhysicsBody;
-	addRigidBody(physicsBody.rigidBody, e);
+	//0.5f y is for background texture 
+	float texCoords[] =
+	{
+		0.f, 0.f,
+		1.f, 0.f,
+		1.f, 0.5f,
+		0.f, 0.5f
+	};
+	unsigned int indices[]
+	{
+		0, 1, 2,
+		0, 2, 3
+	};
 
-	CTransform& transform = mRegistry->emplace<CTransform>(e);
-	transform.matModel = matModel;
+	auto e = mRegistry->create();
+	auto& cQuad = mRegistry->emplace<CBackgroundQuad>(e);
 
-	//Instance matModel
-	mapEntityTransforms[strEntityType].emplace_back(matModel);
+	//set array tex coord
+	for (int i = 0; i < 8; i++)
+		cQuad.texCoords[i] = texCoords[i];
 
-	//model list
-	initModelList(strEntityType, strModelPath);
+	//per session in the scene's arena, renderingsys frees it with the rest of the quad
+	float vertices[GeometryArena::ciVertexFloats * 4];
+	buildBackgroundQuad(texCoords, vertices);
+	geoStateBackgroundQuad.geometry = geometryArena->allocate(vertices, 4, indices, 6);
 
-	return e;
+	//this one loads png files in RGBA8 format
+	GLuint64 handle[] = { getTextureHandle(loadTextureRGBA8(strAssetSrc + "models/", strTexture)) };
+	glCreateBuffers(1, &geoStateBackgroundQuad.ssboFrag);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, geoStateBackgroundQuad.ssboFrag);
+	glNamedBufferStorage(geoStateBackgroundQuad.ssboFrag, sizeof(GLuint64) * 2, handle, 0);
+	return geoStateBackgroundQuad;
 }
 
-void GeometryLoader::initModelList(std::string strEntityType, std::string strModelPath)
+void GeometryLoader::writeBackgroundTexCoords(const float* texCoords)
 {
-	if (mapEntityModelList.find(strEntityType) == mapEntityModelList.end())
-		mapEntityModelList[strEntityType] = strModelPath;
+	float vertices[GeometryArena::ciVertexFloats * 4];
+	buildBackgroundQuad(texCoords, vertices);
+	geometryArena->writeVertices(geoStateBackgroundQuad.geometry, 0, vertices, 4);
 }
 
 
-void GeometryLoader::createBook(btVector3 vOrigin, float fYaw)
+void GeometryLoader::addRigidBody(btRigidBody* rigidBody, const entt::entity e, int iGroup)
 {
-	CPhysicsBody physicsBody;
-	physicsBody.collisionShape = new btBoxShape(btVector3(.715f, .1575f, 0.55f));
-	btScalar fMass(.5f);
-	btVector3 vLocalInertia(0.f, 0.f, 0.f);
-	physicsBody.collisionShape->calculateLocalInertia(fMass, vLocalInertia);
-	btTransform transBody;
-	transBody.setIdentity();
-	transBody.setOrigin(vOrigin);
-	btQuaternion rotation;
-	rotation.setEuler(fYaw, 0.f, 0.f);
-	transBody.setRotation(rotation);
-	physicsBody.motionState = new btDefaultMotionState(transBody);
-	btRigidBody::btRigidBodyConstructionInfo info(fMass, physicsBody.motionState, physicsBody.collisionShape, vLocalInertia);
-	physicsBody.rigidBody = new btRigidBody(info);
-	physicsBody.rigidBody->setFriction(20.f);
-	
-	//matModel
-	btScalar mat4[16];
-	transBody.getOpenGLMatrix(mat4);
+	//decativate body so it doesnt bounce around at the start
+	rigidBody->setActivationState(0);
 
-	createRenderableEntity("book", "models/book.obj", physicsBody, glm::make_mat4(mat4));
+	// every rigidbody must contain in entt::entity in their userindex so its easy to work on them through entt::registry by physicsSys
+	// also this func is created so as not to forget to add entity e to userIndex of rigidbody before adding to dynamicWorld
+	// entt::entity is just uint32_t, hence why casting it to int
+	rigidBody->setUserIndex(static_cast<int>(e));
+	//walls and static props never get a pair with each other, pick rays only see dynamic bodies
+	dynamicsWorld->addRigidBody(rigidBody, iGroup, getCollisionMask(iGroup));
 }
 
-void GeometryLoader::createDesk(btVector3 vOrigin, float fYaw)
+
+GLuint GeometryLoader::uploadTexture(const TexturePayload& payload)
 {
-	CPhysicsBody physicsBody;
-	physicsBody.collisionShape = new btBoxShape(btVector3(2.f, 2.47f, 4.71f));
-	btVector3 vLocalInertia(0.f, 0.f, 0.f);
-	physicsBody.collisionShape->calculateLocalInertia(0.f, vLocalInertia);
-	btTransform transBody;
-	transBody.setIdentity();
-	transBody.setOrigin(vOrigin);
-	physicsBody.motionState = new btDefaultMotionState(transBody);
-	btRigidBody::btRigidBodyConstructionInfo info(0.f, physicsBody.motionState, physicsBody.collisionShape, vLocalInertia);
-	physicsBody.rigidBody = new btRigidBody(info);
-	physicsBody.rigidBody->setFriction(20.f);
+	if (TextureArrays* textureArrays = TextureArrays::get())
+		return textureArrays->add(payload);
+
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	// set the texture wrapping/filtering options (on the currently bound texture object)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	btScalar mat4[16];
-	transBody.getOpenGLMatrix(mat4);
+	//failed decodes leave an empty texture behind, same as before
+	if (!payload.vcPixels.empty())
+	{
+		if (payload.iChannels == 4)
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, payload.iWidth, payload.iHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, payload.vcPixels.data());
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, payload.iWidth, payload.iHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, payload.vcPixels.data());
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
 
-	createRenderableEntity("desk", "models/desk.obj", physicsBody, glm::make_mat4(mat4));
+	return texture;
 }
 
-void GeometryLoader::createShelf(btVector3 vOrigin, float fYaw)
+void GeometryLoader::freeTexture(GLuint& texture)
 {
-	CPhysicsBody physicsBody;
-	physicsBody.collisionShape = createTriangleMeshShape(physicsBody, strAssetSrc + "./models/lowPoly/shelf.obj");
-	btTransform transBody;
-	transBody.setIdentity();
-	transBody.setOrigin(vOrigin);
-	physicsBody.motionState = new btDefaultMotionState(transBody);
-	physicsBody.rigidBody = new btRigidBody(0, physicsBody.motionState, physicsBody.collisionShape);
-
-	btScalar mat4[16];
-	transBody.getOpenGLMatrix(mat4);
-
-	createRenderableEntity("shelf", "models/shelf.obj", physicsBody, glm::make_mat4(mat4));
+	if (TextureArrays* textureArrays = TextureArrays::get())
+		textureArrays->free(texture);
+	else
+		glDeleteTextures(1, &texture);
 }
 
-void GeometryLoader::createKeyboard(btVector3 vOrigin, float fYaw)
+GLuint64 GeometryLoader::getTextureHandle(GLuint texture)
 {
-	CPhysicsBody physicsBody;
-	physicsBody.collisionShape = new btBoxShape(btVector3(0.525f, .0565f, 1.72f));
-	btScalar fMass(.3f);
-	btVector3 vLocalInertia(0.f, 0.f, 0.f);
-	physicsBody.collisionShape->calculateLocalInertia(fMass, vLocalInertia);
-	btTransform transBody;
-	transBody.setIdentity();
-	transBody.setOrigin(vOrigin);
-	btQuaternion rotation;
-	rotation.setEuler(fYaw, 0.f, 0.f);
-	transBody.setRotation(rotation);
-	physicsBody.motionState = new btDefaultMotionState(transBody);
-	btRigidBody::btRigidBodyConstructionInfo info(fMass, physicsBody.motionState, physicsBody.collisionShape, vLocalInertia);
-	physicsBody.rigidBody = new btRigidBody(info);
-	physicsBody.rigidBody->setFriction(20.f);
-
-	btScalar mat4[16];
-	transBody.getOpenGLMatrix(mat4);
-
-	createRenderableEntity("keyboard", "models/keyboard.obj", physicsBody, glm::make_mat4(mat4));
+	if (TextureArrays* textureArrays = TextureArrays::get())
+		return textureArrays->getLayerHandle(texture);
+
+	//resident textures outlive play sessions, making a handle resident twice is an error
+	GLuint64 handle = glGetTextureHandleARB(texture);
+	if (!glIsTextureHandleResidentARB(handle))
+		glMakeTextureHandleResidentARB(handle);
+	return handle;
 }
 
-void GeometryLoader::createPlantPot(btVector3 vOrigin, float fYaw)
+GLuint GeometryLoader::acquireTexture(const std::string& strKey, const TexturePayload& payload)
 {
-	CPhysicsBody physicsBody;
-	physicsBody.collisionShape = new btCylinderShape(btVector3(0.505f, 0.85f, .505f));
-	btScalar fMass(1.5f);
-	btVector3 vLocalInertia(0.f, 0.f, 0.f);
-	physicsBody.collisionShape->calculateLocalInertia(fMass, vLocalInertia);
-	btTransform transBody;
-	transBody.setIdentity();
-	transBody.setOrigin(vOrigin);
-	physicsBody.motionState = new btDefaultMotionState(transBody);
-	btRigidBody::btRigidBodyConstructionInfo info(fMass, physicsBody.motionState, physicsBody.collisionShape, vLocalInertia);
-	physicsBody.rigidBody = new btRigidBody(info);
-	physicsBody.rigidBody->setFriction(20.f);
-
-	btScalar mat4[16];
-	transBody.getOpenGLMatrix(mat4);
-
-	createRenderableEntity("plant", "models/plant.obj", physicsBody, glm::make_mat4(mat4));
+	GLuint texture = 0;
+	if (!resourceManager->acquire(strKey, texture))
+	{
+		texture = uploadTexture(payload);
+		resourceManager->insert<GLuint>(strKey, texture, payload.vcPixels.size() * 4 / 3, freeTexture);
+	}
+	return texture;
 }
 
-void GeometryLoader::createBookShelf(btVector3 vOrigin, float fYaw)
+GLuint GeometryLoader::loadTexture(std::string strSrc, std::string strFilename, int iChannels)
 {
-	CPhysicsBody physicsBody;
-	physicsBody.collisionShape = new btBoxShape(btVector3(.755f, .0605f, 3.015f));
-	btTransform transBody;
-	transBody.setIdentity();
-	transBody.setOrigin(vOrigin);
-	btQuaternion rotation;
-	rotation.setEuler(fYaw, 0.f, 0.f);
-	transBody.setRotation(rotation);
-	physicsBody.motionState = new btDefaultMotionState(transBody);
-	btRigidBody::btRigidBodyConstructionInfo info(0.f, physicsBody.motionState, physicsBody.collisionShape);
-	physicsBody.rigidBody = new btRigidBody(info);
-	physicsBody.rigidBody->setFriction(20.f);
-
-	btScalar mat4[16];
-	transBody.getOpenGLMatrix(mat4);
-
-	createRenderableEntity("bookShelf", "models/bookShelf.obj", physicsBody, glm::make_mat4(mat4));
+	const std::string strKey = textureResourceKey(strSrc + strFilename);
+	auto iter = mapTextures.find(strKey);
+	if (iter != mapTextures.end())
+		return iter->second;
+
+	//only decode when it isnt resident anymore
+	GLuint texture = 0;
+	if (!resourceManager->acquire(strKey, texture))
+	{
+		TexturePayload payload;
+		SceneBuilder::decodeTexture(strSrc + strFilename, iChannels, payload);
+		texture = uploadTexture(payload);
+		resourceManager->insert<GLuint>(strKey, texture, payload.vcPixels.size() * 4 / 3, freeTexture);
+	}
+	mapTextures[strKey] = texture;
+	return texture;
 }
 
+GLuint GeometryLoader::loadTextureRGBA8(std::string strSrc, std::string strFilename)
+{
+	return loadTexture(strSrc, strFilename, 4);
+}
 
-void GeometryLoader::createMoonLamp(btVector3 vOrigin, float fYaw)
+bool GeometryLoader::applyLevel(const std::vector<LevelEntity>& vcLevel)
 {
-	CPhysicsBody physicsBody;
-	physicsBody.collisionShape = new btSphereShape(0.505f);
-	btScalar fMass(.2f);
-	btVector3 vLocalInertia(0.f, 0.f, 0.f);
-	physicsBody.collisionShape->calculateLocalInertia(fMass, vLocalInertia);
-	btTransform transBody;
-	transBody.setIdentity();
-	transBody.setOrigin(vOrigin);
-	btQuaternion rotation;
-	rotation.setEuler(fYaw, 0.f, 0.f);
-	transBody.setRotation(rotation);
-	physicsBody.motionState = new btDefaultMotionState(transBody);
-	btRigidBody::btRigidBodyConstructionInfo info(fMass, physicsBody.motionState, physicsBody.collisionShape, vLocalInertia);
-	physicsBody.rigidBody = new btRigidBody(info);
-	physicsBody.rigidBody->setFriction(100.f);
+	//the kth entity of a type in the file is the kth live entity of that type
+	const EntityTypeTable& entityTypes = sceneDesc->entityTypes;
+	std::vector<std::vector<size_t>> vcLive(entityTypes.size());
+	for (size_t i = 0; i < vcLiveEntities.size(); i++)
+		vcLive[vcLiveEntities[i].typeID].emplace_back(i);
+
+	std::vector<size_t> vcMatched(entityTypes.size(), 0);
+	std::vector<LiveEntity> vcSpawned;
+	bool bComplete = true;
+	unsigned int iPlaced = 0, iDespawned = 0;
+	for (const auto& levelEntity : vcLevel)
+	{
+		if (levelEntity.strEntityType == "room" || (levelEntity.strEntityType != "wall" && findRigidBodySpec(levelEntity.strEntityType) == nullptr))
+			continue;
 
-	btScalar mat4[16];
-	transBody.getOpenGLMatrix(mat4);
+		//a type the scene wasnt built with has no model or shape loaded yet
+		const EntityTypeID typeID = entityTypes.find(levelEntity.strEntityType);
+		if (typeID == ciInvalidEntityType)
+		{
+			spdlog::warn("Hot reload cant add the new type " + levelEntity.strEntityType + " to the running scene, re-enter the room to load it");
+			bComplete = false;
+			continue;
+		}
 
-	createRenderableEntity("moonLamp", "models/moonLamp.obj", physicsBody, glm::make_mat4(mat4));
-}
+		if (vcMatched[typeID] < vcLive[typeID].size())
+		{
+			LiveEntity& liveEntity = vcLiveEntities[vcLive[typeID][vcMatched[typeID]++]];
+			if (liveEntity.vOrigin != levelEntity.vOrigin || liveEntity.fYaw != levelEntity.fYaw || liveEntity.vDimensions != levelEntity.vDimensions)
+			{
+				placeEntity(liveEntity, levelEntity);
+				iPlaced++;
+			}
+			continue;
+		}
 
-void GeometryLoader::createMug(btVector3 vOrigin, float fYaw)
-{
-	CPhysicsBody physicsBody;
-	physicsBody.collisionShape = new btCylinderShape(btVector3(0.4f, 0.40f, .45f));
-	btScalar fMass(0.2f);
-	btVector3 vLocalInertia(0.f, 0.f, 0.f);
-	physicsBody.collisionShape->calculateLocalInertia(fMass, vLocalInertia);
-	btTransform transBody;
-	transBody.setIdentity();
-	transBody.setOrigin(vOrigin);
-	physicsBody.motionState = new btDefaultMotionState(transBody);
-	btRigidBody::btRigidBodyConstructionInfo info(fMass, physicsBody.motionState, physicsBody.collisionShape, vLocalInertia);
-	physicsBody.rigidBody = new btRigidBody(info);
-	physicsBody.rigidBody->setFriction(20.f);
+		//more of a type than before
+		LiveEntity liveEntity;
+		liveEntity.typeID = typeID;
+		liveEntity.vOrigin = levelEntity.vOrigin;
+		liveEntity.fYaw = levelEntity.fYaw;
+		liveEntity.vDimensions = levelEntity.vDimensions;
+		liveEntity.bRenderable = entityTypes[typeID].spec != nullptr;
+		if (liveEntity.bRenderable)
+			liveEntity.e = spawnEntity(typeID, levelEntity.vOrigin, levelEntity.fYaw);
+		else
+			liveEntity.e = createInvisibleWall(levelEntity.vOrigin, levelEntity.vDimensions);
+		if (liveEntity.e == entt::null)
+			bComplete = false;
+		else
+			vcSpawned.emplace_back(liveEntity);
+	}
 
-	btScalar mat4[16];
-	transBody.getOpenGLMatrix(mat4);
+	//whatever wasnt matched got removed from the file
+	for (EntityTypeID typeID = 0; typeID < entityTypes.size(); typeID++)
+	{
+		for (size_t i = vcMatched[typeID]; i < vcLive[typeID].size(); i++)
+		{
+			LiveEntity& liveEntity = vcLiveEntities[vcLive[typeID][i]];
+			if (liveEntity.bRenderable && !despawnEntity(liveEntity.e))
+			{
+				bComplete = false;
+				continue;
+			}
+			if (!liveEntity.bRenderable)
+				destroyInvisibleWall(liveEntity.e);
+			liveEntity.e = entt::null;
+			iDespawned++;
+		}
+	}
+	vcLiveEntities.erase(std::remove_if(vcLiveEntities.begin(), vcLiveEntities.end(), [](const LiveEntity& liveEntity) { return liveEntity.e == entt::null; }), vcLiveEntities.end());
+	vcLiveEntities.insert(vcLiveEntities.end(), vcSpawned.begin(), vcSpawned.end());
 
-	createRenderableEntity("mug", "models/mug.obj", physicsBody, glm::make_mat4(mat4));
+	if (iPlaced > 0 || iDespawned > 0 || !vcSpawned.empty() || !bComplete)
+		invalidateScene();
+	spdlog::info("Level diff : " + std::to_string(iPlaced) + " placed, " + std::to_string(vcSpawned.size()) + " added, " + std::to_string(iDespawned) + " removed");
+	return bComplete;
 }
 
-void GeometryLoader::createChair(btVector3 vOrigin, float fYaw)
+void GeometryLoader::placeEntity(LiveEntity& liveEntity, const LevelEntity& levelEntity)
 {
-	std::string strModelPath = "models/chair.obj";
-	CPhysicsBody physicsBody; 
-	physicsBody.collisionShape = createConvexHullShape(strAssetSrc, strModelPath);
-	btScalar fMass(30.f);
-	btVector3 vLocalInertia(0.f, 0.f, 0.f);
-	physicsBody.collisionShape->calculateLocalInertia(fMass, vLocalInertia);
-	btTransform transBody;
-	transBody.setIdentity();
-	transBody.setOrigin(vOrigin);
-	btQuaternion rotation;
-	rotation.setEuler(fYaw, 0.f, 0.f);
-	transBody.setRotation(rotation);
-	physicsBody.motionState = new btDefaultMotionState(transBody);
-	btRigidBody::btRigidBodyConstructionInfo info(fMass, physicsBody.motionState, physicsBody.collisionShape, vLocalInertia);
-	physicsBody.rigidBody = new btRigidBody(info);
-	physicsBody.rigidBody->setFriction(20.f);
+	liveEntity.vOrigin = levelEntity.vOrigin;
+	liveEntity.fYaw = levelEntity.fYaw;
+	liveEntity.vDimensions = levelEntity.vDimensions;
 
-	btScalar mat4[16];
-	transBody.getOpenGLMatrix(mat4);
+	//walls own their box shape, cheaper to build a new one than to resize it
+	if (!liveEntity.bRenderable)
+	{
+		destroyInvisibleWall(liveEntity.e);
+		liveEntity.e = createInvisibleWall(levelEntity.vOrigin, levelEntity.vDimensions);
+		return;
+	}
 
-	createRenderableEntity("chair", strModelPath, physicsBody, glm::make_mat4(mat4));
+	//teleport, twice through the motion state so an interpolated body doesnt blend from the old spot
+	CPhysicsBody& physicsBody = mRegistry->get<CPhysicsBody>(liveEntity.e);
+	btRigidBody* rigidBody = physicsBody.rigidBody;
+	btTransform transBody = createSpawnTransform(*sceneDesc->entityTypes[liveEntity.typeID].spec, levelEntity.vOrigin, levelEntity.fYaw);
+	rigidBody->setWorldTransform(transBody);
+	rigidBody->setInterpolationWorldTransform(transBody);
+	rigidBody->setLinearVelocity(btVector3(0.f, 0.f, 0.f));
+	rigidBody->setAngularVelocity(btVector3(0.f, 0.f, 0.f));
+	rigidBody->clearForces();
+	physicsBody.motionState->setWorldTransform(transBody);
+	physicsBody.motionState->setWorldTransform(transBody);
+	dynamicsWorld->updateSingleAabb(rigidBody);
+
+	//static bodies never reach the staging buffer through their motion state
+	const CGeometryInstance& cInstance = mRegistry->get<CGeometryInstance>(liveEntity.e);
+	transBody.getOpenGLMatrix(transformStaging->mapSlot(cInstance.baseInstance + cInstance.instanceID));
+	transBody.getOpenGLMatrix(glm::value_ptr(mRegistry->get<CTransform>(liveEntity.e).matModel));
 }
 
-void GeometryLoader::createMonitor(btVector3 vOrigin, float fYaw)
+entt::entity GeometryLoader::spawnEntity(EntityTypeID typeID, const btVector3& vOrigin, float fYaw)
 {
-	const std::string strEntityType = "crt" + std::to_string(ciCRT++);
+	const EntityTypeDesc& typeDesc = sceneDesc->entityTypes[typeID];
+	if (typeDesc.spec == nullptr || typeDesc.vcMeshes.empty())
+	{
+		spdlog::warn("Cant spawn a " + typeDesc.strName + ", the scene has no model for it");
+		return entt::null;
+	}
 
-	CPhysicsBody physicsBody;
-	physicsBody.collisionShape = new btBoxShape(btVector3(1.11f, 1.11f, 1.11f));
-	btScalar fMass(8.f);
-	btVector3 vLocalInertia(0.f, 0.f, 0.f);
-	physicsBody.collisionShape->calculateLocalInertia(fMass, vLocalInertia);
-	btTransform transBody;
-	transBody.setIdentity();
-	transBody.setOrigin(vOrigin);
-	btQuaternion rotation;
-	rotation.setEuler(fYaw, 0.f, 0.f);
-	transBody.setRotation(rotation);
-	physicsBody.motionState = new btDefaultMotionState(transBody);
-	btRigidBody::btRigidBodyConstructionInfo info(fMass, physicsBody.motionState, physicsBody.collisionShape, vLocalInertia);
-	physicsBody.rigidBody = new btRigidBody(info);
-	physicsBody.rigidBody->setFriction(20.f);
+	const GLuint baseBefore = instanceAllocator.getBlock(typeID).base;
+	const GLuint iUsedBefore = instanceAllocator.getBlock(typeID).iUsed;
+	const GLuint instanceID = instanceAllocator.allocate(typeID);
+	if (instanceID == InstanceAllocator::ciInvalidInstance)
+	{
+		spdlog::warn("Every " + typeDesc.strName + " owns a draw, only ones removed before can be added again");
+		return entt::null;
+	}
 
-	btScalar mat4[16];
-	transBody.getOpenGLMatrix(mat4);
+	//the block may have grown past the ssbo or moved, both before the new instance writes its slot
+	const InstanceBlock& block = instanceAllocator.getBlock(typeID);
+	reserveSlots();
+	if (block.base != baseBefore)
+		relocateInstances(typeID);
+	if (!typeDesc.bDrawPerInstance && (block.base != baseBefore || block.iUsed != iUsedBefore))
+		vcDirtyDraws[typeID] = true;
+
+	btTransform transBody = createSpawnTransform(*typeDesc.spec, vOrigin, fYaw);
+	glm::mat4 matModel;
+	transBody.getOpenGLMatrix(glm::value_ptr(matModel));
+	entt::entity e = createInstance(typeID, instanceID, vOrigin, fYaw, matModel);
+
+	//a new body sleeps like the ones loaded with the scene, so its motion state wont write the first transform
+	const GLuint iSlot = block.base + instanceID;
+	CPhysicsBody& physicsBody = mRegistry->get<CPhysicsBody>(e);
+	if (!physicsBody.rigidBody->isStaticObject())
+		static_cast<InterpMotionState*>(physicsBody.motionState)->setStagingSlot(transformStaging.get(), iSlot);
+	std::copy_n(glm::value_ptr(matModel), 16, transformStaging->mapSlot(iSlot));
+	return e;
+}
 
-	//all 4 crts act as 4 different entities but share same model
-	entt::entity e = createRenderableEntity(strEntityType, "models/crt.obj", physicsBody, glm::make_mat4(mat4));
+bool GeometryLoader::despawnEntity(entt::entity e)
+{
+	//the pick constraint still holds the body
+	if (mRegistry->view<CPickedBody>().contains(e))
+	{
+		spdlog::warn("Cant remove a body while it is picked up");
+		return false;
+	}
 
-	//init emissive display for animation
-	mRegistry->emplace<CCRTDisplay>(e);
+	const EntityTypeID typeID = mRegistry->get<CEntityType>(e).typeID;
+	const CGeometryInstance cInstance = mRegistry->get<CGeometryInstance>(e);
+	CPhysicsBody& physicsBody = mRegistry->get<CPhysicsBody>(e);
+	dynamicsWorld->removeRigidBody(physicsBody.rigidBody);
+	if (!physicsBody.rigidBody->isStaticObject())
+		motionSync->remove(static_cast<InterpMotionState*>(physicsBody.motionState));
+	delete physicsBody.motionState;
+	delete physicsBody.rigidBody;
+	mRegistry->destroy(e);
+
+	//a zero matrix collapses every vertex of the instance until the slot is reused or the draw shrinks past it
+	std::fill_n(transformStaging->mapSlot(cInstance.baseInstance + cInstance.instanceID), 16, 0.f);
+	const GLuint iUsedBefore = instanceAllocator.getBlock(typeID).iUsed;
+	instanceAllocator.free(typeID, cInstance.instanceID);
+	if (!sceneDesc->entityTypes[typeID].bDrawPerInstance && instanceAllocator.getBlock(typeID).iUsed != iUsedBefore)
+		vcDirtyDraws[typeID] = true;
+	return true;
 }
 
-void GeometryLoader::createRoom(btVector3 vOrigin, float fYaw)
+void GeometryLoader::setSlotEntity(GLuint iSlot, entt::entity e)
 {
-	initModelList("room", "models/room.obj");
-	geoStateStencilDraw = createGSStencilDraw("room");
+	if (iSlot >= vcSlotEntities.size())
+		vcSlotEntities.resize(std::max<size_t>(iSlot + 1, iSlotCapacity), entt::null);
+	vcSlotEntities[iSlot] = e;
 }
 
-void GeometryLoader::createInvisibleWall(const btVector3& vPosition, const btVector3& vDimensions)
+entt::entity GeometryLoader::getSlotEntity(GLuint iSlot) const
 {
-	auto e = mRegistry->create();
-	CPhysicsBody& physicsBody = mRegistry->emplace<CPhysicsBody>(e);
-
-	physicsBody.collisionShape = new btBoxShape(vDimensions);
-	btTransform transform;
-	transform.setIdentity();
-	transform.setOrigin(vPosition);
-	physicsBody.motionState = new btDefaultMotionState(transform);
-	btRigidBody::btRigidBodyConstructionInfo info(0.f, physicsBody.motionState, physicsBody.collisionShape, btVector3(0.f, 0.f, 0.f));
-	physicsBody.rigidBody = new btRigidBody(info);
-	addRigidBody(physicsBody.rigidBody, e);
+	//moved or despawned instances leave their old slot behind, only trust it if the entity still sits there
+	if (iSlot >= vcSlotEntities.size())
+		return entt::null;
+	const entt::entity e = vcSlotEntities[iSlot];
+	if (!mRegistry->valid(e))
+		return entt::null;
+	const CGeometryInstance* cInstance = mRegistry->try_get<CGeometryInstance>(e);
+	return cInstance != nullptr && cInstance->baseInstance + cInstance->instanceID == iSlot ? e : entt::null;
 }
 
-GeometryState GeometryLoader::createGSStencilDraw(std::string strEntityType)
+void GeometryLoader::reserveSlots()
 {
-	tinyobj::ObjReaderConfig readerConfig;
-	readerConfig.mtl_search_path = "./";
-	tinyobj::ObjReader reader;
-	if (!reader.ParseFromFile(strAssetSrc + mapEntityModelList[strEntityType]))
-	{
-		if (!reader.Error().empty())
-			spdlog::error("Reader : " + reader.Error());
-	}
-	if (!reader.Warning().empty())
-		spdlog::warn("Warning : " + reader.Warning());
+	const GLuint iSlotEnd = instanceAllocator.getSlotEnd();
+	if (iSlotEnd <= iSlotCapacity)
+		return;
+
+	//doubling, the old transforms are copied on the gpu so only the new slots go through staging
+	GLuint iCapacity = iSlotCapacity;
+	while (iCapacity < iSlotEnd)
+		iCapacity *= 2;
+
+	GLuint ssboGrown;
+	glCreateBuffers(1, &ssboGrown);
+	glNamedBufferStorage(ssboGrown, sizeof(glm::mat4) * iCapacity, nullptr, 0);
+	glCopyNamedBufferSubData(ssboTransforms, ssboGrown, 0, 0, sizeof(glm::mat4) * iSlotCapacity);
+	glDeleteBuffers(1, &ssboTransforms);
+	ssboTransforms = ssboGrown;
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboTransforms);
 
-	const tinyobj::attrib_t attrib = reader.GetAttrib();
-	auto& materials = reader.GetMaterials();
-	auto& shapes = reader.GetShapes();
+	transformStaging->grow(iCapacity);
+	iSlotCapacity = iCapacity;
+}
 
-	//load each submesh inside model
-	std::vector<float> vertices;
-	std::vector<unsigned int> indices;
-	for (size_t s = 0; s < shapes.size(); s++)
+void GeometryLoader::relocateInstances(EntityTypeID typeID)
+{
+	//the block moved, every instance is written to its new slot through staging
+	//writes to the old slots still in the ring are harmless, whoever reuses those slots writes them after
+	const GLuint base = instanceAllocator.getBlock(typeID).base;
+	auto view = mRegistry->view<CEntityType, CGeometryInstance, CPhysicsBody, CTransform>();
+	for (auto entity : view)
 	{
-		std::unordered_map<VertexTupple, unsigned int, VertexTuppleHash> mapTupples;
-		unsigned int index = 0;
-		size_t iOffset = 0;
-		for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++)
+		if (view.get<CEntityType>(entity).typeID != typeID)
+			continue;
+
+		CGeometryInstance& cInstance = view.get<CGeometryInstance>(entity);
+		cInstance.baseInstance = base;
+		const GLuint iSlot = base + cInstance.instanceID;
+		setSlotEntity(iSlot, entity);
+		CPhysicsBody& physicsBody = view.get<CPhysicsBody>(entity);
+		if (physicsBody.rigidBody->isStaticObject())
 		{
-			//num vertices on each face (3 by default)
-			size_t fv = shapes[s].mesh.num_face_vertices[f];
-
-			for (size_t v = 0; v < fv; v++)
-			{
-				tinyobj::index_t idx = shapes[s].mesh.indices[iOffset + v];						//index of each tupple in file 
-
-				//check if this vertex is already loaded in buffer and given index in map
-				VertexTupple tupple(idx.vertex_index, idx.texcoord_index, idx.normal_index);
-				if (mapTupples.find(tupple) == mapTupples.end())
-				{
-					//v/n/t interleaved
-					vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index)]);
-					vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index) + 1]);
-					vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index) + 2]);
-
-					vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index)]);
-					vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index) + 1]);
-					vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index) + 2]);
-
-					vertices.emplace_back(attrib.texcoords[2 * size_t(idx.texcoord_index)]);
-					vertices.emplace_back(attrib.texcoords[2 * size_t(idx.texcoord_index) + 1]);
-
-					indices.emplace_back(index);
-					mapTupples[tupple] = index++;
-				}
-				else
-					indices.emplace_back(mapTupples[tupple]);
-
-			}
-
-			iOffset += fv;
+			std::copy_n(glm::value_ptr(view.get<CTransform>(entity).matModel), 16, transformStaging->mapSlot(iSlot));
+			continue;
 		}
-	}
 
-	GLuint vbo;
-	GeometryState geoState;
-	glCreateVertexArrays(1, &geoState.vao);
-	glCreateBuffers(1, &vbo);
-	glNamedBufferStorage(vbo, sizeof(float) * vertices.size(), &vertices[0], 0);
-	glVertexArrayVertexBuffer(geoState.vao, 0, vbo, 0, sizeof(float) * 8);
-	glVertexArrayAttribFormat(geoState.vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
-	glVertexArrayAttribBinding(geoState.vao, 0, 0);
-	glEnableVertexArrayAttrib(geoState.vao, 0);
-	glVertexArrayAttribFormat(geoState.vao, 1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3);
-	glVertexArrayAttribBinding(geoState.vao, 1, 0);
-	glEnableVertexArrayAttrib(geoState.vao, 1);
-	glVertexArrayAttribFormat(geoState.vao, 2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 6);
-	glVertexArrayAttribBinding(geoState.vao, 2, 0);
-	glEnableVertexArrayAttrib(geoState.vao, 2);
-	glDeleteBuffers(1, &vbo);
-
-	glCreateBuffers(1, &geoState.ebo);
-	glNamedBufferStorage(geoState.ebo, sizeof(unsigned int) * indices.size(), &indices[0], 0);
-	glVertexArrayElementBuffer(geoState.vao, geoState.ebo);
-	geoState.count = indices.size();
-	return geoState;
+		InterpMotionState* motionState = static_cast<InterpMotionState*>(physicsBody.motionState);
+		motionState->setStagingSlot(transformStaging.get(), iSlot);
+		motionState->getCurrentTransform().getOpenGLMatrix(transformStaging->mapSlot(iSlot));
+	}
 }
 
-GeometryState GeometryLoader::createGSBackgroundQuad(std::string strTexture)
+void GeometryLoader::syncDrawCommands()
 {
-	float vertices[] =
+	for (EntityTypeID typeID = 0; typeID < vcDirtyDraws.size(); typeID++)
 	{
-		-1.f, 1.f, 0.f,
-		1.f, 1.f, 0.f,
-		1.f, -1.f, 0.f,
-		-1.f, -1.f, 0.f
-	};
-	//0.5f y is for background texture 
-	float texCoords[] =
-	{
-		0.f, 0.f,
-		1.f, 0.f,
-		1.f, 0.5f,
-		0.f, 0.5f
-	};
-	unsigned int indices[]
-	{
-		0, 1, 2,
-		0, 2, 3
-	};
-
-	auto e = mRegistry->create();
-	auto& cQuad = mRegistry->emplace<CBackgroundQuad>(e);
-
-	//set array tex coord
-	for (int i = 0; i < 8; i++)
-		cQuad.texCoords[i] = texCoords[i];
+		if (!vcDirtyDraws[typeID])
+			continue;
 
-	glCreateVertexArrays(1, &geoStateBackgroundQuad.vao);
-	
-	GLuint vboVert;
-	glCreateBuffers(1, &vboVert);
-	glNamedBufferStorage(vboVert, sizeof(float) * 12, vertices, 0);
-	glVertexArrayVertexBuffer(geoStateBackgroundQuad.vao, 0, vboVert, 0, sizeof(float) * 3);
-	glVertexArrayAttribFormat(geoStateBackgroundQuad.vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
-	glVertexArrayAttribBinding(geoStateBackgroundQuad.vao, 0, 0);
-	glEnableVertexArrayAttrib(geoStateBackgroundQuad.vao, 0);
-	glCreateBuffers(1, &cQuad.vboTex);
-	glNamedBufferStorage(cQuad.vboTex, sizeof(float) * 8, texCoords, GL_MAP_WRITE_BIT);
-	glVertexArrayVertexBuffer(geoStateBackgroundQuad.vao, 1, cQuad.vboTex, 0, sizeof(float) * 2);
-	glVertexArrayAttribFormat(geoStateBackgroundQuad.vao, 2, 2, GL_FLOAT, GL_FALSE, 0);
-	glVertexArrayAttribBinding(geoStateBackgroundQuad.vao, 2, 1);
-	glEnableVertexArrayAttrib(geoStateBackgroundQuad.vao, 2);
-	glDeleteBuffers(1, &vboVert);
-
-	glCreateBuffers(1, &geoStateBackgroundQuad.ebo);
-	glNamedBufferStorage(geoStateBackgroundQuad.ebo, sizeof(unsigned int) * 6, indices, 0);
-	glVertexArrayElementBuffer(geoStateBackgroundQuad.vao, geoStateBackgroundQuad.ebo);
-
-	//this one loads png files in RGBA8 format
-	GLuint64 handle[] = { glGetTextureHandleARB(loadTextureRGBA8(strAssetSrc + "models/", strTexture)) };
-	glMakeTextureHandleResidentARB(handle[0]);
-	glCreateBuffers(1, &geoStateBackgroundQuad.ssboFrag);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, geoStateBackgroundQuad.ssboFrag);
-	glNamedBufferStorage(geoStateBackgroundQuad.ssboFrag, sizeof(GLuint64) * 2, handle, 0);
-
-	geoStateBackgroundQuad.count = 6;
-	return geoStateBackgroundQuad;
+		const InstanceBlock& block = instanceAllocator.getBlock(typeID);
+		writeDrawCommands(typeID, block.iUsed, block.base);
+		vcDirtyDraws[typeID] = false;
+		vcMovedDraws[typeID] = true;
+	}
 }
 
-
-btTriangleMeshShape* GeometryLoader::createTriangleMeshShape(CPhysicsBody& physicsBody, std::string strSrcFile)
+void GeometryLoader::writeDrawCommands(EntityTypeID typeID, GLuint instanceCount, GLuint baseInstance)
 {
-	//reads low poly version of the original rendered mesh for obvious performance reasons
-	tinyobj::ObjReader reader;
-	if (!reader.ParseFromFile(strSrcFile))
+	//one command per submesh, the index count may have been patched by hot reload so leave it alone
+	for (auto& meshRef : sceneDesc->entityTypes[typeID].vcMeshes)
 	{
-		if (!reader.Error().empty())
-			spdlog::error("Reader : " + reader.Error());
+		const size_t iCmdOffset = reinterpret_cast<size_t>(mapRenderStates[meshRef.rsType].drawCmdOffset) + sizeof(DrawElementsIndirectCommand) * meshRef.drawID;
+		glNamedBufferSubData(drawIndirectBuffer, iCmdOffset + offsetof(DrawElementsIndirectCommand, instanceCount), sizeof(GLuint), &instanceCount);
+		glNamedBufferSubData(drawIndirectBuffer, iCmdOffset + offsetof(DrawElementsIndirectCommand, baseInstance), sizeof(GLuint), &baseInstance);
 	}
-	if (!reader.Warning().empty())
-		spdlog::warn("Warn : " + reader.Warning());
-
-	auto attribVertices = reader.GetAttrib().vertices;
-	auto shape = reader.GetShapes()[0];
-
-	//allocation of vertex and index data is neccessary so it isnt lost when out of the scope of this function 
-	btScalar* vertices = new btScalar[attribVertices.size()];
-	std::copy(attribVertices.begin(), attribVertices.end(), vertices);
-
-	short* indices = new short[shape.mesh.indices.size()];
-	unsigned short index = 0;
-	for (auto& i : shape.mesh.indices)
-		indices[index++] = i.vertex_index;
-
-	btTriangleIndexVertexArray* meshInterface = new btTriangleIndexVertexArray();
-	btIndexedMesh part;
-	part.m_vertexBase = (const unsigned char*)vertices;
-	part.m_numVertices = attribVertices.size();
-	part.m_vertexStride = sizeof(btScalar) * 3;
-	part.m_triangleIndexBase = (const unsigned char*)indices;
-	part.m_triangleIndexStride = sizeof(short) * 3;
-	part.m_numTriangles = shape.mesh.indices.size() / 3;
-	part.m_indexType = PHY_SHORT;
-	meshInterface->addIndexedMesh(part, PHY_SHORT);
-
-	physicsBody.bTriangleShape = true;
-	physicsBody.meshInterface = meshInterface;
-	physicsBody.vertices = vertices;
-	physicsBody.indices = indices;
-
-	return new btBvhTriangleMeshShape(meshInterface, true);
 }
 
-btConvexHullShape* GeometryLoader::createConvexHullShape(std::string strSrc, std::string strFilename)
+void GeometryLoader::writeGeometryCommands(EntityTypeID typeID)
 {
-	auto collisionShape = new btConvexHullShape();
-	collisionShape->setLocalScaling(btVector3(1.f, 1.f, 1.f));
-
-	//check if vertex data for this mesh exists in map
-	if (mapMeshConvexHulls.find(strFilename) == mapMeshConvexHulls.end())
-		loadMeshConvexHullVertices(strSrc, strFilename);									//if not then load it
-
-	for (auto& vertex : mapMeshConvexHulls[strFilename])
-		collisionShape->addPoint(vertex);
-
-	//polyhedral precision
-	collisionShape->initializePolyhedralFeatures();
-
-	return collisionShape;
+	//index count and where the type's meshes sit in the arena, instance fields are left alone
+	const EntityTypeDesc& typeDesc = sceneDesc->entityTypes[typeID];
+	for (size_t i = 0; i < typeDesc.vcMeshes.size(); i++)
+	{
+		const MeshRef& meshRef = typeDesc.vcMeshes[i];
+		const GeometryRange& range = geometryArena->getRange(vcTypeGeometry[typeID][i]);
+		const GLuint geometry[] = { range.firstIndex, range.baseVertex };
+		for (GLuint iDraw = 0; iDraw < typeDesc.getDrawsPerMesh(); iDraw++)
+		{
+			const size_t iCmdOffset = reinterpret_cast<size_t>(mapRenderStates[meshRef.rsType].drawCmdOffset) + sizeof(DrawElementsIndirectCommand) * (meshRef.drawID + iDraw);
+			glNamedBufferSubData(drawIndirectBuffer, iCmdOffset + offsetof(DrawElementsIndirectCommand, count), sizeof(GLuint), &range.iIndices);
+			glNamedBufferSubData(drawIndirectBuffer, iCmdOffset + offsetof(DrawElementsIndirectCommand, firstIndex), sizeof(geometry), geometry);
+		}
+	}
 }
 
-void GeometryLoader::loadMeshConvexHullVertices(std::string strSrc, std::string strFilename)
+void GeometryLoader::restoreDrawCommands()
 {
-	tinyobj::ObjReader reader;
-	if (!reader.ParseFromFile(strSrc + strFilename))
+	//the cached scene buffers are shared with the next session, which starts from the scene as it was built
+	for (EntityTypeID typeID = 0; typeID < vcMovedDraws.size(); typeID++)
 	{
-		if (!reader.Error().empty())
-			spdlog::error("Reader : " + reader.Error());
+		if (vcMovedDraws[typeID])
+			writeDrawCommands(typeID, sceneDesc->entityTypes[typeID].iInstances, sceneDesc->entityTypes[typeID].baseInstance);
 	}
-	if (!reader.Warning().empty())
-		spdlog::warn("Warn : " + reader.Warning());
-
-	//add to map using filename as key so the model doesnt have to be parsed again
-	const tinyobj::attrib_t attrib = reader.GetAttrib();
-	for (int i = 0; i < attrib.vertices.size(); i += 3)
-		mapMeshConvexHulls[strFilename].emplace_back(btVector3(attrib.vertices[i], attrib.vertices[i + 1], attrib.vertices[i + 2]));
 }
 
-void GeometryLoader::addRigidBody(btRigidBody* rigidBody, const entt::entity e)
+bool GeometryLoader::reloadTexture(const std::string& strPath)
 {
-	//decativate body so it doesnt bounce around at the start
-	rigidBody->setActivationState(0);
-
-	// every rigidbody must contain in entt::entity in their userindex so its easy to work on them through entt::registry by physicsSys
-	// also this func is created so as not to forget to add entity e to userIndex of rigidbody before adding to dynamicWorld
-	// entt::entity is just uint32_t, hence why casting it to int
-	rigidBody->setUserIndex(static_cast<int>(e));
-	dynamicsWorld->addRigidBody(rigidBody);
-}
+	//the cached scene still holds the old pixels of its own textures
+	const std::string strModelsSrc = strAssetSrc + "models/";
+	if (strPath.compare(0, strModelsSrc.size(), strModelsSrc) == 0 && sceneDesc->mapTextures.find(strPath.substr(strModelsSrc.size())) != sceneDesc->mapTextures.end())
+		invalidateScene();
+
+	const std::string strKey = textureResourceKey(strPath);
+	auto iter = mapTextures.find(strKey);
+	if (iter == mapTextures.end())
+	{
+		//not used right now, the next load picks up the new file
+		resourceManager->invalidate(strKey);
+		return false;
+	}
 
+	//layers are resampled to their bucket anyway, so any new size is written in place
+	if (TextureArrays* textureArrays = TextureArrays::get())
+	{
+		TexturePayload payload;
+		if (!SceneBuilder::decodeTexture(strPath, textureArrays->getLayer(iter->second).iChannels, payload))
+			return false;
+		textureArrays->update(iter->second, payload);
+		return true;
+	}
 
-GLuint GeometryLoader::loadTexture(std::string strSrc, std::string strFilename)
-{
-	unsigned int texture;
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	// set the texture wrapping/filtering options (on the currently bound texture object)
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	GLint iWidth, iHeight, iFormat;
+	glGetTextureLevelParameteriv(iter->second, 0, GL_TEXTURE_WIDTH, &iWidth);
+	glGetTextureLevelParameteriv(iter->second, 0, GL_TEXTURE_HEIGHT, &iHeight);
+	glGetTextureLevelParameteriv(iter->second, 0, GL_TEXTURE_INTERNAL_FORMAT, &iFormat);
+	TexturePayload payload;
+	if (!SceneBuilder::decodeTexture(strPath, iFormat == GL_RGBA8 ? 4 : 3, payload))
+		return false;
 
-	// load and generate the texture
-	int width, height, nrChannels;
-	//flip it 
-	stbi_set_flip_vertically_on_load(true);
-	unsigned char* data = stbi_load(std::string(strSrc + strFilename).c_str(), &width, &height, &nrChannels, STBI_rgb);
-	if (data)
+	//a texture with a handle cant be reallocated, only its contents can change
+	if (payload.iWidth != iWidth || payload.iHeight != iHeight)
 	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		spdlog::warn("Texture size changed, re-enter the room to see it : " + strPath);
+		resourceManager->invalidate(strKey);
+		return false;
 	}
-	else
-		spdlog::error("Failed to load texture : " + strSrc + strFilename);
 
-	stbi_image_free(data);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	//same texture object so every bindless handle slot pointing at it stays valid
+	glTextureSubImage2D(iter->second, 0, 0, 0, iWidth, iHeight, payload.iChannels == 4 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, payload.vcPixels.data());
+	glGenerateTextureMipmap(iter->second);
+	return true;
+}
 
-	return texture;
+bool GeometryLoader::reloadModel(const std::string& strModelPath)
+{
+	//collision shapes built from the file are only rebuilt on the next load, live bodies keep the old one
+	for (auto& shape : mapShapes)
+	{
+		const RigidBodySpec* spec = findRigidBodySpec(shape.first);
+		if (spec != nullptr && spec->strShapeFile == strModelPath)
+		{
+			spdlog::warn("Collision shape of " + shape.first + " changes once the room is entered again");
+			resourceManager->invalidate(shapeResourceKey(shape.first));
+		}
+	}
+
+	std::vector<EntityTypeID> vcEntityTypes;
+	for (EntityTypeID typeID = 0; typeID < sceneDesc->entityTypes.size(); typeID++)
+	{
+		if (sceneDesc->entityTypes[typeID].iInstances > 0 && sceneDesc->entityTypes[typeID].strModelPath == strModelPath)
+			vcEntityTypes.emplace_back(typeID);
+	}
+	if (vcEntityTypes.empty())
+		return false;
+
+	std::vector<ModelMesh> vcMeshes;
+	if (!SceneBuilder::loadModelMeshes(strAssetSrc + strModelPath, vcMeshes))
+		return false;
+
+	bool bPatched = true;
+	for (EntityTypeID typeID : vcEntityTypes)
+		bPatched &= patchModel(typeID, vcMeshes);
+	invalidateScene();
+	return bPatched;
 }
 
-GLuint GeometryLoader::loadTextureRGBA8(std::string strSrc, std::string strFilename)
+bool GeometryLoader::patchModel(EntityTypeID typeID, const std::vector<ModelMesh>& vcMeshes)
 {
-	if (mapTextures.find(strFilename) == mapTextures.end())
-	{
-		unsigned int texture;
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		// set the texture wrapping/filtering options (on the currently bound texture object)
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// load and generate the texture
-		int width, height, nrChannels;
-		//flip it 
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char* data = stbi_load(std::string(strSrc + strFilename).c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
-		if (data)
+	//every submesh owns its arena range so it may grow, material and submesh count have to stay, check all before touching anything
+	const EntityTypeDesc& typeDesc = sceneDesc->entityTypes[typeID];
+	const std::vector<MeshRef>& vcMeshRefs = typeDesc.vcMeshes;
+	const GLuint iDraws = typeDesc.getDrawsPerMesh();
+	if (vcMeshRefs.size() != vcMeshes.size())
+	{
+		spdlog::warn("Submesh count of " + typeDesc.strName + " changed, re-enter the room to see it");
+		return false;
+	}
+	for (size_t i = 0; i < vcMeshes.size(); i++)
+	{
+		const MeshRef& meshRef = vcMeshRefs[i];
+		const RSLoader& batch = sceneDesc->mapRSBatches.at(meshRef.rsType);
+		if (vcMeshes[i].rsType != meshRef.rsType ||
+			(meshRef.rsType != RSType::BASIC_KD && vcMeshes[i].strTexName != batch.vcTexNames[meshRef.drawID]))
 		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_2D);
+			spdlog::warn("Model of " + typeDesc.strName + " changed material, re-enter the room to see it");
+			return false;
 		}
-		else
-			spdlog::error("Failed to load texture : " + strSrc + strFilename);
+	}
 
-		stbi_image_free(data);
-		glBindTexture(GL_TEXTURE_2D, 0);
+	for (size_t i = 0; i < vcMeshes.size(); i++)
+	{
+		const MeshRef& meshRef = vcMeshRefs[i];
+		const ModelMesh& mesh = vcMeshes[i];
+		geometryArena->update(vcTypeGeometry[typeID][i],
+			mesh.vertices.data(), static_cast<GLuint>(mesh.vertices.size() / GeometryArena::ciVertexFloats),
+			mesh.indices.data(), static_cast<GLuint>(mesh.indices.size()));
 
-		//insert to map
-		mapTextures[strFilename] = texture;
+		if (meshRef.rsType == RSType::BASIC_KD)
+		{
+			for (GLuint iDraw = 0; iDraw < iDraws; iDraw++)
+				glNamedBufferSubData(mapRenderStates[meshRef.rsType].ssboFrag, sizeof(glm::vec4) * (meshRef.drawID + iDraw), sizeof(glm::vec4), &mesh.vKdColor);
+		}
+	}
 
-		return texture;
+	//grown meshes leave holes behind, once they waste too much everything is packed and every command rewritten
+	if (!geometryArena->isFragmented())
+	{
+		writeGeometryCommands(typeID);
+		return true;
 	}
-	else
-		return mapTextures[strFilename];
-}
\ No newline at end of file
+	geometryArena->defragment();
+	for (EntityTypeID otherID = 0; otherID < vcTypeGeometry.size(); otherID++)
+		writeGeometryCommands(otherID);
+	const GeometryStats stats = geometryArena->getStats();
+	spdlog::info("Scene geometry defragmented : " + std::to_string(stats.iUsedBytes / 1024) + " of " + std::to_string(stats.iCapacityBytes / 1024) + " KB used");
+	return true;
+}
+
+void GeometryLoader::invalidateScene()
+{
+	//the next load builds the scene and its buffers from disk again, this session keeps using its own
+	resourceManager->invalidate(strSceneKey);
+	resourceManager->invalidate(strBuffersKey);
+}
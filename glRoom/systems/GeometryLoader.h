@@ -1,16 +1,47 @@
-//loads level geometry, properly arranges them for to be used by rendering system
-//loads both geometries and entities independently
+//gpu upload stage of level loading, consumes a LoadedScene prepared by SceneLoadTask on the gl thread
+//creates the entities, rigid bodies, gl buffers and textures described by it
+//gl buffers, textures and shapes are owned by the ResourceManager so a later session can reuse them
 #pragma once
 #include "RenderState.h"
 #include "Components.h"
+#include "TransformStaging.h"
+#include "InstanceAllocator.h"
+#include "TextureArrays.h"
+#include "RigidBodySpec.h"
+#include "SceneLoadTask.h"
+#include "../ResourceManager.h"
+#include "LevelFile.h"
 
 #include <string>
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
-#include <BulletCollision/CollisionShapes/btConvexHullShape.h>
-#include <BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h>
 #include <entt/entity/registry.hpp>
 #include <glm/mat4x4.hpp>
 #include <map>
+#include <memory>
+
+//everything uploaded for one scene that stays the same between sessions
+struct SceneBuffers
+{
+	std::map<RSType, RenderState> mapRenderStates;
+	GLuint drawIndirectBuffer;
+	GeometryArena* geometryArena;															//vertices and indices of every mesh of the scene
+	std::vector<std::vector<GeometryHandle>> vcTypeGeometry;								//indexed by EntityTypeID then by submesh, one range shared by a mesh's draws
+	GeometryState geoStateStencilDraw;
+	size_t iBytes;
+
+	SceneBuffers() : drawIndirectBuffer(0), geometryArena(nullptr), iBytes(0) {}
+};
+
+//level entity as currently placed, hot reload diffs the level file against these
+struct LiveEntity
+{
+	EntityTypeID typeID;
+	btVector3 vOrigin;
+	float fYaw;
+	btVector3 vDimensions;
+	entt::entity e;
+	bool bRenderable;
+};
 
 class GeometryLoader
 {
@@ -18,82 +49,107 @@ public:
 	GeometryLoader(
 		entt::registry* mRegistry, 
 		btDiscreteDynamicsWorld* dynamicsWorld, 
+		MotionSync* motionSync,
 		std::string strAssetSrc,
-		std::string strLevelFile);
+		ResourceManager* resourceManager,
+		LoadedScene& loadedScene);
 
 	~GeometryLoader();
 
 	GLuint getDrawIndirectBuffer() { return drawIndirectBuffer; }
 	GLuint getSSBOTransforms() { return ssboTransforms; }
-	GLuint getTotalInstances() { return iTotalInstances; }
-	GLuint getTexture(std::string& strTex) { return mapTextures[strTex]; }
+	TransformStaging* getTransformStaging() { return transformStaging.get(); }
+	GLuint getTexture(std::string& strTex) { return mapTextures[textureResourceKey(strAssetSrc + "models/" + strTex)]; }
 	GeometryState getGSStencilDraw() { return geoStateStencilDraw; }
+	GeometryArena* getGeometryArena() { return geometryArena; }
 	std::map<RSType, RenderState> getRenderStates() { return mapRenderStates; }
-	std::map<std::string, GLuint>& getEntityDrawIDs() { return mapEntityDrawIDs; }
+	const EntityTypeTable& getEntityTypes() const { return sceneDesc->entityTypes; }
 	GeometryState createGSBackgroundQuad(std::string strTexture);
-	
-	//Entity loader
-	void createBook(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);
-	void createDesk(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);
-	void createChair(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);
-	void createShelf(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);
-	void createKeyboard(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);
-	void createMonitor(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);
-	void createBookShelf(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);
-	void createMoonLamp(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);
-	void createPlantPot(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);
-	void createMug(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);
-
-	void createRoom(btVector3 vOrigin = btVector3(0.f, 0.f, 0.f), float fYaw = 0.f);		
-	void createInvisibleWall(const btVector3& vPosition, const btVector3& vDimensions);
-
-	GLuint loadTexture(std::string strSrc, std::string strFilename);
+	void writeBackgroundTexCoords(const float* texCoords);
+
+	entt::entity createInvisibleWall(const btVector3& vPosition, const btVector3& vDimensions);
+
+	//runtime spawning, gl thread at the frame's sync point only, nothing may be simulating meanwhile
+	//only types the scene was built with can be spawned, types drawn per instance only into slots freed before
+	entt::entity spawnEntity(EntityTypeID typeID, const btVector3& vOrigin, float fYaw);
+	bool despawnEntity(entt::entity e);
+
+	//entity drawn with the transform at iSlot, what gpu picking reads back, entt::null if none is
+	entt::entity getSlotEntity(GLuint iSlot) const;
+
+	//writes the indirect commands of types whose instance block changed since the last call, before drawing
+	void syncDrawCommands();
+
+	//hot reload, gl thread only
+	//false when the change can only be applied by loading the scene again, the cached scene is invalidated for that
+	bool applyLevel(const std::vector<LevelEntity>& vcLevel);
+	bool reloadTexture(const std::string& strPath);										//full path
+	bool reloadModel(const std::string& strModelPath);									//relative to the asset folder
+
+	//cached in the resource manager, released with this loader
+	GLuint loadTexture(std::string strSrc, std::string strFilename, int iChannels = 3);
 	GLuint loadTextureRGBA8(std::string strSrc, std::string strFilename);
+	//without bindless support these go through TextureArrays, the texture is then an id into it
+	static GLuint uploadTexture(const TexturePayload& payload);
+	static void freeTexture(GLuint& texture);
+	//what a material ssbo slot holds, a resident bindless handle or the bucket / layer of the texture array
+	//textures outlive sessions so their handles may already be resident
+	static GLuint64 getTextureHandle(GLuint texture);
 
 private:
-	void initGeometryInstances();
-	void initGeometryInstanceData();
-	void initBufferStorage();
-	void initGeometryBaseInstances();
-	void initSSBOInstanceTransforms();
-	
-	void initModelList(std::string strEntityType, std::string strModelPath);
-	entt::entity createRenderableEntity(std::string strEntityType, std::string strModelPath, const CPhysicsBody cPhysicsBody, const glm::mat4 matModel);				
-	
-	GeometryState createGSStencilDraw(std::string strEntityType);
+	void initEntities(const SceneDesc& sceneDesc);
+	void initTextures(const SceneDesc& sceneDesc);
+	void initSceneBuffers(const SceneDesc& sceneDesc);
+	void initSSBOInstanceTransforms(const SceneDesc& sceneDesc);
+	SceneBuffers createSceneBuffers(const SceneDesc& sceneDesc);
+	GLuint acquireTexture(const std::string& strKey, const TexturePayload& payload);
+
+	entt::entity createInstance(EntityTypeID typeID, GLuint instanceID, const btVector3& vOrigin, float fYaw, const glm::mat4& matModel);
+	void reserveSlots();
+	void relocateInstances(EntityTypeID typeID);
+	void setSlotEntity(GLuint iSlot, entt::entity e);
+	void writeDrawCommands(EntityTypeID typeID, GLuint instanceCount, GLuint baseInstance);
+	void writeGeometryCommands(EntityTypeID typeID);
+	void restoreDrawCommands();
+
+	void placeEntity(LiveEntity& liveEntity, const LevelEntity& levelEntity);
+	void destroyInvisibleWall(entt::entity e);
+	bool patchModel(EntityTypeID typeID, const std::vector<ModelMesh>& vcMeshes);
+	void invalidateScene();
 
 	//gl data
 	GLuint drawIndirectBuffer;																	//the single indirect draw buffer, other materials use offsets to get their appropriate data
-	GLuint ssboTransforms;
-	unsigned int iTotalInstances;
+	GLuint ssboTransforms;																		//grows by doubling, only ever read through getSSBOTransforms
+	GLuint iSlotCapacity;
+	std::unique_ptr<TransformStaging> transformStaging;
+	InstanceAllocator instanceAllocator;
+	std::vector<bool> vcDirtyDraws;																//indexed by EntityTypeID, block changed since the last sync
+	std::vector<bool> vcMovedDraws;																//differs from the cached scene buffers
+	std::vector<entt::entity> vcSlotEntities;													//indexed by slot, stale entries are caught by getSlotEntity
 
 	std::map<RSType, RenderState> mapRenderStates;
-	std::map<RSType, RSLoader> mapRSLoaders;
-	std::map<std::string, std::string> mapEntityModelList;										//all paths to obj models, according to entity type
-	std::map<std::string, std::vector<glm::mat4>> mapEntityTransforms;
-	std::map<std::string, unsigned int> mapEntityBaseInstances;
-	std::map<std::string, GLuint> mapEntityDrawIDs;													//drawIDs for all geometry, wrt to thier RenderStateType 
+	GeometryArena* geometryArena;																//owned by the cached scene buffers
+	std::vector<std::vector<GeometryHandle>> vcTypeGeometry;
 
 	GeometryState geoStateBackgroundQuad;
 	GeometryState geoStateStencilDraw;
 
 	std::string strAssetSrc;																	//asset src folder
-	std::string strLevelFile;
-	unsigned int ciCRT;
-	unsigned int ciTotalDrawCmd;
 
-
-	//use indices to create btTriangleMesh for btBvtTriangleMeshShape, provided a pointer is given
-	//Model loadModel(std::string strSrc, std::string strFilename);
-	btTriangleMeshShape* createTriangleMeshShape(CPhysicsBody& physicsBody, std::string strSrcFile);
-	btConvexHullShape* createConvexHullShape(std::string strSrc, std::string strFilename);
-	void loadMeshConvexHullVertices(std::string strSrc, std::string strFilename);
-	void addRigidBody(btRigidBody* rigidBody, const entt::entity e);
+	//motion state and body from the entity type's RigidBodySpec around the type's shared shape
+	CPhysicsBody createPhysicsBody(EntityTypeID typeID, const btVector3& vOrigin, float fYaw);
+	//iGroup is one of the collision groups in PhysicsWorld.h
+	void addRigidBody(btRigidBody* rigidBody, const entt::entity e, int iGroup);
 
 	entt::registry* mRegistry;
 	btDiscreteDynamicsWorld* dynamicsWorld;
-	std::map<std::string, unsigned int> mapTextures;
-	std::map<std::string, std::vector<btVector3>> mapMeshConvexHulls;							//keep convex hulls in a map so mesh files dont have to be read over and over again 
-
-	
+	MotionSync* motionSync;																		//shared by motion states of dynamic bodies
+	ResourceManager* resourceManager;
+	std::shared_ptr<const SceneDesc> sceneDesc;
+	std::vector<LiveEntity> vcLiveEntities;
+	std::string strSceneKey;
+	std::string strBuffersKey;
+	std::map<std::string, btCollisionShape*> mapShapes;										//one reference per spec type
+	std::vector<btCollisionShape*> vcTypeShapes;												//same shapes indexed by EntityTypeID, nullptr for walls
+	std::map<std::string, unsigned int> mapTextures;											//keyed by textureResourceKey, one reference each
 };
\ No newline at end of file
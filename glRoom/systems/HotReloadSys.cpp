@@ -0,0 +1,65 @@
+#include "HotReloadSys.h"
+#include "LevelFile.h"
+
+#include <spdlog/spdlog.h>
+#include <chrono>
+
+HotReloadSys::HotReloadSys(std::unique_ptr<GeometryLoader>& mGeometryLoader, RenderingSys* mRenderingSys, std::string strAssetSrc, std::string strLevelFile) :
+	mGeometryLoader(mGeometryLoader),
+	mRenderingSys(mRenderingSys),
+	strAssetSrc(strAssetSrc),
+	strLevelFile(strLevelFile),
+	fileWatcher(strAssetSrc)
+{
+}
+
+void HotReloadSys::update()
+{
+	fileWatcher.poll(vcChanged);
+	if (vcChanged.empty())
+		return;
+
+	bool bShaders = false;
+	for (auto& strPath : vcChanged)
+	{
+		//all shader files go through one relink
+		if (strPath.compare(0, 8, "shaders/") == 0)
+			bShaders = true;
+		else
+			reloadFile(strPath);
+	}
+
+	if (bShaders)
+	{
+		auto start = std::chrono::steady_clock::now();
+		mRenderingSys->reloadShaders();
+		spdlog::info("Reloaded shaders in " + std::to_string(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()) + " ms");
+	}
+}
+
+void HotReloadSys::reloadFile(const std::string& strPath)
+{
+	const size_t iDot = strPath.find_last_of('.');
+	const std::string strExt = iDot == std::string::npos ? "" : strPath.substr(iDot);
+	auto start = std::chrono::steady_clock::now();
+	bool bApplied = false;
+
+	if (strPath == strLevelFile)
+	{
+		std::vector<LevelEntity> vcLevel;
+		if (!loadLevelFile(strAssetSrc + strLevelFile, vcLevel))
+			return;
+		bApplied = mGeometryLoader->applyLevel(vcLevel);
+	}
+	else if (strExt == ".png" || strExt == ".jpg" || strExt == ".jpeg" || strExt == ".tga" || strExt == ".bmp")
+		bApplied = mGeometryLoader->reloadTexture(strAssetSrc + strPath);
+	else if (strExt == ".obj")
+		bApplied = mGeometryLoader->reloadModel(strPath);
+	else if (strExt == ".mtl")
+		bApplied = mGeometryLoader->reloadModel(strPath.substr(0, iDot) + ".obj");				//materials are only read through their obj
+	else
+		return;
+
+	if (bApplied)
+		spdlog::info("Reloaded " + strPath + " in " + std::to_string(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()) + " ms");
+}
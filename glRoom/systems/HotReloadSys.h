@@ -0,0 +1,29 @@
+//watches the asset folder while playing and applies changes without a restart
+//shaders are recompiled, textures and models patched in place and the level file diffed against live entities
+//whatever cant be applied live is invalidated in the resource manager so entering the room again loads it
+#pragma once
+#include "GeometryLoader.h"
+#include "RenderingSys.h"
+#include "../FileWatcher.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class HotReloadSys
+{
+public:
+	HotReloadSys(std::unique_ptr<GeometryLoader>& mGeometryLoader, RenderingSys* mRenderingSys, std::string strAssetSrc, std::string strLevelFile);
+
+	void update();
+
+private:
+	void reloadFile(const std::string& strPath);
+
+	std::unique_ptr<GeometryLoader>& mGeometryLoader;
+	RenderingSys* mRenderingSys;
+	std::string strAssetSrc;
+	std::string strLevelFile;
+	FileWatcher fileWatcher;
+	std::vector<std::string> vcChanged;
+};
@@ -0,0 +1,142 @@
+#include "InputLog.h"
+
+#include <spdlog/spdlog.h>
+#include <cstring>
+#include <ctime>
+
+//on disk : magic, version, seed, fixed timestep, then packed 17 byte events up to an END event
+static const char szMagic[4] = { 'g', 'R', 'I', 'L' };
+static constexpr uint32_t ciVersion = 1;
+static constexpr size_t ciEventBytes = 17;
+
+static void packEvent(const InputEvent& event, unsigned char* bytes)
+{
+	memcpy(bytes, &event.iFrame, 4);
+	memcpy(bytes + 4, &event.iCode, 4);
+	memcpy(bytes + 8, &event.x, 2);
+	memcpy(bytes + 10, &event.y, 2);
+	memcpy(bytes + 12, &event.relX, 2);
+	memcpy(bytes + 14, &event.relY, 2);
+	bytes[16] = static_cast<unsigned char>(event.type);
+}
+
+static void unpackEvent(const unsigned char* bytes, InputEvent& event)
+{
+	memcpy(&event.iFrame, bytes, 4);
+	memcpy(&event.iCode, bytes + 4, 4);
+	memcpy(&event.x, bytes + 8, 2);
+	memcpy(&event.y, bytes + 10, 2);
+	memcpy(&event.relX, bytes + 12, 2);
+	memcpy(&event.relY, bytes + 14, 2);
+	event.type = static_cast<InputEventType>(bytes[16]);
+}
+
+InputLog::InputLog() :
+	file(nullptr),
+	bReplaying(false),
+	iSeed(0),
+	fFixedTimeStep(0.f),
+	iFrame(0),
+	iLastFrame(0),
+	iNextEvent(0)
+{
+}
+
+InputLog::~InputLog()
+{
+	if (file == nullptr)
+		return;
+
+	//the end marker keeps trailing frames without input part of the replay
+	InputEvent end;
+	end.type = InputEventType::END;
+	write(end);
+	fclose(file);
+	spdlog::info("Recorded " + std::to_string(iFrame) + " frames of input");
+}
+
+std::unique_ptr<InputLog> InputLog::record(const std::string& strPath, float fFixedTimeStep)
+{
+	FILE* file = fopen(strPath.c_str(), "wb");
+	if (file == nullptr)
+	{
+		spdlog::error("Failed to open " + strPath + " for recording input");
+		return nullptr;
+	}
+
+	std::unique_ptr<InputLog> inputLog(new InputLog());
+	inputLog->file = file;
+	inputLog->iSeed = static_cast<uint32_t>(time(0));
+	inputLog->fFixedTimeStep = fFixedTimeStep;
+	fwrite(szMagic, 1, 4, file);
+	fwrite(&ciVersion, 4, 1, file);
+	fwrite(&inputLog->iSeed, 4, 1, file);
+	fwrite(&inputLog->fFixedTimeStep, 4, 1, file);
+	return inputLog;
+}
+
+std::unique_ptr<InputLog> InputLog::replay(const std::string& strPath)
+{
+	FILE* file = fopen(strPath.c_str(), "rb");
+	if (file == nullptr)
+	{
+		spdlog::error("Failed to open input log " + strPath);
+		return nullptr;
+	}
+
+	std::unique_ptr<InputLog> inputLog(new InputLog());
+	inputLog->bReplaying = true;
+	char magic[4];
+	uint32_t iVersion = 0;
+	bool bValid = fread(magic, 1, 4, file) == 4 && memcmp(magic, szMagic, 4) == 0 &&
+		fread(&iVersion, 4, 1, file) == 1 && iVersion == ciVersion &&
+		fread(&inputLog->iSeed, 4, 1, file) == 1 &&
+		fread(&inputLog->fFixedTimeStep, 4, 1, file) == 1;
+
+	unsigned char bytes[ciEventBytes];
+	bool bEnded = false;
+	while (bValid && !bEnded && fread(bytes, 1, ciEventBytes, file) == ciEventBytes)
+	{
+		InputEvent event;
+		unpackEvent(bytes, event);
+		if (event.type == InputEventType::END)
+		{
+			inputLog->iLastFrame = event.iFrame;
+			bEnded = true;
+		}
+		else
+			inputLog->vcEvents.emplace_back(event);
+	}
+	fclose(file);
+
+	if (!bValid)
+	{
+		spdlog::error(strPath + " is not an input log");
+		return nullptr;
+	}
+
+	//a recording cut short still replays up to its last event
+	if (!bEnded)
+	{
+		spdlog::warn(strPath + " has no end marker, the recording was cut short");
+		inputLog->iLastFrame = inputLog->vcEvents.empty() ? 0 : inputLog->vcEvents.back().iFrame + 1;
+	}
+	spdlog::info("Replaying " + std::to_string(inputLog->vcEvents.size()) + " input events over " + std::to_string(inputLog->iLastFrame) + " frames");
+	return inputLog;
+}
+
+void InputLog::write(InputEvent event)
+{
+	event.iFrame = iFrame;
+	unsigned char bytes[ciEventBytes];
+	packEvent(event, bytes);
+	fwrite(bytes, 1, ciEventBytes, file);
+}
+
+bool InputLog::read(InputEvent& event)
+{
+	if (iNextEvent >= vcEvents.size() || vcEvents[iNextEvent].iFrame > iFrame)
+		return false;
+	event = vcEvents[iNextEvent++];
+	return true;
+}
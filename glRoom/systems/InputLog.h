@@ -0,0 +1,69 @@
+//compact binary log of the input InputSys consumed, frame indexed so a replay feeds the same input into the same frame
+//mouse state is sampled while recording, a replay never asks sdl where the mouse is
+//together with the fixed timestep and the stored rand seed a replay drives the same picks, drags and camera moves every run
+//gl thread only, InputSys owns the frame counter
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class InputEventType : uint8_t
+{
+	BUTTON_DOWN,
+	BUTTON_UP,
+	MOTION,
+	WHEEL,
+	KEY_DOWN,
+	QUIT,
+	END																			//frame count of the recording, nothing else
+};
+
+struct InputEvent
+{
+	uint32_t iFrame;
+	int32_t iCode;																//sdl button or keycode
+	int16_t x, y;																//mouse position or wheel amount
+	int16_t relX, relY;
+	InputEventType type;
+	InputEvent() : iFrame(0), iCode(0), x(0), y(0), relX(0), relY(0), type(InputEventType::END) {}
+};
+
+class InputLog
+{
+public:
+	//nullptr if the file cant be opened or isnt a log
+	static std::unique_ptr<InputLog> record(const std::string& strPath, float fFixedTimeStep);
+	static std::unique_ptr<InputLog> replay(const std::string& strPath);
+	~InputLog();
+
+	bool isReplaying() const { return bReplaying; }
+	uint32_t getSeed() const { return iSeed; }
+	float getFixedTimeStep() const { return fFixedTimeStep; }
+	uint32_t getFrame() const { return iFrame; }
+
+	//recording, stamped with the current frame
+	void write(InputEvent event);
+
+	//replay, the next event of the current frame, false once the frame has none left
+	bool read(InputEvent& event);
+
+	//once per InputSys::update
+	void nextFrame() { iFrame++; }
+
+	//replay played every recorded frame
+	bool isFinished() const { return bReplaying && iFrame >= iLastFrame; }
+
+private:
+	InputLog();
+
+	FILE* file;																	//recording only
+	bool bReplaying;
+	uint32_t iSeed;
+	float fFixedTimeStep;
+	uint32_t iFrame;
+	uint32_t iLastFrame;														//frames recorded
+	std::vector<InputEvent> vcEvents;											//replay only, the whole log
+	size_t iNextEvent;
+};
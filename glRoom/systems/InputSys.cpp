@@ -1,5 +1,6 @@
 #include "InputSys.h"
 #include "SystemComponents.h"
+#include "../FrameTracer.h"
 
 #include <LinearMath/btIDebugDraw.h>
 #include <SDL_events.h>
@@ -13,8 +14,11 @@ InputSys::InputSys(
 	LBtnReleasedSubject* lBtnReleasedSubject,
 	RBtnMotionSubject* rBtnMotionSubject,
 	MBtnMotionSubject* mBtnMotionSubject,
-	MouseScrollSubject* mouseScrollSubject) :
+	MouseScrollSubject* mouseScrollSubject,
+	PhysicsSnapshotSubject* physicsSnapshotSubject,
+	InputLog* inputLog) :
 	smQueue(smQueue),
+	inputLog(inputLog),
 	mRegistry(mRegistry),
 	dynamicsWorld(dynamicsWorld),
 	bLBtnDown(false),
@@ -24,6 +28,7 @@ InputSys::InputSys(
 	rBtnMotionSubject(rBtnMotionSubject),
 	mBtnMotionSubject(mBtnMotionSubject),
 	mouseScrollSubject(mouseScrollSubject),
+	physicsSnapshotSubject(physicsSnapshotSubject),
 	lBtnPressedSubject(lBtnPressedSubject),
 	lBtnReleasedSubject(lBtnReleasedSubject)
 {
@@ -35,122 +40,219 @@ InputSys::~InputSys()
 
 bool InputSys::update()
 {
+	if (inputLog != nullptr && inputLog->isReplaying())
+		return updateReplay();
+
+	bool bEnd = false;
+	SDL_Event e;
+	while (!bEnd && SDL_PollEvent(&e))
+	{
+		InputEvent event;
+		if (!sampleEvent(e, event))
+			continue;
+		if (inputLog != nullptr)
+			inputLog->write(event);
+		bEnd = handleEvent(event);
+	}
+
+	if (inputLog != nullptr)
+		inputLog->nextFrame();
+	return bEnd;
+}
+
+bool InputSys::updateReplay()
+{
+	//the window still gets its events, but only closing it or escape do anything, cutting the replay short
 	SDL_Event e;
 	while (SDL_PollEvent(&e))
 	{
-		switch (e.type)
+		if (e.type == SDL_QUIT)
+		{
+			smQueue->push(SMMessage::QUIT);
+			return true;
+		}
+		if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE)
+		{
+			smQueue->push(SMMessage::POP);
+			return true;
+		}
+	}
+
+	bool bEnd = false;
+	InputEvent event;
+	while (!bEnd && inputLog->read(event))
+		bEnd = handleEvent(event);
+	inputLog->nextFrame();
+
+	if (!bEnd && inputLog->isFinished())
+	{
+		smQueue->push(SMMessage::QUIT);
+		bEnd = true;
+	}
+	return bEnd;
+}
+
+bool InputSys::sampleEvent(const SDL_Event& e, InputEvent& event)
+{
+	int x = 0, y = 0, relX = 0, relY = 0;
+	switch (e.type)
+	{
+	case SDL_MOUSEBUTTONDOWN:
+		if (bLBtnDown || bRBtnDown || bMBtnDown)
+			return false;
+		event.type = InputEventType::BUTTON_DOWN;
+		event.iCode = e.button.button;
+		if (e.button.button == SDL_BUTTON_LEFT)
+			SDL_GetMouseState(&x, &y);
+		else
+			SDL_GetRelativeMouseState(&relX, &relY);						//get relative mouse state here so the value is delta in SDL_MOUSEMOTION
+		break;
+
+	case SDL_MOUSEMOTION:
+		if (!bLBtnDown && !bRBtnDown)
+			return false;
+		event.type = InputEventType::MOTION;
+		SDL_GetMouseState(&x, &y);
+		SDL_GetRelativeMouseState(&relX, &relY);
+		break;
+
+	case SDL_MOUSEBUTTONUP:
+		if (!bLBtnDown && !bRBtnDown && !bMBtnDown)
+			return false;
+		event.type = InputEventType::BUTTON_UP;
+		event.iCode = e.button.button;
+		break;
+
+	case SDL_MOUSEWHEEL:
+		event.type = InputEventType::WHEEL;
+		x = e.wheel.x;
+		y = e.wheel.y;
+		break;
+
+	case SDL_KEYDOWN:
+		event.type = InputEventType::KEY_DOWN;
+		event.iCode = e.key.keysym.sym;
+		break;
+
+	case SDL_QUIT:
+		event.type = InputEventType::QUIT;
+		break;
+
+	default:
+		return false;
+	}
+
+	event.x = static_cast<int16_t>(x);
+	event.y = static_cast<int16_t>(y);
+	event.relX = static_cast<int16_t>(relX);
+	event.relY = static_cast<int16_t>(relY);
+	return true;
+}
+
+bool InputSys::handleEvent(const InputEvent& event)
+{
+	switch (event.type)
+	{
+	case InputEventType::BUTTON_DOWN:
+		if (event.iCode == SDL_BUTTON_LEFT)
 		{
-		case SDL_MOUSEBUTTONDOWN:
-			if (!bLBtnDown && !bRBtnDown && !bMBtnDown)
-			{
-				if (e.button.button == SDL_BUTTON_LEFT)
+			bLBtnDown = true;
+			lBtnPressedSubject->notify(event.x, event.y);
+		}
+		else if (event.iCode == SDL_BUTTON_RIGHT)
+			bRBtnDown = true;
+		else
+			bMBtnDown = true;
+		break;
+
+	case InputEventType::MOTION:
+		if (bLBtnDown)
+			lBtnMotionSubject->notify(event.x, event.y, event.relX, event.relY);
+		else if (bRBtnDown)
+			rBtnMotionSubject->notify(event.x, event.y, event.relX, event.relY);
+		break;
+
+	case InputEventType::BUTTON_UP:
+		if (bLBtnDown)
+		{
+			lBtnReleasedSubject->notify();
+			bLBtnDown = false;
+		}
+		else if (bRBtnDown)
+			bRBtnDown = false;
+		else if (bMBtnDown)
+			bMBtnDown = false;
+		break;
+
+	case InputEventType::WHEEL:
+		mouseScrollSubject->notify(event.x, event.y);
+		break;
+
+	case InputEventType::KEY_DOWN:
+		switch (event.iCode)
+		{
+			//set debug draw mode for rendering system
+			//view[0] is used since only 1 entity is allowed a System Component
+		case SDLK_1:
+			mRegistry->patch<SCDrawMode>(
+				mRegistry->view<SCDrawMode>()[0],
+				[](SCDrawMode& scDrawMode)
 				{
-					int x, y;
-					SDL_GetMouseState(&x, &y);
-					bLBtnDown = true;
-					lBtnPressedSubject->notify(x, y);
+					scDrawMode.drawMode = DrawMode::NORMAL;
 				}
-				else if (e.button.button == SDL_BUTTON_RIGHT)
+				);
+			dynamicsWorld->getDebugDrawer()->setDebugMode(0);
+			break;
+		case SDLK_2:
+			mRegistry->patch<SCDrawMode>(
+				mRegistry->view<SCDrawMode>()[0],
+				[](SCDrawMode& scDrawMode)
 				{
-					int x, y;
-					SDL_GetRelativeMouseState(&x, &y);					//get relative mouse state here so the value is delta in SDL_MOUSEMOTION
-					bRBtnDown = true;
+					scDrawMode.drawMode = DrawMode::NORMAL_DEBUG;
 				}
-				else
+				);
+			dynamicsWorld->getDebugDrawer()->setDebugMode(btIDebugDraw::DBG_DrawAabb + btIDebugDraw::DBG_DrawConstraints + btIDebugDraw::DBG_DrawWireframe);
+			break;
+		case SDLK_3:
+			mRegistry->patch<SCDrawMode>(
+				mRegistry->view<SCDrawMode>()[0], 
+				[](SCDrawMode& scDrawMode)
 				{
-					int x, y;
-					SDL_GetRelativeMouseState(&x, &y);					//get relative mouse state here so the value is delta in SDL_MOUSEMOTION
-					bMBtnDown = true;
+					scDrawMode.drawMode = DrawMode::DEBUG;
 				}
-			}
+				);
+			dynamicsWorld->getDebugDrawer()->setDebugMode(btIDebugDraw::DBG_DrawAabb + btIDebugDraw::DBG_DrawConstraints + btIDebugDraw::DBG_DrawWireframe);
 			break;
 
-		case SDL_MOUSEMOTION:
-		{
-			if (bLBtnDown)
-			{
-				int relX, relY, x, y;
-				SDL_GetMouseState(&x, &y);
-				SDL_GetRelativeMouseState(&relX, &relY);
-				lBtnMotionSubject->notify(x, y, relX, relY);
-			}
-			else if (bRBtnDown)
-			{
-				int relX, relY, x, y;
-				SDL_GetMouseState(&x, &y);
-				SDL_GetRelativeMouseState(&relX, &relY);
-				rBtnMotionSubject->notify(x, y, relX, relY);
-			}
-			else if (bMBtnDown)
-			{
-			}
-		}
+		//physics snapshot, F5 saves the room as it is and F6 puts it back
+		case SDLK_F5:
+			physicsSnapshotSubject->notify(false);
 			break;
-
-		case SDL_MOUSEBUTTONUP:
-			if (bLBtnDown)
-			{
-				lBtnReleasedSubject->notify();
-				bLBtnDown = false;
-			}
-			else if (bRBtnDown)
-				bRBtnDown = false;
-			else if (bMBtnDown)
-				bMBtnDown = false;
+		case SDLK_F6:
+			physicsSnapshotSubject->notify(true);
 			break;
 
-		case SDL_MOUSEWHEEL:
-			mouseScrollSubject->notify(e.wheel.x, e.wheel.y);
+		//cpu frame tracer, F8 toggles recording and F9 writes everything recorded so far
+		case SDLK_F8:
+			FrameTracer::get().setEnabled(!FrameTracer::get().isEnabled());
 			break;
-
-		case SDL_KEYDOWN:
-			switch (e.key.keysym.sym)
-			{
-				//set debug draw mode for rendering system
-				//view[0] is used since only 1 entity is allowed a System Component
-			case SDLK_1:
-				mRegistry->patch<SCDrawMode>(
-					mRegistry->view<SCDrawMode>()[0],
-					[](SCDrawMode& scDrawMode)
-					{
-						scDrawMode.drawMode = DrawMode::NORMAL;
-					}
-					);
-				dynamicsWorld->getDebugDrawer()->setDebugMode(0);
-				break;
-			case SDLK_2:
-				mRegistry->patch<SCDrawMode>(
-					mRegistry->view<SCDrawMode>()[0],
-					[](SCDrawMode& scDrawMode)
-					{
-						scDrawMode.drawMode = DrawMode::NORMAL_DEBUG;
-					}
-					);
-				dynamicsWorld->getDebugDrawer()->setDebugMode(btIDebugDraw::DBG_DrawAabb + btIDebugDraw::DBG_DrawConstraints + btIDebugDraw::DBG_DrawWireframe);
-				break;
-			case SDLK_3:
-				mRegistry->patch<SCDrawMode>(
-					mRegistry->view<SCDrawMode>()[0], 
-					[](SCDrawMode& scDrawMode)
-					{
-						scDrawMode.drawMode = DrawMode::DEBUG;
-					}
-					);
-				dynamicsWorld->getDebugDrawer()->setDebugMode(btIDebugDraw::DBG_DrawAabb + btIDebugDraw::DBG_DrawConstraints + btIDebugDraw::DBG_DrawWireframe);
-				break;
-
-
-			case SDLK_ESCAPE:
-				smQueue->push(SMMessage::POP);
-				return true;
-			}
+		case SDLK_F9:
+			FrameTracer::get().exportJSON("glRoom_trace.json");
 			break;
 
-		case SDL_QUIT:
-			smQueue->push(SMMessage::QUIT);
+		case SDLK_ESCAPE:
+			smQueue->push(SMMessage::POP);
 			return true;
 		}
+		break;
+
+	case InputEventType::QUIT:
+		smQueue->push(SMMessage::QUIT);
+		return true;
+
+	default:
+		break;
 	}
 
 	return false;
-}
\ No newline at end of file
+}
@@ -1,8 +1,10 @@
 #pragma once
 #include "../SMQueue.h"
 #include "Subjects.h"
+#include "InputLog.h"
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
 #include <entt/entity/registry.hpp>
+#include <SDL_events.h>
 
 class InputSys
 {
@@ -16,14 +18,23 @@ public:
 		LBtnReleasedSubject* lBtnReleasedSubject,
 		RBtnMotionSubject* rBtnMotionSubject,
 		MBtnMotionSubject* mBtnMotionSubject,
-		MouseScrollSubject* mouseScrollSubject);
+		MouseScrollSubject* mouseScrollSubject,
+		PhysicsSnapshotSubject* physicsSnapshotSubject,
+		InputLog* inputLog = nullptr);
 	~InputSys();
 	
 	//if returned true, then end the loop and return to statemanager to process SMQueue
+	//with a recording log everything handled is written, a replaying log replaces the sdl events
 	bool update();												
 
 private:
+	//reads the mouse state the event needs, false for events nothing reacts to
+	bool sampleEvent(const SDL_Event& e, InputEvent& event);
+	bool handleEvent(const InputEvent& event);
+	bool updateReplay();
+
 	SMQueue* smQueue;
+	InputLog* inputLog;
 	entt::registry* mRegistry;
 	btDiscreteDynamicsWorld* dynamicsWorld;
 	bool bLBtnDown, bRBtnDown, bMBtnDown;
@@ -36,5 +47,6 @@ private:
 	RBtnMotionSubject* rBtnMotionSubject;
 	MBtnMotionSubject* mBtnMotionSubject;
 	MouseScrollSubject* mouseScrollSubject;
+	PhysicsSnapshotSubject* physicsSnapshotSubject;
 };
 
@@ -0,0 +1,58 @@
+#include "InstanceAllocator.h"
+
+#include <algorithm>
+#include <iterator>
+
+void InstanceAllocator::addType(GLuint base, GLuint iInstances, bool bFixed)
+{
+	InstanceBlock block;
+	block.base = base;
+	block.capacity = iInstances;
+	block.iUsed = iInstances;
+	block.bFixed = bFixed;
+	vcBlocks.emplace_back(block);
+
+	//the scene packed the blocks from 0 on
+	slotRanges.reset(std::max(slotRanges.getEnd(), base + iInstances));
+}
+
+GLuint InstanceAllocator::allocate(EntityTypeID typeID)
+{
+	InstanceBlock& block = vcBlocks[typeID];
+	if (!block.setFree.empty())
+	{
+		const GLuint instanceID = *block.setFree.begin();
+		block.setFree.erase(block.setFree.begin());
+		return instanceID;
+	}
+
+	if (block.iUsed == block.capacity)
+	{
+		if (block.bFixed)
+			return ciInvalidInstance;
+
+		//doubling keeps the number of moves logarithmic in the instance count
+		const GLuint iCapacity = std::max(block.capacity * 2, 1u);
+		if (!slotRanges.tryGrow(block.base, block.capacity, iCapacity - block.capacity))
+		{
+			const GLuint base = slotRanges.allocate(iCapacity);
+			slotRanges.free(block.base, block.capacity);
+			block.base = base;
+		}
+		block.capacity = iCapacity;
+	}
+	return block.iUsed++;
+}
+
+void InstanceAllocator::free(EntityTypeID typeID, GLuint instanceID)
+{
+	InstanceBlock& block = vcBlocks[typeID];
+	block.setFree.insert(instanceID);
+
+	//trailing free slots shrink the draw instead of being drawn collapsed
+	while (!block.setFree.empty() && *block.setFree.rbegin() == block.iUsed - 1)
+	{
+		block.setFree.erase(std::prev(block.setFree.end()));
+		block.iUsed--;
+	}
+}
@@ -0,0 +1,46 @@
+//slot bookkeeping for the instance transform ssbo, no gl
+//every entity type owns one contiguous block of slots so a single indirect command still draws all of its instances
+//despawned slots go on the type's free list and are handed out again before the block grows
+//a full block grows in place when it can, otherwise it moves to a block twice its size and the old one is freed
+//freed blocks are coalesced and reused first, the slot space only grows at its end
+#pragma once
+#include "SceneDesc.h"
+#include "RangeAllocator.h"
+
+#include <set>
+#include <vector>
+
+struct InstanceBlock
+{
+	GLuint base;
+	GLuint capacity;
+	GLuint iUsed;																//high water mark, the type's draws cover [base, base + iUsed)
+	std::set<GLuint> setFree;													//free instanceIDs below iUsed, lowest handed out first
+	bool bFixed;																//one draw per instance, the block can never move or grow
+	InstanceBlock() : base(0), capacity(0), iUsed(0), bFixed(false) {}
+};
+
+class InstanceAllocator
+{
+public:
+	static constexpr GLuint ciInvalidInstance = 0xffffffff;
+
+	InstanceAllocator() {}
+
+	//call in type id order, the block exactly fits the instances the scene was built with
+	void addType(GLuint base, GLuint iInstances, bool bFixed);
+
+	//instanceID within the type's block, ciInvalidInstance if a fixed block is full
+	//the block may have moved, compare getBlock(typeID).base with the one before
+	GLuint allocate(EntityTypeID typeID);
+	void free(EntityTypeID typeID, GLuint instanceID);
+
+	const InstanceBlock& getBlock(EntityTypeID typeID) const { return vcBlocks[typeID]; }
+
+	//every slot in use is below this, the transform ssbo has to hold at least as many
+	GLuint getSlotEnd() const { return slotRanges.getEnd(); }
+
+private:
+	std::vector<InstanceBlock> vcBlocks;
+	RangeAllocator slotRanges;
+};
@@ -0,0 +1,112 @@
+#include "LevelFile.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+bool loadLevelFile(const std::string& strPath, std::vector<LevelEntity>& vcEntities)
+{
+	FILE* fileLevel = fopen(strPath.c_str(), "r");
+	if (fileLevel == nullptr)
+	{
+		spdlog::error("Failed to open Level file : " + strPath);
+		return false;
+	}
+
+	char szEntityType[64] = "";
+	float x = 0.f, y = 0.f, z = 0.f, yaw = 0.f;
+	float xDim = 0.f, yDim = 0.f, zDim = 0.f;
+	while (fscanf(fileLevel, "%63s", szEntityType) != EOF)
+	{
+		fscanf(fileLevel, "%f,%f,%f", &x, &y, &z);
+
+		if (strcmp(szEntityType, "wall") == 0)
+		{
+			fscanf(fileLevel, "%f,%f,%f", &xDim, &yDim, &zDim);
+			vcEntities.emplace_back(szEntityType, btVector3(x, y, z), 0.f, btVector3(xDim, yDim, zDim));
+		}
+		else
+		{
+			fscanf(fileLevel, "%f", &yaw);
+			vcEntities.emplace_back(szEntityType, btVector3(x, y, z), yaw);
+		}
+	}
+	fclose(fileLevel);
+	return true;
+}
+
+void getLevelBounds(const std::vector<LevelEntity>& vcEntities, btVector3& vMin, btVector3& vMax)
+{
+	const btVector3 vMargin(4.f, 4.f, 4.f);
+	vMin = btVector3(0.f, 0.f, 0.f) - vMargin;
+	vMax = vMargin;
+	for (const auto& entity : vcEntities)
+	{
+		const btVector3 vExtent = entity.strEntityType == "wall" ? entity.vDimensions + vMargin : vMargin;
+		vMin.setMin(entity.vOrigin - vExtent);
+		vMax.setMax(entity.vOrigin + vExtent);
+	}
+}
+
+std::vector<LevelEntity> generateLevel(const LevelGenParams& params)
+{
+	std::vector<LevelEntity> vcEntities;
+
+	//shelves and piles share one square grid, cells are wide enough that neighbours only meet once things fall over
+	const float fCell = 8.f;
+	const int iCells = params.iBookShelves + params.iMugPiles;
+	const int iGrid = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<float>(iCells)))));
+	const float fHalfExtent = iGrid * fCell * 0.5f + fCell;
+
+	//floor and 4 walls around the grid
+	vcEntities.emplace_back("wall", btVector3(0.f, -1.f, 0.f), 0.f, btVector3(fHalfExtent, 1.f, fHalfExtent));
+	vcEntities.emplace_back("wall", btVector3(fHalfExtent, 10.f, 0.f), 0.f, btVector3(1.f, 10.f, fHalfExtent));
+	vcEntities.emplace_back("wall", btVector3(-fHalfExtent, 10.f, 0.f), 0.f, btVector3(1.f, 10.f, fHalfExtent));
+	vcEntities.emplace_back("wall", btVector3(0.f, 10.f, fHalfExtent), 0.f, btVector3(fHalfExtent, 10.f, 1.f));
+	vcEntities.emplace_back("wall", btVector3(0.f, 10.f, -fHalfExtent), 0.f, btVector3(fHalfExtent, 10.f, 1.f));
+
+	auto cellOrigin = [&](int iCell)
+	{
+		return btVector3(
+			(iCell % iGrid - iGrid * 0.5f + 0.5f) * fCell,
+			0.f,
+			(iCell / iGrid - iGrid * 0.5f + 0.5f) * fCell);
+	};
+
+	//same spacing as the books stacked in level.txt, a board every 8 books
+	const float fBookHeight = 0.315f;
+	const float fBoardHeight = 0.121f;
+	for (int s = 0; s < params.iBookShelves; s++)
+	{
+		const btVector3 vCell = cellOrigin(s);
+		float y = 0.f;
+		for (int b = 0; b < params.iBooksPerShelf; b++)
+		{
+			if (b % 8 == 0 && b != 0)
+			{
+				vcEntities.emplace_back("bookShelf", vCell + btVector3(0.f, y + fBoardHeight * 0.5f, 0.f));
+				y += fBoardHeight;
+			}
+			vcEntities.emplace_back("book", vCell + btVector3(0.f, y + fBookHeight * 0.5f, 0.f));
+			y += fBookHeight;
+		}
+	}
+
+	const float fMugHeight = 0.8f;
+	for (int p = 0; p < params.iMugPiles; p++)
+	{
+		const btVector3 vCell = cellOrigin(params.iBookShelves + p);
+		for (int m = 0; m < params.iMugsPerPile; m++)
+		{
+			//pyramid-ish pile, 4 per layer offset a little every layer
+			const int iLayer = m / 4;
+			const float fOffset = (iLayer % 2) * 0.25f;
+			const btVector3 vSlot((m % 2) * 0.85f - 0.425f + fOffset, fMugHeight * (iLayer + 0.5f), ((m / 2) % 2) * 0.85f - 0.425f + fOffset);
+			vcEntities.emplace_back("mug", vCell + vSlot);
+		}
+	}
+
+	return vcEntities;
+}
@@ -0,0 +1,35 @@
+//gl free level description, read from level.txt or generated procedurally for stress scenes
+#pragma once
+#include <LinearMath/btVector3.h>
+#include <string>
+#include <vector>
+
+struct LevelEntity
+{
+	std::string strEntityType;
+	btVector3 vOrigin;
+	float fYaw;
+	btVector3 vDimensions;														//only used by walls, half extents
+	LevelEntity(std::string strEntityType, btVector3 vOrigin, float fYaw = 0.f, btVector3 vDimensions = btVector3(0.f, 0.f, 0.f)) :
+		strEntityType(strEntityType), vOrigin(vOrigin), fYaw(fYaw), vDimensions(vDimensions)
+	{}
+};
+
+//type followed by x,y,z then yaw, walls take x,y,z half extents instead of yaw
+bool loadLevelFile(const std::string& strPath, std::vector<LevelEntity>& vcEntities);
+
+//box around every wall and a few units around every other spawn point, world bounds for the sweep and prune broadphase
+void getLevelBounds(const std::vector<LevelEntity>& vcEntities, btVector3& vMin, btVector3& vMax);
+
+//room floor and walls, iBookShelves shelves filled with iBooksPerShelf stacked books each
+//and iMugPiles piles of iMugsPerPile mugs, laid out on a grid so the scene scales
+struct LevelGenParams
+{
+	int iBookShelves;
+	int iBooksPerShelf;
+	int iMugPiles;
+	int iMugsPerPile;
+	LevelGenParams() : iBookShelves(16), iBooksPerShelf(24), iMugPiles(8), iMugsPerPile(10) {}
+};
+
+std::vector<LevelEntity> generateLevel(const LevelGenParams& params);
@@ -0,0 +1,109 @@
+//motion state keeping the last two fixed step transforms of a dynamic body
+//bullet only calls setWorldTransform for active bodies, so sleeping ones cost nothing here
+//the gpu matrix is written straight into the body's slot in the transform staging buffer, no CTransform round trip
+//static bodies use btDefaultMotionState and never enter the transform pipeline
+#pragma once
+#include "TransformStaging.h"
+#include <LinearMath/btMotionState.h>
+#include <LinearMath/btTransform.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+static_assert(sizeof(btScalar) == sizeof(float), "blended matrices are written straight into float gpu buffers");
+
+class InterpMotionState;
+
+//shared by every motion state of a world, owned by physicssys
+struct MotionSync
+{
+	uint32_t uStepCount;														//fixed steps taken so far
+	std::vector<InterpMotionState*> vcMoving;									//bodies bullet moved that havent settled yet
+	MotionSync() : uStepCount(0) {}
+
+	//despawned bodies have to leave the moving set before their motion state is deleted
+	void remove(InterpMotionState* motionState)
+	{
+		vcMoving.erase(std::remove(vcMoving.begin(), vcMoving.end(), motionState), vcMoving.end());
+	}
+};
+
+class InterpMotionState : public btMotionState
+{
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	InterpMotionState(const btTransform& transStart, MotionSync* motionSync) :
+		transPrevious(transStart),
+		transCurrent(transStart),
+		motionSync(motionSync),
+		transformStaging(nullptr),
+		iSlot(0),
+		uLastStep(0),
+		bMoving(false)
+	{}
+
+	//bodies without a renderable instance (headless worlds) never get a slot
+	void setStagingSlot(TransformStaging* transformStaging, const GLuint iSlot)
+	{
+		this->transformStaging = transformStaging;
+		this->iSlot = iSlot;
+	}
+
+	void getWorldTransform(btTransform& worldTransform) const override
+	{
+		worldTransform = transCurrent;
+	}
+
+	void setWorldTransform(const btTransform& worldTransform) override
+	{
+		transPrevious = transCurrent;
+		transCurrent = worldTransform;
+		uLastStep = motionSync->uStepCount;
+
+		//join the moving set, so per frame work only ever touches awake bodies
+		if (!bMoving)
+		{
+			bMoving = true;
+			motionSync->vcMoving.emplace_back(this);
+		}
+
+		//zero copy path, the latest state goes straight to the gpu staging slot
+		if (transformStaging != nullptr)
+			transCurrent.getOpenGLMatrix(transformStaging->mapSlot(iSlot));
+	}
+
+	//called once per frame for bodies in the moving set, fAlpha is how far the frame is between the last 2 steps
+	//returns false once the body stopped moving, it must then be dropped from the moving set
+	bool blend(const btScalar fAlpha, const bool bInterpolate)
+	{
+		if (uLastStep == motionSync->uStepCount)
+		{
+			if (bInterpolate && transformStaging != nullptr)
+			{
+				btTransform transBlend;
+				transBlend.setOrigin(transPrevious.getOrigin().lerp(transCurrent.getOrigin(), fAlpha));
+				transBlend.setRotation(transPrevious.getRotation().slerp(transCurrent.getRotation(), fAlpha));
+				transBlend.getOpenGLMatrix(transformStaging->mapSlot(iSlot));
+			}
+			return true;
+		}
+
+		//stopped moving, the last blend was somewhere before the final state
+		if (bInterpolate && transformStaging != nullptr)
+			transCurrent.getOpenGLMatrix(transformStaging->mapSlot(iSlot));
+		bMoving = false;
+		return false;
+	}
+
+	const btTransform& getCurrentTransform() const { return transCurrent; }
+
+private:
+	btTransform transPrevious;
+	btTransform transCurrent;
+	MotionSync* motionSync;
+	TransformStaging* transformStaging;
+	GLuint iSlot;													//baseInstance + instanceID
+	uint32_t uLastStep;												//step in which bullet last moved the body
+	bool bMoving;													//in motionSync->vcMoving
+};
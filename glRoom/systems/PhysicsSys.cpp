@@ -1,10 +1,13 @@
 #include "PhysicsSys.h"
 #include "Components.h"
 #include "SystemComponents.h"
+#include "../FrameTracer.h"
 
-#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
 #include <BulletCollision/NarrowPhaseCollision/btRaycastCallback.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <cmath>
 
 #include <btBulletDynamicsCommon.h>
 
@@ -13,22 +16,28 @@ PhysicsSys::PhysicsSys(
 	AppSettings* appSettings,
 	LBtnPressedSubject* lBtnPressedSubject,
 	LBtnMotionSubject* lBtnMotionSubject,
-	LBtnReleasedSubject* lBtnReleasedSubject) :
+	LBtnReleasedSubject* lBtnReleasedSubject,
+	PhysicsSnapshotSubject* physicsSnapshotSubject) :
 	mRegistry(mRegistry),
 	mWidth(appSettings->mWidth),
 	mHeight(appSettings->mHeight),
+	fFixedTimeStep(appSettings->fFixedTimeStep),
+	iMaxSubSteps(appSettings->iMaxSubSteps),
+	fAccumulator(0.f),
+	bInterpolateTransforms(appSettings->bInterpolateTransforms),
 	rigidBodyPicked(nullptr),
 	constraintPicked(nullptr),
 	iSavedActivationState(0),
-	iOriginalPickingDist(0)
+	iOriginalPickingDist(0),
+	bGPUPicking(appSettings->bGPUPicking),
+	bPickRequested(false),
+	bPickPending(false),
+	iPickX(0),
+	iPickY(0)
 {
-	collisionConfig = new btDefaultCollisionConfiguration();
-	dispatcher = new btCollisionDispatcher(collisionConfig);
-	overlappingPairCache = new btDbvtBroadphase();
-	solver = new btSequentialImpulseConstraintSolver;
-
-	dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, overlappingPairCache, solver, collisionConfig);
-	dynamicsWorld->setGravity(btVector3(0, -10, 0));
+	//the room fits well inside the default world bounds
+	physicsWorld = std::make_unique<PhysicsWorld>(appSettings->iPhysicsThreads, appSettings->bAxisSweepBroadphase ? BroadphaseType::AXIS_SWEEP : BroadphaseType::DBVT);
+	dynamicsWorld = physicsWorld->getDynamicsWorld();
 
 	//sys components
 	if (mRegistry->view<SCMatProjection>().empty())
@@ -52,6 +61,7 @@ PhysicsSys::PhysicsSys(
 	pickBodyObs = std::make_unique<PickBodyObs>(lBtnPressedSubject, this);
 	moveBodyObs = std::make_unique<MoveBodyObs>(lBtnMotionSubject, this);
 	releaseBodyObs = std::make_unique<ReleaseBodyObs>(lBtnReleasedSubject, this);
+	physicsSnapshotObs = std::make_unique<PhysicsSnapshotObs>(physicsSnapshotSubject, this);
 }
 
 PhysicsSys::~PhysicsSys()
@@ -61,9 +71,11 @@ PhysicsSys::~PhysicsSys()
 	{
 		dynamicsWorld->removeCollisionObject(physicsBody.rigidBody);
 		delete physicsBody.motionState;
-		delete physicsBody.collisionShape;
 		delete physicsBody.rigidBody;
+		if (physicsBody.bSharedShape)
+			continue;
 
+		delete physicsBody.collisionShape;
 		if (physicsBody.bTriangleShape)
 		{
 			delete physicsBody.vertices;
@@ -74,90 +86,163 @@ PhysicsSys::~PhysicsSys()
 	//erase all CPhysicsBody component from all entities
 	mRegistry->clear<CPhysicsBody>();
 
-	delete dynamicsWorld;
-	delete solver;
-	delete overlappingPairCache;
-	delete dispatcher;
-	delete collisionConfig;
+	physicsWorld.reset();
 }
 
 void PhysicsSys::update(const float& fDeltaTime)
 {
-	//update world
-	dynamicsWorld->stepSimulation(fDeltaTime);
-	
-	btTransform worldTransform;
-	btScalar mat4[16];
-	mRegistry->view<CTransform, CPhysicsBody>().each([&worldTransform, &mat4](const auto entity, CTransform& transform, CPhysicsBody& physicsBody)
+	//advance the world in fixed steps, whatever is left over is carried to the next frame
+	fAccumulator += fDeltaTime;
+	int iSteps = 0;
+	while (fAccumulator >= fFixedTimeStep && iSteps < iMaxSubSteps)
+	{
+		//motion states stamp themselves with this while the world synchronizes them
+		motionSync.uStepCount++;
 		{
-			if (physicsBody.rigidBody->isActive())
-			{
-				physicsBody.motionState->getWorldTransform(worldTransform);
-				worldTransform.getOpenGLMatrix(mat4);
-				transform.matModel = glm::make_mat4(mat4);							//convert to glm::mat4
-				transform.bUpdate = true;
-			}
-		});
+			TRACE_SCOPE("stepSimulation");
+			dynamicsWorld->stepSimulation(fFixedTimeStep, 0, fFixedTimeStep);
+		}
+		fAccumulator -= fFixedTimeStep;
+		iSteps++;
+	}
+
+	//frame took longer than iMaxSubSteps can catch up with, drop the debt instead of spiralling
+	if (fAccumulator >= fFixedTimeStep)
+		fAccumulator = std::fmod(fAccumulator, fFixedTimeStep);
+
+	syncMovingBodies(fAccumulator / fFixedTimeStep);
+}
+
+void PhysicsSys::syncMovingBodies(const float fAlpha)
+{
+	TRACE_SCOPE("PhysicsSys::syncMovingBodies");
+	auto& vcMoving = motionSync.vcMoving;
+	for (size_t i = 0; i < vcMoving.size();)
+	{
+		if (vcMoving[i]->blend(fAlpha, bInterpolateTransforms))
+			i++;
+		else
+		{
+			//settled, swap remove
+			vcMoving[i] = vcMoving.back();
+			vcMoving.pop_back();
+		}
+	}
 }
 
 void PhysicsSys::pickBody(const int iMouseX, const int iMouseY)
+{
+	//debug only draw mode has no objects in the id buffer
+	const DrawMode drawMode = mRegistry->get<SCDrawMode>(mRegistry->view<SCDrawMode>()[0]).drawMode;
+	if (!bGPUPicking || drawMode == DrawMode::DEBUG)
+	{
+		pickBodyRay(iMouseX, iMouseY);
+		return;
+	}
+
+	iPickX = iMouseX;
+	iPickY = iMouseY;
+	bPickRequested = true;
+	bPickPending = true;
+}
+
+bool PhysicsSys::takePickRequest(int& iMouseX, int& iMouseY)
+{
+	if (!bPickRequested)
+		return false;
+	iMouseX = iPickX;
+	iMouseY = iPickY;
+	bPickRequested = false;
+	return true;
+}
+
+void PhysicsSys::pickEntity(entt::entity e)
+{
+	if (!bPickPending)
+		return;
+	bPickPending = false;
+
+	//room, foreground or nothing under the cursor
+	if (e == entt::null)
+		return;
+	btRigidBody* body = mRegistry->get<CPhysicsBody>(e).rigidBody;
+	if (body->isStaticObject() || body->isKinematicObject())
+		return;
+
+	//exact pivot from the one body, no broadphase or walls in the way
+	const auto& scView = mRegistry->get<SCView>(eView);
+	btVector3 vRayFrom(scView.vCamPos.x, scView.vCamPos.y, scView.vCamPos.z);
+	btVector3 vRayTo = getRayTo(scView.matView, vRayFrom, iPickX, iPickY);
+	btTransform transFrom, transTo;
+	transFrom.setIdentity();
+	transFrom.setOrigin(vRayFrom);
+	transTo.setIdentity();
+	transTo.setOrigin(vRayTo);
+	btCollisionWorld::ClosestRayResultCallback rayCallback(vRayFrom, vRayTo);
+	rayCallback.m_flags |= btTriangleRaycastCallback::kF_UseGjkConvexCastRaytest;
+	btCollisionWorld::rayTestSingle(transFrom, transTo, body, body->getCollisionShape(), body->getWorldTransform(), rayCallback);
+
+	//the body moved since the frame the id was read from, the whole world ray test still knows where it is
+	if (!rayCallback.hasHit())
+	{
+		pickBodyRay(iPickX, iPickY);
+		return;
+	}
+	attachPickConstraint(body, rayCallback.m_hitPointWorld, vRayFrom);
+}
+
+void PhysicsSys::pickBodyRay(const int iMouseX, const int iMouseY)
 {
 	//pick body by creating a raycast from camera pos to where the mouse clicked
 	const auto& scView = mRegistry->get<SCView>(eView);
 	btVector3 vRayFrom(scView.vCamPos.x, scView.vCamPos.y, scView.vCamPos.z);
 	btVector3 vRayTo = getRayTo(scView.matView, vRayFrom, iMouseX, iMouseY);
-	btCollisionWorld::AllHitsRayResultCallback rayCallback(vRayFrom, vRayTo);
+	btCollisionWorld::ClosestRayResultCallback rayCallback(vRayFrom, vRayTo);
 	rayCallback.m_flags |= btTriangleRaycastCallback::kF_UseGjkConvexCastRaytest;
+	//the mask lets the ray pass thru invisible walls and static props, the closest hit is the movable object
+	rayCallback.m_collisionFilterGroup = ciGroupRay;
+	rayCallback.m_collisionFilterMask = getCollisionMask(ciGroupRay);
 	dynamicsWorld->rayTest(vRayFrom, vRayTo, rayCallback);
 
-	//the ray must pass thru invisible walls, ignore it and pick up the movable object
 	//check if ray hit anything
 	if (rayCallback.hasHit())
 	{
-		//iterate every object but skip invisible walls obviously
-		for (int i = 0; i < rayCallback.m_collisionObjects.size(); i++)
-		{
-			btRigidBody* body = (btRigidBody*)btRigidBody::upcast(rayCallback.m_collisionObjects[i]);
-			if (body)
-			{
-				//other exclusions like static ground object
-				if (!(body->isStaticObject() || body->isKinematicObject()))
-				{
-					//ray hit position on body
-					btVector3 pickPos = rayCallback.m_hitPointWorld[i];
-
-					rigidBodyPicked = body;
-					//store the state, which will be restored later when the body is no longer picked
-					iSavedActivationState = rigidBodyPicked->getActivationState();
-					//activate body if its somehow deactive so it recieves the pybullet simulation calculation updates
-					rigidBodyPicked->setActivationState(DISABLE_DEACTIVATION);
-
-					//set pivots for constraints, mainly pivotA which is the body at its picking position
-					//pivotB will be the mouse position where it goes
-					btVector3 localPivot = body->getCenterOfMassTransform().inverse() * pickPos;
-					btPoint2PointConstraint* p2pConstraint = new btPoint2PointConstraint(*body, localPivot);
-					dynamicsWorld->addConstraint(p2pConstraint, true);
-					constraintPicked = p2pConstraint;
-
-					//mouse clamping, how responsively the object must follow the mouse
-					btScalar mousePickClamping = 100.f;
-					p2pConstraint->m_setting.m_impulseClamp = mousePickClamping;
-					//weak constraint for picking
-					p2pConstraint->m_setting.m_tau = .001f;
-
-					mRegistry->emplace<CPickedBody>(static_cast<entt::entity>(rigidBodyPicked->getUserIndex()));
-
-					//set the original distance from where the object was first picked
-					iOriginalPickingDist = (pickPos - vRayFrom).length();
-
-					//break and ignore the rest
-					break;
-				}
-			}
-		}
+		btRigidBody* body = (btRigidBody*)btRigidBody::upcast(rayCallback.m_collisionObject);
+		if (body)
+			attachPickConstraint(body, rayCallback.m_hitPointWorld, vRayFrom);
 	}
 }
 
+void PhysicsSys::attachPickConstraint(btRigidBody* body, const btVector3& vPickPos, const btVector3& vRayFrom)
+{
+	rigidBodyPicked = body;
+	//store the state, which will be restored later when the body is no longer picked
+	iSavedActivationState = rigidBodyPicked->getActivationState();
+	//activate body if its somehow deactive so it recieves the pybullet simulation calculation updates
+	rigidBodyPicked->setActivationState(DISABLE_DEACTIVATION);
+	//pick rays skip it until its released
+	rigidBodyPicked->getBroadphaseHandle()->m_collisionFilterGroup = ciGroupPicked;
+	rigidBodyPicked->getBroadphaseHandle()->m_collisionFilterMask = getCollisionMask(ciGroupPicked);
+
+	//set pivots for constraints, mainly pivotA which is the body at its picking position
+	//pivotB will be the mouse position where it goes
+	btVector3 localPivot = body->getCenterOfMassTransform().inverse() * vPickPos;
+	btPoint2PointConstraint* p2pConstraint = new btPoint2PointConstraint(*body, localPivot);
+	dynamicsWorld->addConstraint(p2pConstraint, true);
+	constraintPicked = p2pConstraint;
+
+	//mouse clamping, how responsively the object must follow the mouse
+	btScalar mousePickClamping = 100.f;
+	p2pConstraint->m_setting.m_impulseClamp = mousePickClamping;
+	//weak constraint for picking
+	p2pConstraint->m_setting.m_tau = .001f;
+
+	mRegistry->emplace<CPickedBody>(static_cast<entt::entity>(rigidBodyPicked->getUserIndex()));
+
+	//set the original distance from where the object was first picked
+	iOriginalPickingDist = (vPickPos - vRayFrom).length();
+}
+
 btVector3 PhysicsSys::getRayTo(const glm::mat4& matView, const btVector3& vRayFrom, const int& iMouseX, const int& iMouseY)
 {
 	float fx = (2.0f * iMouseX) / (float)(mWidth)-1.0f;
@@ -173,6 +258,10 @@ btVector3 PhysicsSys::getRayTo(const glm::mat4& matView, const btVector3& vRayFr
 
 void PhysicsSys::releaseBody()
 {
+	//released before its id arrived
+	bPickRequested = false;
+	bPickPending = false;
+
 	if (constraintPicked != nullptr)
 	{
 		//update registry
@@ -180,6 +269,8 @@ void PhysicsSys::releaseBody()
 
 		//restore state that object was on before it was picked
 		rigidBodyPicked->forceActivationState(iSavedActivationState);
+		rigidBodyPicked->getBroadphaseHandle()->m_collisionFilterGroup = ciGroupDynamic;
+		rigidBodyPicked->getBroadphaseHandle()->m_collisionFilterMask = getCollisionMask(ciGroupDynamic);
 		rigidBodyPicked->activate();
 		dynamicsWorld->removeConstraint(constraintPicked);
 		delete constraintPicked;
@@ -213,6 +304,41 @@ void PhysicsSys::moveBody(const int iMouseX, const int iMouseY)
 	}
 }
 
+void PhysicsSys::saveSnapshot(PhysicsSnapshot& snapshot)
+{
+	physicsWorld->saveSnapshot(snapshot);
+	snapshot.fAccumulator = fAccumulator;
+}
+
+void PhysicsSys::restoreSnapshot(const PhysicsSnapshot& snapshot)
+{
+	//the pick constraint would yank the restored body straight back
+	releaseBody();
+	physicsWorld->restoreSnapshot(snapshot);
+	fAccumulator = snapshot.fAccumulator;
+
+	//the motion states already wrote the gpu slots, only the registry's copy is left
+	auto view = mRegistry->view<CPhysicsBody, CTransform>();
+	for (auto [entity, physicsBody, cTransform] : view.each())
+	{
+		if (!physicsBody.rigidBody->isStaticOrKinematicObject())
+			physicsBody.rigidBody->getWorldTransform().getOpenGLMatrix(glm::value_ptr(cTransform.matModel));
+	}
+}
+
+void PhysicsSys::quickSave()
+{
+	saveSnapshot(quickSnapshot);
+	spdlog::info("Saved physics snapshot, " + std::to_string(quickSnapshot.vcBodies.size()) + " bodies");
+}
+
+void PhysicsSys::quickLoad()
+{
+	auto start = std::chrono::steady_clock::now();
+	restoreSnapshot(quickSnapshot);
+	spdlog::info("Restored physics snapshot in " + std::to_string(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count()) + " us");
+}
+
 btDiscreteDynamicsWorld* PhysicsSys::getDynamicsWorld()
 {
 	return dynamicsWorld;
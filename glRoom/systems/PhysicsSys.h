@@ -2,20 +2,20 @@
 #pragma once
 #include "../AppSettings.h"
 #include "Subjects.h"
-#include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
-#include <BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
-#include <BulletCollision/BroadphaseCollision/btBroadphaseInterface.h>
-#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
+#include "MotionState.h"
+#include "PhysicsWorld.h"
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
 #include <entt/entity/registry.hpp>
 #include <glm/mat4x4.hpp>
 #include <SDL_events.h>
+#include <cstdint>
 
 #include <btBulletDynamicsCommon.h>
 
 class PickBodyObs;
 class MoveBodyObs;
 class ReleaseBodyObs;
+class PhysicsSnapshotObs;
 
 class PhysicsSys
 {
@@ -25,29 +25,55 @@ public:
 		AppSettings* appSettings,
 		LBtnPressedSubject* lBtnPressedSubject,
 		LBtnMotionSubject* lBtnMotionSubject,
-		LBtnReleasedSubject* lBtnReleasedSubject);
+		LBtnReleasedSubject* lBtnReleasedSubject,
+		PhysicsSnapshotSubject* physicsSnapshotSubject);
 	~PhysicsSys();
 
 	void update(const float& fDeltaTime);
 	btDiscreteDynamicsWorld* getDynamicsWorld();
+	MotionSync* getMotionSync() { return &motionSync; }						//handed to every InterpMotionState
+	bool isMultithreaded() const { return physicsWorld->isMultithreaded(); }
+	void optimizeBroadphase() { physicsWorld->optimizeBroadphase(); }			//once the level is loaded
+	//with gpu picking a click only queues a request, PlayState resolves it with pickEntity once the id is read back
 	void pickBody(const int iMouseX, const int iMouseY);
+	bool takePickRequest(int& iMouseX, int& iMouseY);
+	//entity the id buffer held under the click, entt::null for none, the ray only runs against its body for the pivot
+	void pickEntity(entt::entity e);
 	void moveBody(const int iMouseX, const int iMouseY);
 	void releaseBody();															
 
+	//every dynamic body plus the CTransform mirror, for resetting the room and starting perf runs from the same state
+	//simulation stage only, restoring drops a picked body
+	void saveSnapshot(PhysicsSnapshot& snapshot);
+	void restoreSnapshot(const PhysicsSnapshot& snapshot);
+
+	//the hotkey snapshot, holds the room as loaded until the first save
+	void quickSave();
+	void quickLoad();
+
 private:
+	//blend / settle the bodies bullet moved, cost scales with awake bodies only
+	void syncMovingBodies(const float fAlpha);
+	//fallback, ray test through the whole world
+	void pickBodyRay(const int iMouseX, const int iMouseY);
+	void attachPickConstraint(btRigidBody* body, const btVector3& vPickPos, const btVector3& vRayFrom);
 	//convert mouse coordinates into world position for ray 
 	btVector3 getRayTo(const glm::mat4& matView, const btVector3& vRayFrom, const int& iMouseX, const int& iMouseY);
 
 	entt::registry* mRegistry;
-	btDefaultCollisionConfiguration* collisionConfig;
-	btCollisionDispatcher* dispatcher;
-	btBroadphaseInterface* overlappingPairCache;
-	btSequentialImpulseConstraintSolver* solver;
-	btDiscreteDynamicsWorld* dynamicsWorld;
+	std::unique_ptr<PhysicsWorld> physicsWorld;
+	btDiscreteDynamicsWorld* dynamicsWorld;						//owned by physicsWorld
 
 	entt::entity eMatProj;
 	entt::entity eView;											//SCView system component entity
 
+	//fixed timestep
+	float fFixedTimeStep;
+	int iMaxSubSteps;
+	float fAccumulator;											//simulation time still owed to the world
+	bool bInterpolateTransforms;
+	MotionSync motionSync;
+
 	int mWidth, mHeight;										//window dimensions
 
 	//picked body characteristics
@@ -55,10 +81,16 @@ private:
 	btTypedConstraint* constraintPicked;
 	int iOriginalPickingDist;									//the distance from where the object is first picked when ray is sent from camerapos
 	int iSavedActivationState;
+	bool bGPUPicking;
+	bool bPickRequested;										//click not handed to the renderer yet
+	bool bPickPending;											//click waiting for its id, dropped when the button is released first
+	int iPickX, iPickY;
 
 	std::unique_ptr<PickBodyObs> pickBodyObs;
 	std::unique_ptr<MoveBodyObs> moveBodyObs;
 	std::unique_ptr<ReleaseBodyObs> releaseBodyObs;
+	std::unique_ptr<PhysicsSnapshotObs> physicsSnapshotObs;
+	PhysicsSnapshot quickSnapshot;
 };
 
 
@@ -132,3 +164,29 @@ private:
 	LBtnReleasedSubject* lBtnReleasedSubject;
 	PhysicsSys* physicsSys;
 };
+
+class PhysicsSnapshotObs : public IObserver
+{
+public:
+	PhysicsSnapshotObs(PhysicsSnapshotSubject* physicsSnapshotSubject, PhysicsSys* physicsSys) :
+		physicsSnapshotSubject(physicsSnapshotSubject),
+		physicsSys(physicsSys)
+	{
+		physicsSnapshotSubject->attach(this);
+	}
+	~PhysicsSnapshotObs()
+	{
+		physicsSnapshotSubject->dettach(this);
+	}
+	void onNotify() override
+	{
+		if (physicsSnapshotSubject->isRestore())
+			physicsSys->quickLoad();
+		else
+			physicsSys->quickSave();
+	}
+
+private:
+	PhysicsSnapshotSubject* physicsSnapshotSubject;
+	PhysicsSys* physicsSys;
+};
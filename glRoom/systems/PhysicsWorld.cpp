@@ -0,0 +1,185 @@
+#include "PhysicsWorld.h"
+
+#include <BulletCollision/BroadphaseCollision/btAxisSweep3.h>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <BulletDynamics/Dynamics/btRigidBody.h>
+#include <spdlog/spdlog.h>
+#include <unordered_set>
+
+PhysicsWorld::PhysicsWorld(int iNumThreads, BroadphaseType broadphaseType, const btVector3& vWorldMin, const btVector3& vWorldMax) :
+	broadphaseType(broadphaseType),
+	vWorldMin(vWorldMin),
+	vWorldMax(vWorldMax),
+	collisionConfig(nullptr),
+	dispatcher(nullptr),
+	overlappingPairCache(nullptr),
+	solver(nullptr),
+	solverPool(nullptr),
+	dynamicsWorld(nullptr)
+{
+#if !BT_THREADSAFE
+	if (iNumThreads > 1)
+	{
+		spdlog::warn("Bullet was built without BT_THREADSAFE, falling back to the single threaded world");
+		iNumThreads = 1;
+	}
+#else
+	//every pool thread may steal bullet's jobs, a pool bullet cant index would overflow its per thread storage
+	if (iNumThreads > 1 && JobSystem::get().getNumThreads() > static_cast<unsigned int>(BT_MAX_THREAD_COUNT))
+	{
+		spdlog::warn("Job system has " + std::to_string(JobSystem::get().getNumThreads()) + " threads, more than bullet's "
+			+ std::to_string(BT_MAX_THREAD_COUNT) + ", falling back to the single threaded world");
+		iNumThreads = 1;
+	}
+#endif
+
+	if (iNumThreads > 1)
+		initMultithreaded(iNumThreads);
+	else
+		initSingleThreaded();
+
+	dynamicsWorld->setGravity(btVector3(0, -10, 0));
+
+	//only awake bodies get their aabb refreshed every step, static ones never move on their own
+	//and refreshing them would pull them back out of dbvt's static tree every step
+	//whatever teleports a body has to call updateSingleAabb itself
+	dynamicsWorld->setForceUpdateAllAabbs(false);
+}
+
+PhysicsWorld::~PhysicsWorld()
+{
+	//bodies / constraints must already be removed by the owner
+	delete dynamicsWorld;
+	delete solverPool;
+	delete solver;
+	delete overlappingPairCache;
+	delete dispatcher;
+	delete collisionConfig;
+
+	if (taskScheduler)
+	{
+		btSetTaskScheduler(btGetSequentialTaskScheduler());
+		taskScheduler.reset();
+	}
+}
+
+void PhysicsWorld::initSingleThreaded()
+{
+	collisionConfig = new btDefaultCollisionConfiguration();
+	dispatcher = new btCollisionDispatcher(collisionConfig);
+	overlappingPairCache = createBroadphase();
+	solver = new btSequentialImpulseConstraintSolver;
+	dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, overlappingPairCache, solver, collisionConfig);
+}
+
+void PhysicsWorld::initMultithreaded(int iNumThreads)
+{
+	taskScheduler = std::make_unique<BulletTaskScheduler>(&JobSystem::get(), iNumThreads);
+	btSetTaskScheduler(taskScheduler.get());
+
+	//collapse scenes create lots of contacts at once, start with big pools so they dont grow mid step
+	btDefaultCollisionConstructionInfo constructionInfo;
+	constructionInfo.m_defaultMaxPersistentManifoldPoolSize = 80000;
+	constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = 80000;
+	collisionConfig = new btDefaultCollisionConfiguration(constructionInfo);
+	dispatcher = new btCollisionDispatcherMt(collisionConfig, 40);
+	overlappingPairCache = createBroadphase();
+
+	//one sequential solver per concurrently working thread solving islands in parallel, plus the mt solver for the big islands
+	solverPool = new btConstraintSolverPoolMt(taskScheduler->getConcurrency());
+	solver = new btSequentialImpulseConstraintSolverMt();
+	dynamicsWorld = new btDiscreteDynamicsWorldMt(dispatcher, overlappingPairCache, solverPool, solver, collisionConfig);
+
+	spdlog::info("Physics running multithreaded on " + std::to_string(taskScheduler->getConcurrency()) + " threads");
+}
+
+btBroadphaseInterface* PhysicsWorld::createBroadphase()
+{
+	if (broadphaseType == BroadphaseType::AXIS_SWEEP)
+		return new bt32BitAxisSweep3(vWorldMin, vWorldMax, ciMaxSweepHandles);
+	return new btDbvtBroadphase();
+}
+
+void PhysicsWorld::optimizeBroadphase()
+{
+	//sweep and prune keeps sorted axes, there is no tree to rebuild
+	if (broadphaseType != BroadphaseType::DBVT)
+		return;
+
+	//dbvt moves every body that wasnt updated for STAGECOUNT collides into its static tree, nothing was updated since the load
+	btDbvtBroadphase* broadphase = static_cast<btDbvtBroadphase*>(overlappingPairCache);
+	for (int i = 0; i < btDbvtBroadphase::STAGECOUNT; i++)
+		broadphase->collide(dispatcher);
+
+	//awake bodies go straight back to the dynamic tree, the static tree keeps the static and sleeping ones
+	dynamicsWorld->updateAabbs();
+	broadphase->optimize();
+}
+
+void PhysicsWorld::saveSnapshot(PhysicsSnapshot& snapshot)
+{
+	snapshot.vcBodies.clear();
+	const btCollisionObjectArray& collisionObjects = dynamicsWorld->getCollisionObjectArray();
+	for (int i = 0; i < collisionObjects.size(); i++)
+	{
+		btRigidBody* rigidBody = btRigidBody::upcast(collisionObjects[i]);
+		if (rigidBody == nullptr || rigidBody->isStaticOrKinematicObject())
+			continue;
+
+		BodySnapshot& body = snapshot.vcBodies.emplace_back();
+		body.transWorld = rigidBody->getWorldTransform();
+		body.vLinearVelocity = rigidBody->getLinearVelocity();
+		body.vAngularVelocity = rigidBody->getAngularVelocity();
+		body.rigidBody = rigidBody;
+		body.fDeactivationTime = rigidBody->getDeactivationTime();
+		body.iUserIndex = rigidBody->getUserIndex();
+		body.iActivationState = rigidBody->getActivationState();
+	}
+}
+
+int PhysicsWorld::restoreSnapshot(const PhysicsSnapshot& snapshot)
+{
+	const btCollisionObjectArray& collisionObjects = dynamicsWorld->getCollisionObjectArray();
+	std::unordered_set<const btCollisionObject*> setLive;
+	setLive.reserve(collisionObjects.size());
+	for (int i = 0; i < collisionObjects.size(); i++)
+		setLive.insert(collisionObjects[i]);
+
+	int iRestored = 0;
+	for (const BodySnapshot& body : snapshot.vcBodies)
+	{
+		btRigidBody* rigidBody = body.rigidBody;
+		if (setLive.count(rigidBody) == 0 || rigidBody->getUserIndex() != body.iUserIndex)
+			continue;
+
+		rigidBody->setWorldTransform(body.transWorld);
+		rigidBody->setInterpolationWorldTransform(body.transWorld);
+		rigidBody->setLinearVelocity(body.vLinearVelocity);
+		rigidBody->setAngularVelocity(body.vAngularVelocity);
+		rigidBody->setInterpolationLinearVelocity(body.vLinearVelocity);
+		rigidBody->setInterpolationAngularVelocity(body.vAngularVelocity);
+		rigidBody->clearForces();
+		rigidBody->forceActivationState(body.iActivationState);
+		rigidBody->setDeactivationTime(body.fDeactivationTime);
+
+		//twice so an interpolating motion state has nothing older to blend from
+		if (btMotionState* motionState = rigidBody->getMotionState())
+		{
+			motionState->setWorldTransform(body.transWorld);
+			motionState->setWorldTransform(body.transWorld);
+		}
+		dynamicsWorld->updateSingleAabb(rigidBody);
+
+		//the pairs have to stay, dbvt only looks for new ones once a proxy leaves its fat aabb and sweep and prune
+		//only when endpoints cross, dropping the manifolds is enough to lose the old contacts
+		overlappingPairCache->getOverlappingPairCache()->cleanProxyFromPairs(rigidBody->getBroadphaseHandle(), dispatcher);
+		iRestored++;
+	}
+
+	dynamicsWorld->getConstraintSolver()->reset();
+	return iRestored;
+}
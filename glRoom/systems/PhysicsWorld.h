@@ -0,0 +1,113 @@
+//builds and owns the bullet dynamics world and everything it depends on
+//no gl, no registry, so it can also be used headless by the benchmarks
+#pragma once
+#include "BulletTaskScheduler.h"
+#include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
+#include <BulletCollision/BroadphaseCollision/btBroadphaseInterface.h>
+#include <BulletDynamics/ConstraintSolver/btConstraintSolver.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <memory>
+#include <vector>
+
+class btConstraintSolverPoolMt;
+
+//collision filter groups, a body pair only reaches the narrowphase and a ray only hits a body when each ones group is in the others mask
+static constexpr int ciGroupStatic = 1 << 0;												//room and static props
+static constexpr int ciGroupWall = 1 << 1;													//invisible walls
+static constexpr int ciGroupDynamic = 1 << 2;
+static constexpr int ciGroupPicked = 1 << 3;												//the body held by the mouse
+static constexpr int ciGroupRay = 1 << 4;													//pick rays, never a body
+
+//static things never touch each other and rays only look for something to pick up
+inline int getCollisionMask(int iGroup)
+{
+	switch (iGroup)
+	{
+	case ciGroupStatic:
+	case ciGroupWall:
+		return ciGroupDynamic | ciGroupPicked;
+	case ciGroupDynamic:
+		return ciGroupStatic | ciGroupWall | ciGroupDynamic | ciGroupPicked | ciGroupRay;
+	case ciGroupPicked:
+		return ciGroupStatic | ciGroupWall | ciGroupDynamic;
+	case ciGroupRay:
+		return ciGroupDynamic;
+	}
+	return 0;
+}
+
+//everything that moves a dynamic body, restoring it puts the body back exactly where and how fast it was
+struct BodySnapshot
+{
+	btTransform transWorld;
+	btVector3 vLinearVelocity;
+	btVector3 vAngularVelocity;
+	btRigidBody* rigidBody;
+	btScalar fDeactivationTime;
+	int iUserIndex;																//entity in the game, a new body at a freed body's address wont match
+	int iActivationState;
+};
+
+//one contiguous buffer, static bodies cant move so they are never in it
+struct PhysicsSnapshot
+{
+	std::vector<BodySnapshot> vcBodies;
+	float fAccumulator;															//step time PhysicsSys still owed the world
+	PhysicsSnapshot() : fAccumulator(0.f) {}
+	bool empty() const { return vcBodies.empty(); }
+};
+
+enum class BroadphaseType
+{
+	DBVT,																		//2 aabb trees, unbounded, static bodies end up in a tree of their own
+	AXIS_SWEEP																	//sweep and prune, only bodies inside the world bounds are cheap
+};
+
+class PhysicsWorld
+{
+public:
+	//iNumThreads <= 1 builds the plain single threaded world
+	//otherwise btDiscreteDynamicsWorldMt with a solver pool, with up to iNumThreads threads of the JobSystem working on it
+	//the world bounds are only used by AXIS_SWEEP, which holds up to ciMaxSweepHandles bodies
+	PhysicsWorld(int iNumThreads = 1, BroadphaseType broadphaseType = BroadphaseType::DBVT, const btVector3& vWorldMin = btVector3(-64.f, -64.f, -64.f), const btVector3& vWorldMax = btVector3(64.f, 64.f, 64.f));
+	~PhysicsWorld();
+
+	static constexpr unsigned int ciMaxSweepHandles = 1 << 17;
+
+	btDiscreteDynamicsWorld* getDynamicsWorld() { return dynamicsWorld; }
+	btBroadphaseInterface* getBroadphase() { return overlappingPairCache; }
+	BroadphaseType getBroadphaseType() const { return broadphaseType; }
+	bool isMultithreaded() const { return solverPool != nullptr; }
+	int getNumThreads() const { return taskScheduler ? taskScheduler->getConcurrency() : 1; }
+
+	//once after a bulk load, dbvt moves every static body into its static tree right away and rebuilds both trees top down
+	//instead of growing them one insert at a time, bodies added later still migrate on their own after a couple of steps
+	void optimizeBroadphase();
+
+	//every dynamic body in the world, overwrites snapshot
+	void saveSnapshot(PhysicsSnapshot& snapshot);
+	//bodies added since are left as they are, removed ones are skipped, returns how many got restored
+	//contacts of restored bodies are dropped so no warm started impulse from the old state leaks into the restored one,
+	//their broadphase pairs are kept
+	//the owner must not hold constraints on restored bodies
+	int restoreSnapshot(const PhysicsSnapshot& snapshot);
+
+private:
+	void initSingleThreaded();
+	void initMultithreaded(int iNumThreads);
+	btBroadphaseInterface* createBroadphase();
+
+	BroadphaseType broadphaseType;
+	btVector3 vWorldMin;
+	btVector3 vWorldMax;
+
+	btDefaultCollisionConfiguration* collisionConfig;
+	btCollisionDispatcher* dispatcher;
+	btBroadphaseInterface* overlappingPairCache;
+	btConstraintSolver* solver;
+	btConstraintSolverPoolMt* solverPool;
+	btDiscreteDynamicsWorld* dynamicsWorld;
+
+	std::unique_ptr<BulletTaskScheduler> taskScheduler;
+};
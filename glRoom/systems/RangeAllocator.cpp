@@ -0,0 +1,86 @@
+#include "RangeAllocator.h"
+
+#include <iterator>
+
+GLuint RangeAllocator::allocate(GLuint iSize)
+{
+	for (auto iter = mapFreeRanges.begin(); iter != mapFreeRanges.end(); iter++)
+	{
+		if (iter->second < iSize)
+			continue;
+
+		const GLuint base = iter->first;
+		const GLuint iLeft = iter->second - iSize;
+		mapFreeRanges.erase(iter);
+		if (iLeft > 0)
+			mapFreeRanges.emplace(base + iSize, iLeft);
+		iFreeSize -= iSize;
+		return base;
+	}
+
+	const GLuint base = iEnd;
+	iEnd += iSize;
+	return base;
+}
+
+void RangeAllocator::free(GLuint base, GLuint iSize)
+{
+	if (iSize == 0)
+		return;
+
+	//merge with the neighbours on both sides
+	iFreeSize += iSize;
+	auto iterNext = mapFreeRanges.lower_bound(base);
+	if (iterNext != mapFreeRanges.end() && iterNext->first == base + iSize)
+	{
+		iSize += iterNext->second;
+		iterNext = mapFreeRanges.erase(iterNext);
+	}
+	if (iterNext != mapFreeRanges.begin())
+	{
+		auto iterPrev = std::prev(iterNext);
+		if (iterPrev->first + iterPrev->second == base)
+		{
+			base = iterPrev->first;
+			iSize += iterPrev->second;
+			mapFreeRanges.erase(iterPrev);
+		}
+	}
+
+	//the tail goes back to the unused end
+	if (base + iSize == iEnd)
+	{
+		iEnd = base;
+		iFreeSize -= iSize;
+	}
+	else
+		mapFreeRanges.emplace(base, iSize);
+}
+
+bool RangeAllocator::tryGrow(GLuint base, GLuint iSize, GLuint iExtra)
+{
+	const GLuint end = base + iSize;
+	if (end == iEnd)
+	{
+		iEnd += iExtra;
+		return true;
+	}
+
+	auto iter = mapFreeRanges.find(end);
+	if (iter == mapFreeRanges.end() || iter->second < iExtra)
+		return false;
+
+	const GLuint iLeft = iter->second - iExtra;
+	mapFreeRanges.erase(iter);
+	if (iLeft > 0)
+		mapFreeRanges.emplace(end + iExtra, iLeft);
+	iFreeSize -= iExtra;
+	return true;
+}
+
+void RangeAllocator::reset(GLuint iEnd)
+{
+	mapFreeRanges.clear();
+	this->iEnd = iEnd;
+	iFreeSize = 0;
+}
@@ -0,0 +1,31 @@
+//first fit sub allocator over a range of abstract units (slots, vertices, indices), no gl
+//freed ranges are coalesced with their neighbours, a free range reaching the end shrinks the used extent instead
+#pragma once
+#include <GL/glew.h>
+#include <map>
+
+class RangeAllocator
+{
+public:
+	RangeAllocator() : iEnd(0), iFreeSize(0) {}
+
+	GLuint allocate(GLuint iSize);
+	void free(GLuint base, GLuint iSize);
+
+	//extends [base, base + iSize) by iExtra in place, when it ends at the used extent or a big enough free range follows it
+	bool tryGrow(GLuint base, GLuint iSize, GLuint iExtra);
+
+	//forgets every free range, [0, iEnd) counts as allocated, for layouts made elsewhere or just compacted
+	void reset(GLuint iEnd);
+
+	//everything allocated lies below this
+	GLuint getEnd() const { return iEnd; }
+
+	//free units below the end, lost to fragmentation until something fits them
+	GLuint getFreeSize() const { return iFreeSize; }
+
+private:
+	std::map<GLuint, GLuint> mapFreeRanges;										//base -> size, never adjacent to each other or to iEnd
+	GLuint iEnd;
+	GLuint iFreeSize;
+};
@@ -0,0 +1,28 @@
+//everything the render stage needs from one simulated frame
+//the simulation fills one snapshot while the gl thread renders the other, so rendering never reads the registry
+//moved instance transforms travel separately through the regions of TransformStaging
+#pragma once
+#include "SystemComponents.h"
+#include <GL/glew.h>
+#include <glm/mat4x4.hpp>
+#include <utility>
+#include <vector>
+
+struct RenderSnapshot
+{
+	glm::mat4 matView;
+	DrawMode drawMode;
+	bool bBackgroundQuad;														//foreground quad tex coords, uploaded when they scrolled
+	float backgroundTexCoords[8];
+	std::vector<std::pair<GLuint, GLuint64>> vcTexHandleWrites;					//emissive drawID, bindless handle to show from now on
+	unsigned int iAudioCues;
+
+	RenderSnapshot() : matView(1.f), drawMode(DrawMode::NORMAL), bBackgroundQuad(false), backgroundTexCoords{}, iAudioCues(0) {}
+
+	//per frame events, the state fields are simply overwritten
+	void clearEvents()
+	{
+		vcTexHandleWrites.clear();
+		iAudioCues = 0;
+	}
+};
@@ -1,4 +1,6 @@
 #pragma once
+#include "GeometryArena.h"
+
 #include <GL/glew.h>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
@@ -21,14 +23,13 @@ enum class RSType
 	EMISSIVE
 };
 
+//geometry of every render state lives in the scene's GeometryArena, commands carry its baseVertex / firstIndex
 struct RenderState
 {
 	GLuint primCount;
-	GLuint vao;
-	GLuint ebo;
 	GLuint ssboFrag;										//ssbo for bindless textures OR normal mesh colors for fragment shader
 	void* drawCmdOffset;
-	RenderState() : vao(0), ssboFrag(0), ebo(0), drawCmdOffset(0), primCount(0) {}
+	RenderState() : ssboFrag(0), drawCmdOffset(0), primCount(0) {}
 };
 
 struct RSLoader
@@ -49,11 +50,9 @@ struct RSLoader
 //used by stencil testing models like room model / foreground quad, direct draw 
 struct GeometryState
 {
-	GLuint vao;
-	GLuint ebo;
-	GLuint count;
+	GeometryHandle geometry;									//range in the GeometryArena, looked up at draw time since it may move
 	GLuint ssboFrag;											//texture / color
-	GeometryState() : vao(0), ebo(0), count(0), ssboFrag(0) {}
+	GeometryState() : geometry(ciInvalidGeometry), ssboFrag(0) {}
 };
 
 struct VertexTupple
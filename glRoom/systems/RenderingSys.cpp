@@ -1,30 +1,49 @@
 #include "RenderingSys.h"
+#include "../FrameTracer.h"
 
 #include <GL/glew.h>
+#include <algorithm>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <spdlog/spdlog.h>
 
 #include <stb_image.h>
 
+template<typename T>
+T* RenderingSys::acquireShader(const std::string& strKey, const std::string& strVS, const std::string& strFS, const std::string& strDefines)
+{
+	T* shader = nullptr;
+	if (!resourceManager->acquire(strKey, shader))
+	{
+		shader = new T(strVS.c_str(), strFS.c_str(), strDefines);
+		resourceManager->insert<T*>(strKey, shader, 64 * 1024, [](T*& shader) { delete shader; });
+	}
+	return shader;
+}
+
 RenderingSys::RenderingSys(
 	entt::registry* mRegistry,
 	std::unique_ptr<GeometryLoader>& mGeometryLoader,
 	btDiscreteDynamicsWorld* dynamicsWorld,
-	AppSettings* appSettings) :
+	AppSettings* appSettings,
+	ResourceManager* resourceManager) :
 	mRegistry(mRegistry),
 	dynamicsWorld(dynamicsWorld),
 	appSettings(appSettings),
 	mapRenderStates(mGeometryLoader->getRenderStates()),
 	drawIndirectBuffer(mGeometryLoader->getDrawIndirectBuffer()),
-	ssboTransforms(mGeometryLoader->getSSBOTransforms()),
-	iTotalInstances(mGeometryLoader->getTotalInstances()),
+	geometryLoader(mGeometryLoader.get()),
+	geometryArena(mGeometryLoader->getGeometryArena()),
+	transformStaging(mGeometryLoader->getTransformStaging()),
 	geoStateStencilDraw(mGeometryLoader->getGSStencilDraw()),
-	shaderRender(std::string(appSettings->strAssetSrc + "shaders/render.vert").c_str(), std::string(appSettings->strAssetSrc + "shaders/render.frag").c_str()),
-	shaderDebug(std::string(appSettings->strAssetSrc + "shaders/color.vert").c_str(), std::string(appSettings->strAssetSrc + "shaders/color.frag").c_str())
+	resourceManager(resourceManager),
+	shaderRender(acquireShader<RenderShader>("prog:render", appSettings->strAssetSrc + "shaders/render.vert", appSettings->strAssetSrc + "shaders/render.frag",
+		TextureArrays::get() != nullptr ? "#define TEXTURE_ARRAYS\n" : "")),
+	shaderDebug(acquireShader<Shader>("prog:debug", appSettings->strAssetSrc + "shaders/color.vert", appSettings->strAssetSrc + "shaders/color.frag"))
 {
 	matProj = glm::perspective(glm::radians(50.f), static_cast<float>(appSettings->mWidth) / static_cast<float>(appSettings->mHeight), 0.1f, 500.f);
 	geoStateBackgroundQuad = mGeometryLoader->createGSBackgroundQuad("textures/bg.png");
+	mRegistry->view<CBackgroundQuad>().each([this](CBackgroundQuad& cQuad) { std::copy_n(cQuad.texCoords, 8, backgroundTexCoords); });
 
 	//debug draw
 	debugDraw = new DebugDraw();
@@ -90,44 +109,53 @@ RenderingSys::RenderingSys(
 	glClearColor(0.f, 0.f, 0.f, 1.f);
 	mVPWidth = appSettings->mWidth;
 	mVPHeight = appSettings->mHeight;
+	fboOutput = 0;
+	iPickX = iPickY = 0;
+	bPickRequested = false;
 
 	//default shader 
-	glUseProgram(shaderRender.programID);					
+	glUseProgram(shaderRender->programID);					
 }
 
 RenderingSys::~RenderingSys()
 {
-	glDeleteBuffers(1, &vaoScene);
-	glDeleteBuffers(1, &eboScene);
+	//the arena belongs to the cached scene, only this session's quads go back to it
+	geometryArena->free(screenQuad);
+	geometryArena->free(geoStateBackgroundQuad.geometry);
 
 	glDeleteBuffers(1, &uboPerspectiveMatrices);
 	glDeleteBuffers(1, &uboGaussWeights);
 	glDeleteBuffers(1, &uboFBOView);
 	glDeleteBuffers(1, &ssboFBOTransform);
-	glDeleteBuffers(1, &ssboTransforms);
-	glDeleteVertexArrays(1, &geoStateStencilDraw.vao);
-	glDeleteVertexArrays(1, &geoStateBackgroundQuad.vao);
-	glDeleteBuffers(1, &geoStateStencilDraw.ebo);
-	glDeleteBuffers(1, &geoStateStencilDraw.ssboFrag);
-	glDeleteBuffers(1, &geoStateBackgroundQuad.ebo);
 	glDeleteBuffers(1, &geoStateBackgroundQuad.ssboFrag);
-
-	for (auto iter = mapRenderStates.begin(); iter != mapRenderStates.end(); iter++)
+	if (texPickIDs != 0)
 	{
-		glDeleteVertexArrays(1, &iter->second.vao);
-		glDeleteBuffers(1, &iter->second.ebo);
-		glDeleteBuffers(1, &iter->second.ssboFrag);
+		glDeleteTextures(1, &texPickIDs);
+		glDeleteBuffers(1, &pboPick);
+		if (fencePick != nullptr)
+			glDeleteSync(fencePick);
 	}
 
+	//scene buffers and programs are released to the resource manager, GeometryLoader holds the scene's references
+	resourceManager->release("prog:render");
+	resourceManager->release("prog:debug");
+
 	//clear System components
 	mRegistry->clear<SCMatProjection>();
 
 	delete debugDraw;
 }
 
+void RenderingSys::reloadShaders()
+{
+	shaderRender->reload();
+	shaderDebug->reload();
+	glUseProgram(shaderRender->programID);
+}
+
 void RenderingSys::initFBOs()
 {
-	glUseProgram(shaderRender.programID);
+	glUseProgram(shaderRender->programID);
 
 	//HDR FBO
 	// Create and bind the FBO
@@ -145,6 +173,21 @@ void RenderingSys::initFBOs()
 	// Attach the images to the framebuffer
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, bufDepthStencilHDR);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texHDR, 0);
+
+	//instance ids for gpu picking, the attachment is only a draw buffer while objects are drawn
+	texPickIDs = 0;
+	pboPick = 0;
+	fencePick = nullptr;
+	if (appSettings->bGPUPicking)
+	{
+		glCreateTextures(GL_TEXTURE_2D, 1, &texPickIDs);
+		glTextureStorage2D(texPickIDs, 1, GL_R32UI, appSettings->mWidth, appSettings->mHeight);
+		glNamedFramebufferTexture(fboHDR, GL_COLOR_ATTACHMENT1, texPickIDs, 0);
+		glNamedFramebufferReadBuffer(fboHDR, GL_COLOR_ATTACHMENT1);
+		glCreateBuffers(1, &pboPick);
+		glNamedBufferStorage(pboPick, sizeof(GLuint), nullptr, 0);
+	}
+
 	GLenum result = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 	if (result != GL_FRAMEBUFFER_COMPLETE) 
 		spdlog::error("HDR fbo is incomplete : " + std::to_string(result));
@@ -211,34 +254,20 @@ void RenderingSys::initFBOs()
 
 	// scene render quad displayed on the default fbo 
 	//tex coordinates differ where 0, 0 is lower left and 1, 0 is top right, otherwise the image will be rendered as inverted
+	//uniform vertex layout of the arena, the normal is unused
 	float vertices[] =
 	{
-		-1.f, 1.f, 0.f, 0.f, 1.f,
-		1.f, 1.f, 0.f, 1.f, 1.f,
-		1.f, -1.f, 0.f, 1.f, 0.f,
-		-1.f, -1.f, 0.f, 0.f, 0.f
+		-1.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f,
+		1.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 1.f,
+		1.f, -1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f,
+		-1.f, -1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f
 	};
-	unsigned short indices[]
+	unsigned int indices[]
 	{
 		0, 1, 2,
 		0, 2, 3
 	};
-	glCreateVertexArrays(1, &vaoScene);
-	
-	glCreateBuffers(1, &vboScene);
-	glNamedBufferStorage(vboScene, sizeof(float) * 20, vertices, 0);
-	glVertexArrayVertexBuffer(vaoScene, 0, vboScene, 0, sizeof(float) * 5);
-	glVertexArrayAttribFormat(vaoScene, 0, 3, GL_FLOAT, GL_FALSE, 0);
-	glVertexArrayAttribBinding(vaoScene, 0, 0);
-	glEnableVertexArrayAttrib(vaoScene, 0);
-	glVertexArrayAttribFormat(vaoScene, 2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 3);
-	glVertexArrayAttribBinding(vaoScene, 2, 0);
-	glEnableVertexArrayAttrib(vaoScene, 2);
-	glDeleteBuffers(1, &vboScene);
-
-	glCreateBuffers(1, &eboScene);
-	glNamedBufferStorage(eboScene, sizeof(unsigned short) * 6, indices, 0);
-	glVertexArrayElementBuffer(vaoScene, eboScene);
+	screenQuad = geometryArena->allocate(vertices, 4, indices, 6);
 }
 
 float RenderingSys::gauss(float x, float sigma2)
@@ -248,61 +277,94 @@ float RenderingSys::gauss(float x, float sigma2)
 	return (float)(coeff * exp(expon));
 }
 
-void RenderingSys::update(const float& fDeltaTime)
+void RenderingSys::update(const float& fDeltaTime, const RenderSnapshot& snapshot)
 {
 	//update buffer data
-	updateSSBOPersMatrices();
-	updateSSBOTransforms();
+	{
+		TRACE_SCOPE("RenderingSys::uploadTransforms");
+		updateSSBOPersMatrices(snapshot.matView);
+		updateSSBOTransforms();
+		updateBackgroundTex(snapshot);
+	}
 
-	renderScene(fDeltaTime);
+	{
+		TRACE_SCOPE("RenderingSys::renderScene");
+		renderScene(fDeltaTime, snapshot.drawMode);
+	}
+	if (bPickRequested)
+		readPickID();
 //	computeMaxWhiteLum();		
+	TRACE_SCOPE("RenderingSys::postProcess");
 	blurPass();
 
-	glUniform1i(shaderRender.uniLocPass, 2);
+	glUniform1i(shaderRender->uniLocPass, 2);
 
 	//pass 5 default, just display the composite quad
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, fboOutput);
 	glClear(GL_COLOR_BUFFER_BIT);
 	glViewport(0, 0, mVPWidth, mVPHeight);
 
 	glBindSampler(1, samplerLinear);							//texBlur1 sampler linear for extra blur effect
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+	drawGeometry(screenQuad);
 	glBindSampler(1, samplerNearest);							//reset to nearest
 }
 
-void RenderingSys::updateSSBOPersMatrices()
+void RenderingSys::updateSSBOPersMatrices(const glm::mat4& matView)
 {
 	glm::mat4* ptrBuffer = (glm::mat4*)glMapNamedBufferRange(uboPerspectiveMatrices, 0, sizeof(glm::mat4), GL_MAP_WRITE_BIT);
-	ptrBuffer[0] = mRegistry->get<SCView>(eMatView).matView;
+	ptrBuffer[0] = matView;
 	glUnmapNamedBuffer(uboPerspectiveMatrices);
 }
 
 void RenderingSys::updateSSBOTransforms()
 {
-	glm::mat4* ptrBuffer = (glm::mat4*)glMapNamedBufferRange(ssboTransforms, 0, sizeof(glm::mat4) * iTotalInstances, GL_MAP_WRITE_BIT);
-	auto view = mRegistry->view<CGeometryInstance, CTransform>();
-	for (auto [e, geometryInst, transform] : view.each()) {
-		if (transform.bUpdate)
-		{
-			ptrBuffer[geometryInst.baseInstance + geometryInst.instanceID] = transform.matModel;
-			transform.bUpdate = false;
-		}
-	}
-	glUnmapNamedBuffer(ssboTransforms);
+	//draws of types whose instance block changed, then the slots moving bodies wrote into the staging ring during physics
+	geometryLoader->syncDrawCommands();
+	transformStaging->flush(geometryLoader->getSSBOTransforms());
+}
+
+void RenderingSys::updateBackgroundTex(const RenderSnapshot& snapshot)
+{
+	//the camera scrolls the foreground quad only while rotating
+	if (!snapshot.bBackgroundQuad || std::equal(backgroundTexCoords, backgroundTexCoords + 8, snapshot.backgroundTexCoords))
+		return;
+
+	std::copy_n(snapshot.backgroundTexCoords, 8, backgroundTexCoords);
+	geometryLoader->writeBackgroundTexCoords(backgroundTexCoords);
+}
+
+void RenderingSys::drawGeometry(GeometryHandle geometry)
+{
+	//ranges move when the arena defragments, so they are looked up per draw
+	if (geometry == ciInvalidGeometry)
+		return;
+
+	const GeometryRange& range = geometryArena->getRange(geometry);
+	glDrawElementsBaseVertex(GL_TRIANGLES, range.iIndices, GL_UNSIGNED_INT, (void*)(sizeof(unsigned int) * range.firstIndex), range.baseVertex);
 }
 
-void RenderingSys::renderScene(const float& fDeltaTime)
+void RenderingSys::renderScene(const float& fDeltaTime, const DrawMode drawMode)
 {
 	//pass 1
-	glUseProgram(shaderRender.programID);
-	glUniform1i(shaderRender.uniLocPass, 1);
+	glUseProgram(shaderRender->programID);
+	glUniform1i(shaderRender->uniLocPass, 1);
 	glBindFramebuffer(GL_FRAMEBUFFER, fboHDR);
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_STENCIL_TEST);
 	glStencilMask(0xff);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	if (texPickIDs != 0)
+	{
+		//glClear is undefined for integer attachments
+		const GLuint iNoPick = 0;
+		setPickOutput(true);
+		glClearBufferuiv(GL_COLOR, 2, &iNoPick);
+		setPickOutput(false);
+	}
+
+	//room, objects, foreground and the post process quad all come from the one arena
+	glBindVertexArray(geometryArena->getVAO());
 
-	const DrawMode drawMode = mRegistry->get<SCDrawMode>(eDrawMode).drawMode;
 	if (drawMode != DrawMode::DEBUG)
 	{
 		//room
@@ -311,33 +373,33 @@ void RenderingSys::renderScene(const float& fDeltaTime)
 		glStencilFunc(GL_ALWAYS, 1, 0xff);
 		glBindBufferBase(GL_UNIFORM_BUFFER, 0, uboPerspectiveMatrices);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboFBOTransform);
-		glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender.subBasicEmissive);
-		glBindVertexArray(geoStateStencilDraw.vao);
-		glDrawElements(GL_TRIANGLES, geoStateStencilDraw.count, GL_UNSIGNED_INT, 0);
+		glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender->subBasicEmissive);
+		drawGeometry(geoStateStencilDraw.geometry);
 
 
-		//objects
+		//objects, the only draws that write pick ids
 		glDisable(GL_STENCIL_TEST);
 		glCullFace(GL_BACK);
-		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboTransforms);
+		setPickOutput(true);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, geometryLoader->getSSBOTransforms());
 		for (auto iter = mapRenderStates.begin(); iter != mapRenderStates.end(); iter++)
 		{
 			if (iter->first == RSType::BASIC_KD)	
-				glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender.subBasic);			
+				glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender->subBasic);			
 			else if (iter->first == RSType::EMISSIVE)
 			{
-				glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender.subEmissive);
+				glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender->subEmissive);
 				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, iter->second.ssboFrag);
 			}
 			else
 			{
-				glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender.subTextured);
+				glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender->subTextured);
 				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, iter->second.ssboFrag);
 			}
 
-			glBindVertexArray(iter->second.vao);
 			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, iter->second.drawCmdOffset, iter->second.primCount, 0);
 		};
+		setPickOutput(false);
 
 		
 		//foreground quad
@@ -345,29 +407,78 @@ void RenderingSys::renderScene(const float& fDeltaTime)
 		glDisable(GL_CULL_FACE);
 		glStencilFunc(GL_NOTEQUAL, 1, 0xff);
 		glStencilMask(0x00);
-		glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender.subEmissive);
+		glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender->subEmissive);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboFBOTransform);
 		glBindBufferBase(GL_UNIFORM_BUFFER, 0, uboFBOView);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, geoStateBackgroundQuad.ssboFrag);
-		glBindVertexArray(geoStateBackgroundQuad.vao);
-		glDrawElements(GL_TRIANGLES, geoStateBackgroundQuad.count, GL_UNSIGNED_INT, 0);
+		drawGeometry(geoStateBackgroundQuad.geometry);
 		glDisable(GL_STENCIL_TEST);
 	}
 
 	//debug draw
 	if (drawMode != DrawMode::NORMAL)
 	{
-		glUseProgram(shaderDebug.programID);
+		glUseProgram(shaderDebug->programID);
 		glBindBufferBase(GL_UNIFORM_BUFFER, 0, uboPerspectiveMatrices);
 		dynamicsWorld->debugDrawWorld();
 
-		//back to default
-		glUseProgram(shaderRender.programID);
+		//back to default, debug draw binds a vao of its own
+		glUseProgram(shaderRender->programID);
 		glBindBufferBase(GL_UNIFORM_BUFFER, 0, uboFBOView);
+		glBindVertexArray(geometryArena->getVAO());
 	}
 }
 
 
+void RenderingSys::setPickOutput(bool bEnabled)
+{
+	if (texPickIDs == 0)
+		return;
+	GLenum drawBuffers[] = { GL_NONE, GL_COLOR_ATTACHMENT0, bEnabled ? GL_COLOR_ATTACHMENT1 : GL_NONE };
+	glNamedFramebufferDrawBuffers(fboHDR, 3, drawBuffers);
+}
+
+void RenderingSys::requestPick(int iMouseX, int iMouseY)
+{
+	//a newer click replaces one still in flight, its result would belong to the old click
+	if (fencePick != nullptr)
+	{
+		glDeleteSync(fencePick);
+		fencePick = nullptr;
+	}
+	iPickX = std::clamp(iMouseX, 0, mVPWidth - 1);
+	iPickY = std::clamp(mVPHeight - 1 - iMouseY, 0, mVPHeight - 1);						//gl rows start at the bottom
+	bPickRequested = texPickIDs != 0;
+}
+
+void RenderingSys::readPickID()
+{
+	//one texel into the pbo, nothing waits for it here
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fboHDR);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pboPick);
+	glReadPixels(iPickX, iPickY, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	fencePick = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	bPickRequested = false;
+}
+
+bool RenderingSys::pollPick(GLuint& iPickID, bool bWait)
+{
+	if (fencePick == nullptr)
+		return false;
+
+	const GLenum status = glClientWaitSync(fencePick, bWait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, bWait ? 1000000000ull : 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+		return false;
+	if (status == GL_WAIT_FAILED)
+		spdlog::error("Waiting on the pick readback failed");
+
+	glGetNamedBufferSubData(pboPick, 0, sizeof(GLuint), &iPickID);
+	glDeleteSync(fencePick);
+	fencePick = nullptr;
+	return true;
+}
+
 void RenderingSys::blurPass()
 {
 	//pass 2 , bright pass read texHDR and write to texBlur1
@@ -384,19 +495,18 @@ void RenderingSys::blurPass()
 	glBindTexture(GL_TEXTURE_2D, texBlurPass1);
 	glActiveTexture(GL_TEXTURE2);
 	glBindTexture(GL_TEXTURE_2D, texBlurPass2);
-	glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender.subBrightPass);
-	glBindVertexArray(vaoScene);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+	glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender->subBrightPass);
+	drawGeometry(screenQuad);
 
 	//pass 3, read texBlur1 and write to texBlur2
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texBlurPass2, 0);
-	glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender.subBlurVert);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+	glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender->subBlurVert);
+	drawGeometry(screenQuad);
 
 	//pass 4, read texBlur2 and write to texBlur1
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texBlurPass1, 0);
-	glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender.subBlurHor);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+	glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &shaderRender->subBlurHor);
+	drawGeometry(screenQuad);
 }
 
 
@@ -414,5 +524,5 @@ void RenderingSys::blurPass()
 //		//max_luminance
 //		maxWhiteLum = std::max(maxWhiteLum, lum);
 //	}
-//	glUniform1f(shaderRender.uniLocMaxWhiteLum, maxWhiteLum);
+//	glUniform1f(shaderRender->uniLocMaxWhiteLum, maxWhiteLum);
 //}
\ No newline at end of file
@@ -8,7 +8,9 @@
 #include "Components.h"
 #include "RenderState.h"
 #include "GeometryLoader.h"
+#include "RenderSnapshot.h"
 #include "../AppSettings.h"
+#include "../ResourceManager.h"
 
 #include <entt/entity/registry.hpp>
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
@@ -24,33 +26,62 @@ public:
 		entt::registry* mRegistry,
 		std::unique_ptr<GeometryLoader>& mGeometryLoader,
 		btDiscreteDynamicsWorld* dynamicsWorld,
-		AppSettings* appSettings);
+		AppSettings* appSettings,
+		ResourceManager* resourceManager);
 	~RenderingSys();
 
-	void update(const float& fDeltaTime);
+	//gl thread only, draws what the simulation captured in snapshot, never reads the registry
+	void update(const float& fDeltaTime, const RenderSnapshot& snapshot);
+
+	//hot reload, recompiles the programs in place so cached pointers stay valid
+	void reloadShaders();
+
+	//the composite goes here instead of the default framebuffer, e.g. an offscreen target without any window
+	void setOutputFramebuffer(GLuint fbo) { fboOutput = fbo; }
+
+	//gpu picking, the geometry pass writes transform slot + 1 of every object into an R32UI attachment
+	//a requested texel is copied into a pbo after the next geometry pass and read back once its fence signaled
+	bool hasPicking() const { return texPickIDs != 0; }
+	void requestPick(int iMouseX, int iMouseY);
+	//true once the last requested texel arrived, iPickID 0 when no object was under the cursor
+	//bWait blocks until then, so the result always arrives the frame after the request
+	bool pollPick(GLuint& iPickID, bool bWait);
 
 private:
 	void initFBOs();
-	void updateSSBOPersMatrices();
+	void updateSSBOPersMatrices(const glm::mat4& matView);
 	void updateSSBOTransforms();
-	void renderScene(const float& fDeltaTime);
+	void updateBackgroundTex(const RenderSnapshot& snapshot);
+	void renderScene(const float& fDeltaTime, const DrawMode drawMode);
+	void drawGeometry(GeometryHandle geometry);
 	void blurPass();
+	void setPickOutput(bool bEnabled);
+	void readPickID();
 	float gauss(float x, float sigma2);
+	template<typename T> T* acquireShader(const std::string& strKey, const std::string& strVS, const std::string& strFS, const std::string& strDefines = "");
 
 	std::map<RSType, RenderState> mapRenderStates;
 	GLuint uboGaussWeights;	
-	GLuint ssboTransforms;
+	GeometryLoader* geometryLoader;											//owns the transform ssbo, spawning may replace it
+	GeometryArena* geometryArena;											//every mesh and quad drawn here, bound once per frame
+	TransformStaging* transformStaging;
 	GLuint uboPerspectiveMatrices, uboFBOView;								
 	GLuint drawIndirectBuffer;
 	GLuint ssboFBOTransform;												//single mat4 for 2D rendering of texture
-	unsigned int iTotalInstances;
 	
 	GeometryState geoStateBackgroundQuad;
+	float backgroundTexCoords[8];											//last uploaded into the foreground quad
 	GeometryState geoStateStencilDraw;
 
 	//FBOs
 	GLuint fboHDR, texHDR, bufDepthStencilHDR;
 	GLuint fboBlurPass, texBlurPass1, texBlurPass2;
+	GLuint fboOutput;														//0 = default framebuffer
+	GLuint texPickIDs;														//0 without gpu picking
+	GLuint pboPick;
+	GLsync fencePick;														//pick texel copy in flight
+	int iPickX, iPickY;
+	bool bPickRequested;
 	float fBlurBufWidth, fBlurBufHeight;
 	GLuint samplerLinear, samplerNearest;
 	std::vector<GLfloat> vFboTextureData;
@@ -58,12 +89,13 @@ private:
 	int mVPWidth, mVPHeight;						//default viewport size						
 
 	//quad 
-	GLuint vaoScene, vboScene, eboScene;
+	GeometryHandle screenQuad;
 
 	AppSettings* appSettings;
 	DebugDraw* debugDraw;
-	RenderShader shaderRender;
-	Shader shaderDebug;
+	ResourceManager* resourceManager;
+	RenderShader* shaderRender;												//programs stay linked across sessions, owned by resourceManager
+	Shader* shaderDebug;
 
 	glm::mat4 matProj;
 
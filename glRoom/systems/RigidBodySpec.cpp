@@ -0,0 +1,327 @@
+#include "RigidBodySpec.h"
+#include "../MappedFile.h"
+
+#ifndef TINYOBJLOADER_IMPLEMENTATION
+#define TINYOBJLOADER_IMPLEMENTATION
+#endif
+#include <tiny_obj_loader.h>
+#include <spdlog/spdlog.h>
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btConvexHullShape.h>
+#include <BulletCollision/CollisionShapes/btCylinderShape.h>
+#include <BulletCollision/CollisionShapes/btSphereShape.h>
+#include <LinearMath/btAlignedAllocator.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+const RigidBodySpec* findRigidBodySpec(const std::string& strEntityType)
+{
+	static const std::map<std::string, RigidBodySpec> mapSpecs =
+	{
+		//type				shape						half extents							mass	friction	yaw		shape file
+		{ "book",		{ ShapeType::BOX,			btVector3(.715f, .1575f, 0.55f),		.5f,	20.f,		true,	"" } },
+		{ "desk",		{ ShapeType::BOX,			btVector3(2.f, 2.47f, 4.71f),			0.f,	20.f,		false,	"" } },
+		{ "shelf",		{ ShapeType::TRIANGLE_MESH,	btVector3(0.f, 0.f, 0.f),				0.f,	.5f,		false,	"./models/lowPoly/shelf.obj" } },
+		{ "keyboard",	{ ShapeType::BOX,			btVector3(0.525f, .0565f, 1.72f),		.3f,	20.f,		true,	"" } },
+		{ "plant",		{ ShapeType::CYLINDER,		btVector3(0.505f, 0.85f, .505f),		1.5f,	20.f,		false,	"" } },
+		{ "bookShelf",	{ ShapeType::BOX,			btVector3(.755f, .0605f, 3.015f),		0.f,	20.f,		true,	"" } },
+		{ "moonLamp",	{ ShapeType::SPHERE,		btVector3(0.505f, 0.f, 0.f),			.2f,	100.f,		true,	"" } },
+		{ "mug",		{ ShapeType::CYLINDER,		btVector3(0.4f, 0.40f, .45f),			0.2f,	20.f,		false,	"" } },
+		{ "chair",		{ ShapeType::CONVEX_HULL,	btVector3(0.f, 0.f, 0.f),				30.f,	20.f,		true,	"models/chair.obj" } },
+		{ "monitor",	{ ShapeType::BOX,			btVector3(1.11f, 1.11f, 1.11f),			8.f,	20.f,		true,	"" } }
+	};
+
+	auto iter = mapSpecs.find(strEntityType);
+	return iter == mapSpecs.end() ? nullptr : &iter->second;
+}
+
+btTransform createSpawnTransform(const RigidBodySpec& spec, const btVector3& vOrigin, float fYaw)
+{
+	btTransform transBody;
+	transBody.setIdentity();
+	transBody.setOrigin(vOrigin);
+	if (spec.bYaw)
+	{
+		btQuaternion rotation;
+		rotation.setEuler(fYaw, 0.f, 0.f);
+		transBody.setRotation(rotation);
+	}
+	return transBody;
+}
+
+void freeTriangleMeshData(TriangleMeshData& meshData)
+{
+	delete meshData.meshInterface;
+	delete[] meshData.vertices;
+	delete[] meshData.indices;
+	delete meshData.mappedFile;
+	meshData = TriangleMeshData();
+}
+
+//bvh cache next to the obj : header, vertices, indices, then the serialized quantized bvh, every section 16 byte aligned
+//only valid for the obj it was built from and a bullet build with the same btScalar
+static const char szBvhMagic[4] = { 'g', 'B', 'V', 'H' };
+static constexpr uint32_t ciBvhVersion = 1;
+static constexpr uint32_t ciEndianMark = 0x01020304;
+
+struct BvhCacheHeader
+{
+	char magic[4];
+	uint32_t iVersion;
+	uint32_t iEndianMark;
+	uint32_t iScalarBytes;
+	int64_t iSourceSize;
+	int64_t iSourceTime;
+	uint32_t iNumVertices;
+	uint32_t iNumTriangles;
+	btScalar aabbMin[3];														//local aabb, so the shape doesnt walk every triangle to find it
+	btScalar aabbMax[3];
+	uint64_t iVertexOffset;
+	uint64_t iIndexOffset;
+	uint64_t iBvhOffset;
+	uint64_t iBvhBytes;
+};
+
+static uint64_t alignCacheOffset(uint64_t iOffset)
+{
+	return (iOffset + 15) & ~static_cast<uint64_t>(15);
+}
+
+static std::string bvhCachePath(const std::string& strSrcFile)
+{
+	return strSrcFile + ".bvh";
+}
+
+static bool getSourceStamp(const std::string& strSrcFile, int64_t& iSize, int64_t& iTime)
+{
+	std::error_code ec;
+	iSize = static_cast<int64_t>(std::filesystem::file_size(strSrcFile, ec));
+	if (ec)
+		return false;
+	iTime = static_cast<int64_t>(std::filesystem::last_write_time(strSrcFile, ec).time_since_epoch().count());
+	return !ec;
+}
+
+//nullptr if there is no cache or it is stale, the caller builds the shape from the obj then
+static btCollisionShape* mapTriangleMeshShape(const std::string& strSrcFile, TriangleMeshData& meshData)
+{
+	int64_t iSourceSize, iSourceTime;
+	if (!getSourceStamp(strSrcFile, iSourceSize, iSourceTime))
+		return nullptr;
+	std::unique_ptr<MappedFile> mappedFile = MappedFile::open(bvhCachePath(strSrcFile));
+	if (!mappedFile || mappedFile->getSize() < sizeof(BvhCacheHeader))
+		return nullptr;
+
+	BvhCacheHeader header;
+	memcpy(&header, mappedFile->getData(), sizeof(header));
+	const uint64_t iIndexBytes = static_cast<uint64_t>(header.iNumTriangles) * 3 * sizeof(short);
+	const bool bValid = memcmp(header.magic, szBvhMagic, 4) == 0 && header.iVersion == ciBvhVersion &&
+		header.iEndianMark == ciEndianMark && header.iScalarBytes == sizeof(btScalar) &&
+		header.iSourceSize == iSourceSize && header.iSourceTime == iSourceTime &&
+		header.iVertexOffset == alignCacheOffset(sizeof(BvhCacheHeader)) &&
+		header.iIndexOffset == alignCacheOffset(header.iVertexOffset + static_cast<uint64_t>(header.iNumVertices) * 3 * sizeof(btScalar)) &&
+		header.iBvhOffset == alignCacheOffset(header.iIndexOffset + iIndexBytes) &&
+		header.iBvhOffset + header.iBvhBytes <= mappedFile->getSize();
+	if (!bValid)
+	{
+		spdlog::info(bvhCachePath(strSrcFile) + " is stale, rebuilding it");
+		return nullptr;
+	}
+
+	//rebuilds the bvh object in the first page of its section, copy on write keeps the file as it is
+	unsigned char* data = mappedFile->getData();
+	btOptimizedBvh* bvh = static_cast<btOptimizedBvh*>(btOptimizedBvh::deSerializeInPlace(data + header.iBvhOffset, static_cast<unsigned int>(header.iBvhBytes), false));
+	if (bvh == nullptr)
+		return nullptr;
+
+	btTriangleIndexVertexArray* meshInterface = new btTriangleIndexVertexArray();
+	btIndexedMesh part;
+	part.m_vertexBase = data + header.iVertexOffset;
+	part.m_numVertices = header.iNumVertices;
+	part.m_vertexStride = sizeof(btScalar) * 3;
+	part.m_triangleIndexBase = data + header.iIndexOffset;
+	part.m_triangleIndexStride = sizeof(short) * 3;
+	part.m_numTriangles = header.iNumTriangles;
+	part.m_indexType = PHY_SHORT;
+	meshInterface->addIndexedMesh(part, PHY_SHORT);
+	meshInterface->setPremadeAabb(btVector3(header.aabbMin[0], header.aabbMin[1], header.aabbMin[2]), btVector3(header.aabbMax[0], header.aabbMax[1], header.aabbMax[2]));
+
+	btBvhTriangleMeshShape* shape = new btBvhTriangleMeshShape(meshInterface, true, false);
+	shape->setOptimizedBvh(bvh);
+
+	meshData.meshInterface = meshInterface;
+	meshData.mappedFile = mappedFile.release();
+	return shape;
+}
+
+//a read only asset folder just means every load builds the bvh again
+static void writeTriangleMeshCache(const std::string& strSrcFile, const TriangleMeshData& meshData, btBvhTriangleMeshShape* shape)
+{
+	BvhCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	if (!getSourceStamp(strSrcFile, header.iSourceSize, header.iSourceTime))
+		return;
+
+	const btIndexedMesh& mesh = meshData.meshInterface->getIndexedMeshArray()[0];
+	btOptimizedBvh* bvh = shape->getOptimizedBvh();
+	memcpy(header.magic, szBvhMagic, 4);
+	header.iVersion = ciBvhVersion;
+	header.iEndianMark = ciEndianMark;
+	header.iScalarBytes = sizeof(btScalar);
+	header.iNumVertices = mesh.m_numVertices;
+	header.iNumTriangles = mesh.m_numTriangles;
+	for (int i = 0; i < 3; i++)
+	{
+		header.aabbMin[i] = shape->getLocalAabbMin()[i];
+		header.aabbMax[i] = shape->getLocalAabbMax()[i];
+	}
+	const uint64_t iVertexBytes = static_cast<uint64_t>(mesh.m_numVertices) * 3 * sizeof(btScalar);
+	const uint64_t iIndexBytes = static_cast<uint64_t>(mesh.m_numTriangles) * 3 * sizeof(short);
+	header.iVertexOffset = alignCacheOffset(sizeof(BvhCacheHeader));
+	header.iIndexOffset = alignCacheOffset(header.iVertexOffset + iVertexBytes);
+	header.iBvhOffset = alignCacheOffset(header.iIndexOffset + iIndexBytes);
+	header.iBvhBytes = bvh->calculateSerializeBufferSize();
+	const size_t iFileBytes = static_cast<size_t>(header.iBvhOffset + header.iBvhBytes);
+
+	//serializeInPlace wants a 16 byte aligned buffer, every section offset is aligned too
+	unsigned char* buffer = static_cast<unsigned char*>(btAlignedAlloc(iFileBytes, 16));
+	memset(buffer, 0, iFileBytes);
+	memcpy(buffer, &header, sizeof(header));
+	memcpy(buffer + header.iVertexOffset, mesh.m_vertexBase, static_cast<size_t>(iVertexBytes));
+	memcpy(buffer + header.iIndexOffset, mesh.m_triangleIndexBase, static_cast<size_t>(iIndexBytes));
+	bool bWritten = bvh->serializeInPlace(buffer + header.iBvhOffset, static_cast<unsigned int>(header.iBvhBytes), false);
+
+	//written under a temporary name so a concurrent or interrupted load never maps half a file
+	const std::string strCachePath = bvhCachePath(strSrcFile);
+	const std::string strTempPath = strCachePath + ".tmp";
+	FILE* file = bWritten ? fopen(strTempPath.c_str(), "wb") : nullptr;
+	if (file != nullptr)
+	{
+		bWritten = fwrite(buffer, 1, iFileBytes, file) == iFileBytes;
+		bWritten = fclose(file) == 0 && bWritten;
+		std::error_code ec;
+		if (bWritten)
+			std::filesystem::rename(strTempPath, strCachePath, ec);
+		if (!bWritten || ec)
+		{
+			std::filesystem::remove(strTempPath, ec);
+			bWritten = false;
+		}
+	}
+	else
+		bWritten = false;
+	btAlignedFree(buffer);
+
+	if (bWritten)
+		spdlog::info("Cached collision bvh of " + strSrcFile);
+	else
+		spdlog::warn("Failed to write " + strCachePath + ", the bvh is built on every load");
+}
+
+CollisionShapeBuilder::CollisionShapeBuilder(std::string strAssetSrc) :
+	strAssetSrc(strAssetSrc)
+{
+}
+
+btCollisionShape* CollisionShapeBuilder::createShape(const RigidBodySpec& spec, TriangleMeshData& meshData)
+{
+	switch (spec.shapeType)
+	{
+	case ShapeType::BOX:
+		return new btBoxShape(spec.vHalfExtents);
+	case ShapeType::CYLINDER:
+		return new btCylinderShape(spec.vHalfExtents);
+	case ShapeType::SPHERE:
+		return new btSphereShape(spec.vHalfExtents.x());
+	case ShapeType::CONVEX_HULL:
+		return createConvexHullShape(spec.strShapeFile);
+	case ShapeType::TRIANGLE_MESH:
+		return createTriangleMeshShape(strAssetSrc + spec.strShapeFile, meshData);
+	}
+	return nullptr;
+}
+
+btCollisionShape* CollisionShapeBuilder::createTriangleMeshShape(const std::string& strSrcFile, TriangleMeshData& meshData)
+{
+	//vertices, indices and bvh nodes are used straight from the mapped cache, nothing is parsed or built
+	if (btCollisionShape* shape = mapTriangleMeshShape(strSrcFile, meshData))
+		return shape;
+
+	//reads low poly version of the original rendered mesh for obvious performance reasons
+	tinyobj::ObjReader reader;
+	if (!reader.ParseFromFile(strSrcFile))
+	{
+		if (!reader.Error().empty())
+			spdlog::error("Reader : " + reader.Error());
+	}
+	if (!reader.Warning().empty())
+		spdlog::warn("Warn : " + reader.Warning());
+
+	auto attribVertices = reader.GetAttrib().vertices;
+	auto shape = reader.GetShapes()[0];
+
+	//allocation of vertex and index data is neccessary so it isnt lost when out of the scope of this function 
+	btScalar* vertices = new btScalar[attribVertices.size()];
+	std::copy(attribVertices.begin(), attribVertices.end(), vertices);
+
+	short* indices = new short[shape.mesh.indices.size()];
+	unsigned short index = 0;
+	for (auto& i : shape.mesh.indices)
+		indices[index++] = i.vertex_index;
+
+	btTriangleIndexVertexArray* meshInterface = new btTriangleIndexVertexArray();
+	btIndexedMesh part;
+	part.m_vertexBase = (const unsigned char*)vertices;
+	part.m_numVertices = attribVertices.size() / 3;
+	part.m_vertexStride = sizeof(btScalar) * 3;
+	part.m_triangleIndexBase = (const unsigned char*)indices;
+	part.m_triangleIndexStride = sizeof(short) * 3;
+	part.m_numTriangles = shape.mesh.indices.size() / 3;
+	part.m_indexType = PHY_SHORT;
+	meshInterface->addIndexedMesh(part, PHY_SHORT);
+
+	meshData.meshInterface = meshInterface;
+	meshData.vertices = vertices;
+	meshData.indices = indices;
+
+	btBvhTriangleMeshShape* shape = new btBvhTriangleMeshShape(meshInterface, true);
+	writeTriangleMeshCache(strSrcFile, meshData, shape);
+	return shape;
+}
+
+btCollisionShape* CollisionShapeBuilder::createConvexHullShape(const std::string& strFilename)
+{
+	auto collisionShape = new btConvexHullShape();
+	collisionShape->setLocalScaling(btVector3(1.f, 1.f, 1.f));
+
+	//check if vertex data for this mesh exists in map, if not then load it
+	if (mapMeshConvexHulls.find(strFilename) == mapMeshConvexHulls.end())
+	{
+		tinyobj::ObjReader reader;
+		if (!reader.ParseFromFile(strAssetSrc + strFilename))
+		{
+			if (!reader.Error().empty())
+				spdlog::error("Reader : " + reader.Error());
+		}
+		if (!reader.Warning().empty())
+			spdlog::warn("Warn : " + reader.Warning());
+
+		//add to map using filename as key so the model doesnt have to be parsed again
+		const tinyobj::attrib_t& attrib = reader.GetAttrib();
+		std::vector<btVector3>& vcHull = mapMeshConvexHulls[strFilename];
+		for (size_t i = 0; i + 2 < attrib.vertices.size(); i += 3)
+			vcHull.emplace_back(btVector3(attrib.vertices[i], attrib.vertices[i + 1], attrib.vertices[i + 2]));
+	}
+
+	for (auto& vertex : mapMeshConvexHulls[strFilename])
+		collisionShape->addPoint(vertex);
+
+	//polyhedral precision
+	collisionShape->initializePolyhedralFeatures();
+
+	return collisionShape;
+}
@@ -0,0 +1,74 @@
+//gl free rigid body description of every entity type
+//GeometryLoader and the headless benchmarks build their bodies from the same table so they stay comparable
+#pragma once
+#include <BulletCollision/CollisionShapes/btCollisionShape.h>
+#include <BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h>
+#include <LinearMath/btTransform.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+enum class ShapeType
+{
+	BOX,
+	CYLINDER,
+	SPHERE,																		//vHalfExtents.x is the radius
+	CONVEX_HULL,																//built from the vertices of strShapeFile
+	TRIANGLE_MESH																//static only, built from strShapeFile
+};
+
+struct RigidBodySpec
+{
+	ShapeType shapeType;
+	btVector3 vHalfExtents;
+	btScalar fMass;																//0 makes it static
+	btScalar fFriction;
+	bool bYaw;																	//some types ignore the yaw given in the level file
+	std::string strShapeFile;													//relative to asset src
+};
+
+//nullptr for unknown types, walls have no entry since their size comes from the level file
+const RigidBodySpec* findRigidBodySpec(const std::string& strEntityType);
+
+btTransform createSpawnTransform(const RigidBodySpec& spec, const btVector3& vOrigin, float fYaw);
+
+//triangle mesh shapes reference vertex / index data that has to outlive the shape
+//either parsed from the obj into vertices / indices, or straight out of the mapped bvh cache
+struct TriangleMeshData
+{
+	btTriangleIndexVertexArray* meshInterface;
+	btScalar* vertices;
+	short* indices;
+	MappedFile* mappedFile;														//also holds the shape's bvh
+	TriangleMeshData() : meshInterface(nullptr), vertices(nullptr), indices(nullptr), mappedFile(nullptr) {}
+};
+
+//once the shape using it is deleted
+void freeTriangleMeshData(TriangleMeshData& meshData);
+
+//shape built ahead of time, e.g. on a loading thread, ownership moves to whoever creates the body
+struct BuiltShape
+{
+	btCollisionShape* collisionShape;
+	TriangleMeshData meshData;
+	BuiltShape() : collisionShape(nullptr) {}
+};
+
+class CollisionShapeBuilder
+{
+public:
+	CollisionShapeBuilder(std::string strAssetSrc);
+
+	//meshData is only filled for TRIANGLE_MESH
+	//triangle meshes are cached with their bvh next to the obj the first time, later loads map the cache instead of parsing and building
+	btCollisionShape* createShape(const RigidBodySpec& spec, TriangleMeshData& meshData);
+
+private:
+	btCollisionShape* createTriangleMeshShape(const std::string& strSrcFile, TriangleMeshData& meshData);
+	btCollisionShape* createConvexHullShape(const std::string& strFilename);
+
+	std::string strAssetSrc;
+	std::map<std::string, std::vector<btVector3>> mapMeshConvexHulls;			//keep convex hulls in a map so mesh files dont have to be read over and over again 
+};
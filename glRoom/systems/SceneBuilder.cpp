@@ -0,0 +1,333 @@
+#include "SceneBuilder.h"
+#include "RigidBodySpec.h"
+
+#ifndef STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#endif
+#include <stb_image.h>
+#include <tiny_obj_loader.h>
+#include <spdlog/spdlog.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <unordered_map>
+
+SceneBuilder::SceneBuilder(std::string strAssetSrc) :
+	strAssetSrc(strAssetSrc),
+	fProgress(0.f)
+{
+}
+
+std::shared_ptr<const SceneDesc> SceneBuilder::build(const std::string& strLevelFile)
+{
+	std::vector<LevelEntity> vcLevel;
+	loadLevelFile(strAssetSrc + strLevelFile, vcLevel);
+	return build(vcLevel);
+}
+
+std::shared_ptr<const SceneDesc> SceneBuilder::build(const std::vector<LevelEntity>& vcLevel)
+{
+	vcTypeTransforms.clear();
+	strStencilModel.clear();
+	fProgress.store(0.f, std::memory_order_relaxed);
+
+	auto sceneDesc = std::make_shared<SceneDesc>();
+	for (const auto& levelEntity : vcLevel)
+		addEntity(*sceneDesc, levelEntity);
+
+	buildInstances(*sceneDesc);
+	buildGeometry(*sceneDesc);
+	if (!strStencilModel.empty())
+		buildStencilMesh(*sceneDesc, strStencilModel);
+
+	fProgress.store(1.f, std::memory_order_relaxed);
+	return sceneDesc;
+}
+
+void SceneBuilder::addEntity(SceneDesc& sceneDesc, const LevelEntity& levelEntity)
+{
+	//render only, drawn directly with stencil testing
+	if (levelEntity.strEntityType == "room")
+	{
+		strStencilModel = "models/room.obj";
+		return;
+	}
+
+	const RigidBodySpec* spec = findRigidBodySpec(levelEntity.strEntityType);
+	if (spec == nullptr && levelEntity.strEntityType != "wall")
+	{
+		spdlog::warn("Unknown entity type in level : " + levelEntity.strEntityType);
+		return;
+	}
+
+	EntityDesc entityDesc;
+	entityDesc.typeID = sceneDesc.entityTypes.intern(levelEntity.strEntityType);
+	entityDesc.vOrigin = levelEntity.vOrigin;
+	entityDesc.fYaw = levelEntity.fYaw;
+	entityDesc.vDimensions = levelEntity.vDimensions;
+
+	EntityTypeDesc& typeDesc = sceneDesc.entityTypes[entityDesc.typeID];
+	if (spec == nullptr)
+	{
+		entityDesc.bRenderable = false;
+		sceneDesc.vcEntities.emplace_back(entityDesc);
+		return;
+	}
+
+	//first instance of the type
+	if (typeDesc.spec == nullptr)
+	{
+		typeDesc.spec = spec;
+		typeDesc.strModelPath = "models/" + levelEntity.strEntityType + ".obj";
+
+		//every monitor gets its own draw so its screen can show a different letter
+		if (levelEntity.strEntityType == "monitor")
+		{
+			typeDesc.strModelPath = "models/crt.obj";
+			typeDesc.bDrawPerInstance = true;
+		}
+	}
+
+	btScalar mat4[16];
+	createSpawnTransform(*spec, levelEntity.vOrigin, levelEntity.fYaw).getOpenGLMatrix(mat4);
+	entityDesc.matModel = glm::make_mat4(mat4);
+
+	if (vcTypeTransforms.size() <= entityDesc.typeID)
+		vcTypeTransforms.resize(entityDesc.typeID + 1);
+	std::vector<glm::mat4>& vcTransforms = vcTypeTransforms[entityDesc.typeID];
+	entityDesc.instanceID = vcTransforms.size();
+	vcTransforms.emplace_back(entityDesc.matModel);
+
+	sceneDesc.vcEntities.emplace_back(entityDesc);
+}
+
+void SceneBuilder::buildInstances(SceneDesc& sceneDesc)
+{
+	//instances of a type are contiguous, types in the order they first appear in the level
+	vcTypeTransforms.resize(sceneDesc.entityTypes.size());
+	for (EntityTypeID typeID = 0; typeID < sceneDesc.entityTypes.size(); typeID++)
+	{
+		EntityTypeDesc& typeDesc = sceneDesc.entityTypes[typeID];
+		typeDesc.baseInstance = sceneDesc.iTotalInstances;
+		typeDesc.iInstances = static_cast<unsigned int>(vcTypeTransforms[typeID].size());
+		sceneDesc.vcInstanceTransforms.insert(sceneDesc.vcInstanceTransforms.end(), vcTypeTransforms[typeID].begin(), vcTypeTransforms[typeID].end());
+		sceneDesc.iTotalInstances += typeDesc.iInstances;
+	}
+}
+
+void SceneBuilder::buildGeometry(SceneDesc& sceneDesc)
+{
+	std::map<RSType, RSLoader>& mapRSLoaders = sceneDesc.mapRSBatches;
+	std::vector<ModelMesh> vcMeshes;
+	for (EntityTypeID typeID = 0; typeID < sceneDesc.entityTypes.size(); typeID++)
+	{
+		//obj parsing and texture decoding is nearly all of the build time
+		fProgress.store(static_cast<float>(typeID) / sceneDesc.entityTypes.size(), std::memory_order_relaxed);
+		EntityTypeDesc& typeDesc = sceneDesc.entityTypes[typeID];
+		if (typeDesc.iInstances == 0)
+			continue;
+		loadModelMeshes(strAssetSrc + typeDesc.strModelPath, vcMeshes);
+
+		for (auto& mesh : vcMeshes)
+		{
+			//decode textures, keyed by texname so the same tex isnt decoded again
+			if (!mesh.strTexName.empty() && sceneDesc.mapTextures.find(mesh.strTexName) == sceneDesc.mapTextures.end())
+				decodeTexture(strAssetSrc + "models/" + mesh.strTexName, 3, sceneDesc.mapTextures[mesh.strTexName]);
+
+			RSLoader& rsLoader = mapRSLoaders[mesh.rsType];
+			typeDesc.vcMeshes.emplace_back(MeshRef{ mesh.rsType, rsLoader.drawID, static_cast<GLuint>(mesh.vertices.size() / 8) });
+
+			//per instance draws all point at the one copy of the mesh
+			const GLuint iDraws = typeDesc.getDrawsPerMesh();
+			for (GLuint iDraw = 0; iDraw < iDraws; iDraw++)
+			{
+				if (mesh.rsType == RSType::BASIC_KD)
+					rsLoader.vcMeshKdColors.emplace_back(mesh.vKdColor);
+				else
+					rsLoader.vcTexNames.emplace_back(mesh.strTexName);
+
+				DrawElementsIndirectCommand cmd;
+				cmd.count = static_cast<GLuint>(mesh.indices.size());
+				cmd.instanceCount = typeDesc.bDrawPerInstance ? 1 : typeDesc.iInstances;
+				cmd.baseInstance = typeDesc.baseInstance + (typeDesc.bDrawPerInstance ? iDraw : 0);
+				cmd.baseVertex = rsLoader.baseVertex;
+				cmd.firstIndex = rsLoader.firstIndex;
+				rsLoader.vcDrawCmd.emplace_back(cmd);
+				rsLoader.drawID++;
+				sceneDesc.iTotalDrawCmd++;										//for the indirect buffer
+			}
+
+			rsLoader.vertices.insert(rsLoader.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+			rsLoader.indices.insert(rsLoader.indices.end(), mesh.indices.begin(), mesh.indices.end());
+
+			//update for next geometry
+			rsLoader.baseVertex = rsLoader.vertices.size() / 8;
+			rsLoader.firstIndex = rsLoader.indices.size();
+		}
+	}
+}
+
+bool SceneBuilder::loadModelMeshes(const std::string& strPath, std::vector<ModelMesh>& vcMeshes)
+{
+	vcMeshes.clear();
+	tinyobj::ObjReaderConfig readerConfig;
+	readerConfig.mtl_search_path = "./";
+	tinyobj::ObjReader reader;
+	if (!reader.ParseFromFile(strPath))
+	{
+		if (!reader.Error().empty())
+			spdlog::error("Reader : " + reader.Error());
+		return false;
+	}
+	if (!reader.Warning().empty())
+		spdlog::warn("Warning : " + reader.Warning());
+
+	const tinyobj::attrib_t& attrib = reader.GetAttrib();
+	auto& materials = reader.GetMaterials();
+	auto& shapes = reader.GetShapes();
+
+	//load each submesh inside model
+	vcMeshes.resize(shapes.size());
+	for (size_t s = 0; s < shapes.size(); s++)
+	{
+		//if mesh doesnt have texture, use Kd
+		ModelMesh& mesh = vcMeshes[s];
+		const tinyobj::material_t& material = materials[shapes[s].mesh.material_ids[0]];
+		mesh.rsType = RSType::TEXTURED;
+		if (material.diffuse_texname.empty())
+		{
+			mesh.rsType = RSType::BASIC_KD;
+			mesh.vKdColor = glm::vec4(material.diffuse[0], material.diffuse[1], material.diffuse[2], 1.f);
+		}
+		else
+		{
+			//check if mesh has emissive tex, set rendertype and use diffuse texture anyways
+			if (!material.emissive_texname.empty())
+				mesh.rsType = RSType::EMISSIVE;
+			mesh.strTexName = material.diffuse_texname;
+		}
+
+		std::unordered_map<VertexTupple, unsigned int, VertexTuppleHash> mapTupples;
+		unsigned int index = 0;
+		size_t iOffset = 0;
+		for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++)
+		{
+			//num vertices on each face (3 by default)
+			size_t fv = shapes[s].mesh.num_face_vertices[f];
+
+			//read each vertex attrib 
+			//in the form of tupples (v/t/n) which contain element id 
+			//and convert them into a single vertex index
+			for (size_t v = 0; v < fv; v++)
+			{
+				tinyobj::index_t idx = shapes[s].mesh.indices[iOffset + v];						//index of each tupple in file 
+
+				//check if this vertex is already loaded in buffer and given index in map
+				VertexTupple tupple(idx.vertex_index, idx.texcoord_index, idx.normal_index);
+				auto iterTupple = mapTupples.find(tupple);
+				if (iterTupple == mapTupples.end())
+				{
+					//v/n/t interleaved
+					mesh.vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index)]);
+					mesh.vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index) + 1]);
+					mesh.vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index) + 2]);
+
+					mesh.vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index)]);
+					mesh.vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index) + 1]);
+					mesh.vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index) + 2]);
+
+					mesh.vertices.emplace_back(attrib.texcoords[2 * size_t(idx.texcoord_index)]);
+					mesh.vertices.emplace_back(attrib.texcoords[2 * size_t(idx.texcoord_index) + 1]);
+
+					mesh.indices.emplace_back(index);
+					mapTupples[tupple] = index++;
+				}
+				else
+					mesh.indices.emplace_back(iterTupple->second);
+			}
+
+			iOffset += fv;
+		}
+	}
+	return true;
+}
+
+void SceneBuilder::buildStencilMesh(SceneDesc& sceneDesc, const std::string& strModelPath)
+{
+	tinyobj::ObjReaderConfig readerConfig;
+	readerConfig.mtl_search_path = "./";
+	tinyobj::ObjReader reader;
+	if (!reader.ParseFromFile(strAssetSrc + strModelPath))
+	{
+		if (!reader.Error().empty())
+			spdlog::error("Reader : " + reader.Error());
+	}
+	if (!reader.Warning().empty())
+		spdlog::warn("Warning : " + reader.Warning());
+
+	const tinyobj::attrib_t& attrib = reader.GetAttrib();
+	auto& shapes = reader.GetShapes();
+
+	//load each submesh inside model
+	std::vector<float>& vertices = sceneDesc.stencilMesh.vertices;
+	std::vector<unsigned int>& indices = sceneDesc.stencilMesh.indices;
+	for (size_t s = 0; s < shapes.size(); s++)
+	{
+		std::unordered_map<VertexTupple, unsigned int, VertexTuppleHash> mapTupples;
+		unsigned int index = 0;
+		size_t iOffset = 0;
+		for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++)
+		{
+			//num vertices on each face (3 by default)
+			size_t fv = shapes[s].mesh.num_face_vertices[f];
+
+			for (size_t v = 0; v < fv; v++)
+			{
+				tinyobj::index_t idx = shapes[s].mesh.indices[iOffset + v];						//index of each tupple in file 
+
+				//check if this vertex is already loaded in buffer and given index in map
+				VertexTupple tupple(idx.vertex_index, idx.texcoord_index, idx.normal_index);
+				auto iterTupple = mapTupples.find(tupple);
+				if (iterTupple == mapTupples.end())
+				{
+					//v/n/t interleaved
+					vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index)]);
+					vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index) + 1]);
+					vertices.emplace_back(attrib.vertices[3 * size_t(idx.vertex_index) + 2]);
+
+					vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index)]);
+					vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index) + 1]);
+					vertices.emplace_back(attrib.normals[3 * size_t(idx.normal_index) + 2]);
+
+					vertices.emplace_back(attrib.texcoords[2 * size_t(idx.texcoord_index)]);
+					vertices.emplace_back(attrib.texcoords[2 * size_t(idx.texcoord_index) + 1]);
+
+					indices.emplace_back(index);
+					mapTupples[tupple] = index++;
+				}
+				else
+					indices.emplace_back(iterTupple->second);
+			}
+
+			iOffset += fv;
+		}
+	}
+}
+
+bool SceneBuilder::decodeTexture(const std::string& strPath, int iChannels, TexturePayload& payload)
+{
+	//flip it 
+	stbi_set_flip_vertically_on_load(true);
+	int width, height, nrChannels;
+	unsigned char* data = stbi_load(strPath.c_str(), &width, &height, &nrChannels, iChannels);
+	if (data == nullptr)
+	{
+		spdlog::error("Failed to load texture : " + strPath);
+		return false;
+	}
+
+	payload.iWidth = width;
+	payload.iHeight = height;
+	payload.iChannels = iChannels;
+	payload.vcPixels.assign(data, data + static_cast<size_t>(width) * height * iChannels);
+	stbi_image_free(data);
+	return true;
+}
@@ -0,0 +1,40 @@
+//cpu only stage of level loading, parses the level, obj files and textures into a SceneDesc
+//never touches gl, the registry or the dynamics world so it can run on any thread or headless
+#pragma once
+#include "SceneDesc.h"
+#include "LevelFile.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+class SceneBuilder
+{
+public:
+	SceneBuilder(std::string strAssetSrc);
+
+	std::shared_ptr<const SceneDesc> build(const std::string& strLevelFile);
+	std::shared_ptr<const SceneDesc> build(const std::vector<LevelEntity>& vcLevel);
+
+	//0 to 1, safe to poll from another thread while build runs
+	float getProgress() const { return fProgress.load(std::memory_order_relaxed); }
+
+	//iChannels 3 or 4, payload is left empty on failure
+	static bool decodeTexture(const std::string& strPath, int iChannels, TexturePayload& payload);
+
+	//parses and welds every submesh of an obj, also used by hot reload to patch a single model
+	static bool loadModelMeshes(const std::string& strPath, std::vector<ModelMesh>& vcMeshes);
+
+private:
+	void addEntity(SceneDesc& sceneDesc, const LevelEntity& levelEntity);
+	void buildInstances(SceneDesc& sceneDesc);
+	void buildGeometry(SceneDesc& sceneDesc);
+	void buildStencilMesh(SceneDesc& sceneDesc, const std::string& strModelPath);
+
+	std::string strAssetSrc;
+	std::atomic<float> fProgress;
+
+	//per build state
+	std::vector<std::vector<glm::mat4>> vcTypeTransforms;						//indexed by EntityTypeID
+	std::string strStencilModel;
+};
@@ -0,0 +1,142 @@
+//immutable, gl free description of a loaded level produced by SceneBuilder
+//everything the gl thread needs to create buffers, textures, entities and rigid bodies without touching the disk again
+#pragma once
+#include "RenderState.h"
+
+#include <LinearMath/btVector3.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct RigidBodySpec;
+
+//index into the scene's EntityTypeTable, interned once while building so nothing per entity compares strings
+typedef uint16_t EntityTypeID;
+constexpr EntityTypeID ciInvalidEntityType = 0xffff;
+
+//decoded pixels, already flipped for gl
+struct TexturePayload
+{
+	int iWidth;
+	int iHeight;
+	int iChannels;																//3 = RGB8, 4 = RGBA8
+	std::vector<unsigned char> vcPixels;
+	TexturePayload() : iWidth(0), iHeight(0), iChannels(0) {}
+};
+
+struct EntityDesc
+{
+	EntityTypeID typeID;														//walls are a type too, just without instances
+	btVector3 vOrigin;
+	float fYaw;
+	btVector3 vDimensions;														//walls only
+	glm::mat4 matModel;															//spawn transform
+	GLuint instanceID;															//index within its entity type
+	bool bRenderable;
+	EntityDesc() : typeID(ciInvalidEntityType), fYaw(0.f), matModel(1.f), instanceID(0), bRenderable(true) {}
+};
+
+//v/n/t interleaved, for directly drawn meshes like the room
+struct MeshBlob
+{
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+};
+
+//one welded submesh of an obj model
+struct ModelMesh
+{
+	RSType rsType;
+	std::string strTexName;														//diffuse texture, empty for BASIC_KD
+	glm::vec4 vKdColor;
+	std::vector<float> vertices;												//v/n/t interleaved
+	std::vector<unsigned int> indices;
+	ModelMesh() : rsType(RSType::BASIC_KD), vKdColor(1.f) {}
+};
+
+//where a submesh of an entity type ended up, drawID indexes the batch's vcDrawCmd
+//types drawn per instance own one command per instance from drawID on, all sharing the same vertex range
+struct MeshRef
+{
+	RSType rsType;
+	GLuint drawID;
+	GLuint iVertices;															//the draw command only knows its index count
+};
+
+//everything the scene knows about one entity type, instances of a type are contiguous from baseInstance
+struct EntityTypeDesc
+{
+	std::string strName;														//level file name, also the RigidBodySpec key
+	const RigidBodySpec* spec;													//nullptr for walls
+	std::string strModelPath;													//obj path relative to the asset folder, empty for walls
+	unsigned int baseInstance;
+	unsigned int iInstances;
+	bool bDrawPerInstance;														//crt screens show different letters, so they cant share one draw
+	std::vector<MeshRef> vcMeshes;												//in model order
+	EntityTypeDesc() : spec(nullptr), baseInstance(0), iInstances(0), bDrawPerInstance(false) {}
+
+	GLuint getDrawsPerMesh() const { return bDrawPerInstance ? iInstances : 1; }
+};
+
+//flat, id indexed table of a scene's entity types, names are only looked up when reading level files
+class EntityTypeTable
+{
+public:
+	EntityTypeID intern(const std::string& strName)
+	{
+		auto iter = mapIDs.find(strName);
+		if (iter != mapIDs.end())
+			return iter->second;
+
+		const EntityTypeID typeID = static_cast<EntityTypeID>(vcTypes.size());
+		vcTypes.emplace_back();
+		vcTypes.back().strName = strName;
+		mapIDs.emplace(strName, typeID);
+		return typeID;
+	}
+
+	EntityTypeID find(const std::string& strName) const
+	{
+		auto iter = mapIDs.find(strName);
+		return iter == mapIDs.end() ? ciInvalidEntityType : iter->second;
+	}
+
+	EntityTypeDesc& operator[](EntityTypeID typeID) { return vcTypes[typeID]; }
+	const EntityTypeDesc& operator[](EntityTypeID typeID) const { return vcTypes[typeID]; }
+	size_t size() const { return vcTypes.size(); }
+	std::vector<EntityTypeDesc>::const_iterator begin() const { return vcTypes.begin(); }
+	std::vector<EntityTypeDesc>::const_iterator end() const { return vcTypes.end(); }
+
+private:
+	std::vector<EntityTypeDesc> vcTypes;
+	std::unordered_map<std::string, EntityTypeID> mapIDs;
+};
+
+struct SceneDesc
+{
+	std::vector<EntityDesc> vcEntities;
+	std::map<RSType, RSLoader> mapRSBatches;									//vertex / index blobs and draw commands per render state
+	std::map<std::string, TexturePayload> mapTextures;							//keyed by the names RSLoader::vcTexNames uses
+	std::vector<glm::mat4> vcInstanceTransforms;								//indexed by baseInstance + instanceID
+	EntityTypeTable entityTypes;
+	MeshBlob stencilMesh;
+	unsigned int iTotalInstances;
+	unsigned int iTotalDrawCmd;
+	SceneDesc() : iTotalInstances(0), iTotalDrawCmd(0) {}
+
+	//rough cpu memory footprint, used for the resource budget
+	size_t getByteSize() const
+	{
+		size_t iBytes = sizeof(SceneDesc) + vcEntities.size() * sizeof(EntityDesc) + vcInstanceTransforms.size() * sizeof(glm::mat4);
+		for (auto& batch : mapRSBatches)
+			iBytes += batch.second.vertices.size() * sizeof(float) + batch.second.indices.size() * sizeof(unsigned int) + batch.second.vcDrawCmd.size() * sizeof(DrawElementsIndirectCommand);
+		for (auto& texture : mapTextures)
+			iBytes += texture.second.vcPixels.size();
+		iBytes += (stencilMesh.vertices.size() + stencilMesh.indices.size()) * 4;
+		return iBytes;
+	}
+};
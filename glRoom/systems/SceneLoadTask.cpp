@@ -0,0 +1,151 @@
+#include "SceneLoadTask.h"
+#include "GeometryLoader.h"
+#include "../FrameTracer.h"
+
+#include <BulletCollision/CollisionShapes/btConvexHullShape.h>
+#include <chrono>
+
+LoadedScene::~LoadedScene()
+{
+	if (!strSceneKey.empty())
+		resourceManager->release(strSceneKey);
+	for (auto& shape : mapShapes)
+		resourceManager->release(shapeResourceKey(shape.first));
+	for (auto& tex : mapTextures)
+		resourceManager->release(tex.first);
+}
+
+SceneLoadTask::SceneLoadTask(ResourceManager* resourceManager, std::string strAssetSrc, std::string strLevelFile) :
+	resourceManager(resourceManager),
+	strAssetSrc(strAssetSrc),
+	strLevelFile(strLevelFile),
+	sceneBuilder(strAssetSrc),
+	loadedScene(resourceManager),
+	bBuilt(false),
+	fShapeProgress(0.f),
+	bUploadStarted(false),
+	bComplete(false)
+{
+	JobSystem::get().runBackground(buildCounter, [this]() { buildScene(); });
+}
+
+SceneLoadTask::~SceneLoadTask()
+{
+	//the builder isnt interruptible, an abandoned load just finishes in the background first
+	JobSystem::get().wait(buildCounter);
+}
+
+static size_t estimateShapeBytes(const BuiltShape& builtShape)
+{
+	size_t iBytes = 256;
+	if (builtShape.meshData.meshInterface != nullptr)
+	{
+		//vertices, indices and roughly one quantized bvh node per triangle
+		const btIndexedMesh& mesh = builtShape.meshData.meshInterface->getIndexedMeshArray()[0];
+		iBytes += mesh.m_numVertices * sizeof(btScalar) * 3 + mesh.m_numTriangles * (sizeof(short) * 3 + 16);
+	}
+	else if (builtShape.collisionShape->getShapeType() == CONVEX_HULL_SHAPE_PROXYTYPE)
+		iBytes += static_cast<btConvexHullShape*>(builtShape.collisionShape)->getNumPoints() * sizeof(btVector3) * 2;
+	return iBytes;
+}
+
+void SceneLoadTask::buildScene()
+{
+	TRACE_SCOPE("SceneLoadTask::buildScene");
+	const std::string strSceneKey = sceneResourceKey(strLevelFile);
+	std::shared_ptr<const SceneDesc> sceneDesc;
+	if (!resourceManager->acquire(strSceneKey, sceneDesc))
+	{
+		sceneDesc = sceneBuilder.build(strLevelFile);
+		resourceManager->insert<std::shared_ptr<const SceneDesc>>(strSceneKey, sceneDesc, sceneDesc->getByteSize(), [](std::shared_ptr<const SceneDesc>& sceneDesc) { sceneDesc.reset(); });
+	}
+
+	//bvh / convex hull building is the expensive part of physics setup, keep it off the gl thread too
+	//bodies of the same type share one shape
+	CollisionShapeBuilder shapeBuilder(strAssetSrc);
+	std::map<std::string, btCollisionShape*> mapShapes;
+	size_t iShape = 0;
+	for (const auto& typeDesc : sceneDesc->entityTypes)
+	{
+		fShapeProgress.store(static_cast<float>(iShape++) / sceneDesc->entityTypes.size(), std::memory_order_relaxed);
+		const RigidBodySpec* spec = typeDesc.spec;
+		if (spec == nullptr || typeDesc.iInstances == 0)
+			continue;
+		const std::string& strSpecType = typeDesc.strName;
+
+		BuiltShape builtShape;
+		if (!resourceManager->acquire(shapeResourceKey(strSpecType), builtShape))
+		{
+			builtShape.collisionShape = shapeBuilder.createShape(*spec, builtShape.meshData);
+			resourceManager->insert<BuiltShape>(shapeResourceKey(strSpecType), builtShape, estimateShapeBytes(builtShape), [](BuiltShape& builtShape)
+				{
+					delete builtShape.collisionShape;
+					freeTriangleMeshData(builtShape.meshData);
+				});
+		}
+		mapShapes[strSpecType] = builtShape.collisionShape;
+	}
+	fShapeProgress.store(1.f, std::memory_order_relaxed);
+
+	loadedScene.strSceneKey = strSceneKey;
+	loadedScene.sceneDesc = sceneDesc;
+	loadedScene.mapShapes = std::move(mapShapes);
+	bBuilt.store(true, std::memory_order_release);
+}
+
+bool SceneLoadTask::update(double fBudgetMs)
+{
+	if (bComplete)
+		return true;
+
+	//a pool without workers only runs the build job when the main thread pumps it
+	JobSystem::get().runMainThreadJobs();
+	if (!bBuilt.load(std::memory_order_acquire))
+		return false;
+
+	TRACE_SCOPE("SceneLoadTask::update");
+	if (!bUploadStarted)
+	{
+		iterPendingTex = loadedScene.sceneDesc->mapTextures.begin();
+		bUploadStarted = true;
+	}
+
+	//always upload at least one so a tiny budget still makes progress, resident ones cost nothing
+	auto start = std::chrono::steady_clock::now();
+	while (iterPendingTex != loadedScene.sceneDesc->mapTextures.end())
+	{
+		const std::string strKey = textureResourceKey(strAssetSrc + "models/" + iterPendingTex->first);
+		GLuint texture = 0;
+		if (!resourceManager->acquire(strKey, texture))
+		{
+			const TexturePayload& payload = iterPendingTex->second;
+			texture = GeometryLoader::uploadTexture(payload);
+			resourceManager->insert<GLuint>(strKey, texture, payload.vcPixels.size() * 4 / 3, GeometryLoader::freeTexture);
+		}
+		loadedScene.mapTextures[strKey] = texture;
+		iterPendingTex++;
+		if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= fBudgetMs)
+			break;
+	}
+
+	bComplete = iterPendingTex == loadedScene.sceneDesc->mapTextures.end();
+	return bComplete;
+}
+
+void SceneLoadTask::finish()
+{
+	JobSystem::get().wait(buildCounter);
+	update(1e9);
+}
+
+float SceneLoadTask::getProgress() const
+{
+	//a resident scene skips the builder entirely
+	float fProgress = bBuilt.load(std::memory_order_acquire) ? 0.8f : sceneBuilder.getProgress() * 0.6f + fShapeProgress.load(std::memory_order_relaxed) * 0.2f;
+	if (bUploadStarted)
+	{
+		const size_t iTotal = loadedScene.sceneDesc->mapTextures.size();
+		fProgress += iTotal == 0 ? 0.2f : 0.2f * loadedScene.mapTextures.size() / iTotal;
+	}
+	return fProgress;
+}
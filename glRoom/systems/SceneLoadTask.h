@@ -0,0 +1,71 @@
+//loads a level in the background while another state keeps rendering
+//scene building and collision shapes run as a background job, textures are uploaded on the gl thread a few per frame
+//anything already resident in the ResourceManager is reused instead of loaded again
+#pragma once
+#include "SceneBuilder.h"
+#include "RigidBodySpec.h"
+#include "../ResourceManager.h"
+#include "../JobSystem.h"
+
+#include <GL/glew.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+//resource manager keys
+inline std::string sceneResourceKey(const std::string& strLevelFile) { return "scene:" + strLevelFile; }
+inline std::string shapeResourceKey(const std::string& strSpecType) { return "shape:" + strSpecType; }
+inline std::string textureResourceKey(const std::string& strPath) { return "tex:" + strPath; }
+
+//everything GeometryLoader needs that was prepared ahead of time, each entry holds one resource reference
+//GeometryLoader adopts the references, whatever is left is released here
+struct LoadedScene
+{
+	ResourceManager* resourceManager;
+	std::string strSceneKey;
+	std::shared_ptr<const SceneDesc> sceneDesc;
+	std::map<std::string, btCollisionShape*> mapShapes;							//shared by every body of a spec type
+	std::map<std::string, GLuint> mapTextures;									//keyed by textureResourceKey, uploaded so far
+
+	LoadedScene(ResourceManager* resourceManager) : resourceManager(resourceManager) {}
+	LoadedScene(const LoadedScene&) = delete;
+	LoadedScene& operator=(const LoadedScene&) = delete;
+	~LoadedScene();
+};
+
+class SceneLoadTask
+{
+public:
+	SceneLoadTask(ResourceManager* resourceManager, std::string strAssetSrc, std::string strLevelFile);
+	~SceneLoadTask();
+
+	//gl thread only, uploads pending textures until fBudgetMs is spent
+	//returns true once the scene is completely ready
+	bool update(double fBudgetMs);
+
+	//blocks until everything is loaded, used when nothing was preloaded
+	void finish();
+
+	//0 to 1, cpu work counts for most of it
+	float getProgress() const;
+	bool isComplete() const { return bComplete; }
+	LoadedScene& getLoadedScene() { return loadedScene; }
+
+private:
+	void buildScene();
+
+	ResourceManager* resourceManager;
+	std::string strAssetSrc;
+	std::string strLevelFile;
+	SceneBuilder sceneBuilder;
+	LoadedScene loadedScene;
+
+	JobCounter buildCounter;
+	std::atomic<bool> bBuilt;													//build job is done, loadedScene.sceneDesc / mapShapes can be read
+	std::atomic<float> fShapeProgress;
+	std::map<std::string, TexturePayload>::const_iterator iterPendingTex;
+	bool bUploadStarted;
+	bool bComplete;
+};
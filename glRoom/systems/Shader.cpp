@@ -8,8 +8,25 @@
 #include <glm/gtc/type_ptr.hpp>
 
 //DIRECTIONAL LIGHT SHADER
-RenderShader::RenderShader(const char* szVSPath, const char* szFSPath) :
-    Shader(szVSPath, szFSPath)
+RenderShader::RenderShader(const char* szVSPath, const char* szFSPath, const std::string& strDefines) :
+    Shader(szVSPath, szFSPath, strDefines)
+{
+    initLocations();
+}
+RenderShader::~RenderShader()
+{
+    glDeleteProgram(programID);
+}
+
+bool RenderShader::reload()
+{
+    if (!Shader::reload())
+        return false;
+    initLocations();
+    return true;
+}
+
+void RenderShader::initLocations()
 {
     uniLocPass = glGetUniformLocation(programID, "Pass");
 
@@ -21,23 +38,49 @@ RenderShader::RenderShader(const char* szVSPath, const char* szFSPath) :
     subBlurVert = glGetSubroutineIndex(programID, GL_FRAGMENT_SHADER, "blurPassVertical");
     subBlurHor = glGetSubroutineIndex(programID, GL_FRAGMENT_SHADER, "blurPassHorizontal");
 }
-RenderShader::~RenderShader()
+
+
+Shader::Shader(const char* szVSPath, const char* szFSPath, const std::string& strDefines) :
+    programID(0),
+    strVSPath(szVSPath),
+    strFSPath(szFSPath),
+    strDefines(strDefines)
 {
-    glDeleteProgram(programID);
+    bool bSuccess;
+    programID = buildProgram(bSuccess);
 }
 
+Shader::~Shader()
+{
+}
 
-Shader::Shader(const char* szVSPath, const char* szFSPath) :
-    programID(0)
+bool Shader::reload()
 {
+    bool bSuccess;
+    unsigned int newProgramID = buildProgram(bSuccess);
+    if (!bSuccess)
+    {
+        spdlog::error("Shader reload failed, keeping the previous program : " + strVSPath + " " + strFSPath);
+        glDeleteProgram(newProgramID);
+        return false;
+    }
+
+    glDeleteProgram(programID);
+    programID = newProgramID;
+    return true;
+}
+
+unsigned int Shader::buildProgram(bool& bSuccess)
+{
+    bSuccess = true;
     std::string strVertexCode, strFragmentCode;
     std::ifstream vShaderFile, fShaderFile;
     vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     try
     {
-        vShaderFile.open(szVSPath);
-        fShaderFile.open(szFSPath);
+        vShaderFile.open(strVSPath);
+        fShaderFile.open(strFSPath);
         std::stringstream vShaderStream, fShaderStream;
         vShaderStream << vShaderFile.rdbuf();
         fShaderStream << fShaderFile.rdbuf();
@@ -49,27 +92,38 @@ Shader::Shader(const char* szVSPath, const char* szFSPath) :
     catch (std::ifstream::failure& e)
     {
        spdlog::error("Failed to read Shader file: " + std::string(e.what()));
+       bSuccess = false;
+    }
+
+    //#version has to stay the first directive
+    if (!strDefines.empty())
+    {
+        for (std::string* strCode : { &strVertexCode, &strFragmentCode })
+        {
+            const size_t iVersion = strCode->find("#version");
+            const size_t iLineEnd = iVersion == std::string::npos ? std::string::npos : strCode->find('\n', iVersion);
+            if (iLineEnd != std::string::npos)
+                strCode->insert(iLineEnd + 1, strDefines);
+        }
     }
 
     //program
-    unsigned int vshader = compileShader(ShaderType::VERTEX, strVertexCode.c_str());
-    unsigned int fshader = compileShader(ShaderType::FRAGMENT, strFragmentCode.c_str());
+    unsigned int vshader = compileShader(ShaderType::VERTEX, strVertexCode.c_str(), bSuccess);
+    unsigned int fshader = compileShader(ShaderType::FRAGMENT, strFragmentCode.c_str(), bSuccess);
 
-    programID = glCreateProgram();
-    glAttachShader(programID, vshader);
-    glAttachShader(programID, fshader);
-    glLinkProgram(programID);
-    checkCompileErrors(programID, ShaderType::PROGRAM);
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vshader);
+    glAttachShader(program, fshader);
+    glLinkProgram(program);
+    if (!checkCompileErrors(program, ShaderType::PROGRAM))
+        bSuccess = false;
 
     glDeleteShader(vshader);
     glDeleteShader(fshader);
+    return program;
 }
 
-Shader::~Shader()
-{
-}
-
-unsigned int Shader::compileShader(ShaderType type, const char* szShader)
+unsigned int Shader::compileShader(ShaderType type, const char* szShader, bool& bSuccess)
 {
     unsigned int shader;
     if(type == ShaderType::VERTEX)
@@ -78,11 +132,12 @@ unsigned int Shader::compileShader(ShaderType type, const char* szShader)
         shader = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(shader, 1, &szShader, NULL);
     glCompileShader(shader);
-    checkCompileErrors(shader, type);
+    if (!checkCompileErrors(shader, type))
+        bSuccess = false;
     return shader;
 }
 
-void Shader::checkCompileErrors(unsigned int shader, ShaderType type)
+bool Shader::checkCompileErrors(unsigned int shader, ShaderType type)
 {
     int success;
     char infoLog[1024];
@@ -110,4 +165,5 @@ void Shader::checkCompileErrors(unsigned int shader, ShaderType type)
             spdlog::error(infoLog);
         }
     }
+    return success != 0;
 }
\ No newline at end of file
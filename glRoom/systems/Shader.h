@@ -1,6 +1,7 @@
 #pragma once
 #include "Components.h"
 #include <glm/mat4x4.hpp>
+#include <string>
 
 enum class ShaderType
 {
@@ -13,12 +14,20 @@ enum class ShaderType
 class Shader
 {
 public:
-    Shader(const char* szVSPath, const char* szFSPath);
+    //strDefines goes right after the #version line of both stages, e.g. "#define TEXTURE_ARRAYS\n"
+    Shader(const char* szVSPath, const char* szFSPath, const std::string& strDefines = "");
     ~Shader();
+
+    //recompiles from the same files, the old program is kept if anything fails
+    bool reload();
     unsigned int programID;
 private:
-    unsigned int compileShader(ShaderType type, const char* szShader);
-    void checkCompileErrors(unsigned int shader, ShaderType type);
+    unsigned int buildProgram(bool& bSuccess);
+    unsigned int compileShader(ShaderType type, const char* szShader, bool& bSuccess);
+    bool checkCompileErrors(unsigned int shader, ShaderType type);
+
+    std::string strVSPath, strFSPath;
+    std::string strDefines;
 };
 
 
@@ -26,8 +35,9 @@ private:
 class RenderShader : public Shader
 {
 public:
-    RenderShader(const char* szVSPath, const char* szFSPath);
+    RenderShader(const char* szVSPath, const char* szFSPath, const std::string& strDefines = "");
     ~RenderShader();
+    bool reload();
     unsigned int uniLocPass;
 
     //subroutines
@@ -38,4 +48,7 @@ public:
     unsigned int subBrightPass;
     unsigned int subBlurVert;
     unsigned int subBlurHor;
+
+private:
+    void initLocations();
 };
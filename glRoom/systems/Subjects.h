@@ -45,6 +45,37 @@ private:
 	std::unique_ptr<Subject> subject;
 };
 
+//save or restore the physics snapshot, F5 / F6
+class PhysicsSnapshotSubject
+{
+public:
+	PhysicsSnapshotSubject() :
+		bRestore(false)
+	{
+		subject = std::make_unique<Subject>();
+	}
+	void attach(IObserver* observer)
+	{
+		subject->attach(observer);
+	}
+	void dettach(IObserver* observer)
+	{
+		subject->dettach(observer);
+	}
+	void notify(const bool bRestore)
+	{
+		this->bRestore = bRestore;
+		for (auto observer : subject->vecObservers)
+			observer->onNotify();
+	}
+
+	bool isRestore() { return bRestore; }
+
+private:
+	std::unique_ptr<Subject> subject;
+	bool bRestore;
+};
+
 //----------------------------------------------
 //MOUSE SUBJECTS
 //left mouse button subjects and observers
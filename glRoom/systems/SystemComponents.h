@@ -28,4 +28,3 @@ struct SCDrawMode
 	DrawMode drawMode;
 	SCDrawMode(DrawMode drawMode = DrawMode::NORMAL) : drawMode(drawMode) {}
 };
-
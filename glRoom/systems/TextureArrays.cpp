@@ -0,0 +1,172 @@
+#include "TextureArrays.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+
+TextureArrays* TextureArrays::instance = nullptr;
+
+void TextureArrays::init(bool bForce)
+{
+	if (GLEW_ARB_bindless_texture && !bForce)
+		return;
+
+	if (bForce)
+		spdlog::info("Texture arrays forced, bindless textures are not used");
+	else
+		spdlog::warn("GL_ARB_bindless_texture is not supported, falling back to texture arrays");
+	instance = new TextureArrays();
+}
+
+void TextureArrays::shutdown()
+{
+	delete instance;
+	instance = nullptr;
+}
+
+TextureArrays::TextureArrays()
+{
+	for (GLuint bucket = 0; bucket < ciBuckets; bucket++)
+		buckets[bucket].iSize = 64u << bucket;
+}
+
+TextureArrays::~TextureArrays()
+{
+	for (auto& bucket : buckets)
+	{
+		if (bucket.texArray != 0)
+			glDeleteTextures(1, &bucket.texArray);
+	}
+}
+
+GLuint TextureArrays::add(const TexturePayload& payload)
+{
+	//smallest bucket the texture fits into, anything bigger is scaled down into the largest
+	TextureLayer layer;
+	const GLuint iSize = static_cast<GLuint>(std::max(payload.iWidth, payload.iHeight));
+	layer.bucket = 0;
+	while (layer.bucket + 1 < ciBuckets && buckets[layer.bucket].iSize < iSize)
+		layer.bucket++;
+	layer.iWidth = payload.iWidth;
+	layer.iHeight = payload.iHeight;
+	layer.iChannels = payload.iChannels;
+	layer.bLive = true;
+
+	TextureBucket& bucket = buckets[layer.bucket];
+	if (!bucket.vcFreeLayers.empty())
+	{
+		layer.layer = bucket.vcFreeLayers.back();
+		bucket.vcFreeLayers.pop_back();
+	}
+	else
+	{
+		reserveLayer(layer.bucket);
+		layer.layer = bucket.iUsed++;
+	}
+	upload(layer, payload);
+
+	if (vcFreeIDs.empty())
+	{
+		vcLayers.emplace_back(layer);
+		return static_cast<GLuint>(vcLayers.size());
+	}
+	const GLuint texture = vcFreeIDs.back();
+	vcFreeIDs.pop_back();
+	vcLayers[texture - 1] = layer;
+	return texture;
+}
+
+void TextureArrays::update(GLuint texture, const TexturePayload& payload)
+{
+	TextureLayer& layer = vcLayers[texture - 1];
+	layer.iWidth = payload.iWidth;
+	layer.iHeight = payload.iHeight;
+	upload(layer, payload);
+}
+
+void TextureArrays::free(GLuint texture)
+{
+	//the array keeps its size, the layer is handed out again first
+	TextureLayer& layer = vcLayers[texture - 1];
+	if (!layer.bLive)
+		return;
+	buckets[layer.bucket].vcFreeLayers.emplace_back(layer.layer);
+	layer.bLive = false;
+	vcFreeIDs.emplace_back(texture);
+}
+
+GLuint64 TextureArrays::getLayerHandle(GLuint texture) const
+{
+	const TextureLayer& layer = vcLayers[texture - 1];
+	return static_cast<GLuint64>(layer.bucket) | (static_cast<GLuint64>(layer.layer) << 32);
+}
+
+void TextureArrays::reserveLayer(GLuint iBucket)
+{
+	TextureBucket& bucket = buckets[iBucket];
+	if (bucket.iUsed < bucket.iLayers)
+		return;
+
+	//immutable storage, growing means a new array with the used layers copied over on the gpu
+	const GLuint iLayers = std::max(bucket.iLayers * 2, 4u);
+	GLuint texArray;
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texArray);
+	glTextureStorage3D(texArray, 1, GL_RGBA8, bucket.iSize, bucket.iSize, iLayers);
+	glTextureParameteri(texArray, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTextureParameteri(texArray, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTextureParameteri(texArray, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(texArray, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if (bucket.texArray != 0)
+	{
+		glCopyImageSubData(bucket.texArray, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, texArray, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, bucket.iSize, bucket.iSize, bucket.iUsed);
+		glDeleteTextures(1, &bucket.texArray);
+	}
+	bucket.texArray = texArray;
+	bucket.iLayers = iLayers;
+
+	//nothing else binds these units, so the arrays stay bound for good
+	glBindTextureUnit(ciFirstUnit + iBucket, texArray);
+}
+
+void TextureArrays::upload(const TextureLayer& layer, const TexturePayload& payload)
+{
+	//failed decodes leave the layer as it was, same as the empty texture bindless would show
+	if (payload.vcPixels.empty())
+		return;
+
+	const TextureBucket& bucket = buckets[layer.bucket];
+	const GLuint iSize = bucket.iSize;
+	const GLenum format = payload.iChannels == 4 ? GL_RGBA : GL_RGB;
+	if (payload.iWidth == static_cast<int>(iSize) && payload.iHeight == static_cast<int>(iSize))
+	{
+		glTextureSubImage3D(bucket.texArray, 0, 0, 0, layer.layer, iSize, iSize, 1, format, GL_UNSIGNED_BYTE, payload.vcPixels.data());
+		return;
+	}
+
+	//bilinear to the bucket size, uvs and wrapping then behave as they would on the texture itself
+	const int iChannels = payload.iChannels;
+	const float fScaleX = static_cast<float>(payload.iWidth) / iSize;
+	const float fScaleY = static_cast<float>(payload.iHeight) / iSize;
+	std::vector<unsigned char> vcResampled(static_cast<size_t>(iSize) * iSize * iChannels);
+	for (GLuint y = 0; y < iSize; y++)
+	{
+		const float fY = std::clamp((y + 0.5f) * fScaleY - 0.5f, 0.f, static_cast<float>(payload.iHeight - 1));
+		const int y0 = static_cast<int>(fY);
+		const int y1 = std::min(y0 + 1, payload.iHeight - 1);
+		const float fWeightY = fY - y0;
+		for (GLuint x = 0; x < iSize; x++)
+		{
+			const float fX = std::clamp((x + 0.5f) * fScaleX - 0.5f, 0.f, static_cast<float>(payload.iWidth - 1));
+			const int x0 = static_cast<int>(fX);
+			const int x1 = std::min(x0 + 1, payload.iWidth - 1);
+			const float fWeightX = fX - x0;
+			for (int c = 0; c < iChannels; c++)
+			{
+				const float fTop = payload.vcPixels[(y0 * payload.iWidth + x0) * iChannels + c] * (1.f - fWeightX) + payload.vcPixels[(y0 * payload.iWidth + x1) * iChannels + c] * fWeightX;
+				const float fBottom = payload.vcPixels[(y1 * payload.iWidth + x0) * iChannels + c] * (1.f - fWeightX) + payload.vcPixels[(y1 * payload.iWidth + x1) * iChannels + c] * fWeightX;
+				vcResampled[(static_cast<size_t>(y) * iSize + x) * iChannels + c] = static_cast<unsigned char>(std::lround(fTop * (1.f - fWeightY) + fBottom * fWeightY));
+			}
+		}
+	}
+	glTextureSubImage3D(bucket.texArray, 0, 0, 0, layer.layer, iSize, iSize, 1, format, GL_UNSIGNED_BYTE, vcResampled.data());
+}
@@ -0,0 +1,63 @@
+//fallback for drivers without GL_ARB_bindless_texture (mesa software rasterizers, most integrated gpus)
+//every texture becomes a layer of one of a few GL_TEXTURE_2D_ARRAYs, bucketed by power of 2 size and resampled to it
+//the "handle" a material ssbo holds is then the bucket in the low and the layer in the high 32 bits, read as uvec2 by render.frag
+//texture names handed out are ids into this pool, not gl textures, GeometryLoader routes upload / free / handle through it
+//gl thread only, like any other texture work
+#pragma once
+#include "SceneDesc.h"
+
+#include <GL/glew.h>
+#include <vector>
+
+struct TextureBucket
+{
+	GLuint texArray;
+	GLuint iSize;																//width and height of every layer
+	GLuint iLayers;
+	GLuint iUsed;																//high water mark
+	std::vector<GLuint> vcFreeLayers;
+	TextureBucket() : texArray(0), iSize(0), iLayers(0), iUsed(0) {}
+};
+
+struct TextureLayer
+{
+	GLuint bucket;
+	GLuint layer;
+	int iWidth;																	//as decoded, before resampling
+	int iHeight;
+	int iChannels;
+	bool bLive;
+};
+
+class TextureArrays
+{
+public:
+	static constexpr GLuint ciBuckets = 6;										//64 up to 2048, must match TexArrays in render.frag
+	static constexpr GLuint ciFirstUnit = 4;									//texture units 0 - 3 belong to the fbos and TexModel
+
+	//after glewInit, creates the pool when bindless textures are missing or bForce is set
+	static void init(bool bForce);
+	static void shutdown();
+
+	//nullptr while bindless textures are in use
+	static TextureArrays* get() { return instance; }
+
+	GLuint add(const TexturePayload& payload);
+	void update(GLuint texture, const TexturePayload& payload);
+	void free(GLuint texture);
+	const TextureLayer& getLayer(GLuint texture) const { return vcLayers[texture - 1]; }
+	GLuint64 getLayerHandle(GLuint texture) const;
+
+private:
+	TextureArrays();
+	~TextureArrays();
+
+	void reserveLayer(GLuint bucket);
+	void upload(const TextureLayer& layer, const TexturePayload& payload);
+
+	static TextureArrays* instance;
+
+	TextureBucket buckets[ciBuckets];
+	std::vector<TextureLayer> vcLayers;											//indexed by texture id - 1, 0 stays the invalid texture
+	std::vector<GLuint> vcFreeIDs;
+};
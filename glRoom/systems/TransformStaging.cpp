@@ -0,0 +1,123 @@
+#include "TransformStaging.h"
+#include <glm/mat4x4.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+
+TransformStaging::TransformStaging(GLuint iTotalSlots) :
+	iTotalSlots(iTotalSlots),
+	iRegion(0),
+	uFrame(1),
+	vcSlotFrame(iTotalSlots, 0),
+	iSealedRegion(0)
+{
+	for (auto& fence : fences)
+		fence = nullptr;
+
+	ptrMapped = mapRing(iTotalSlots);
+	ptrRegion = ptrMapped;
+}
+
+TransformStaging::~TransformStaging()
+{
+	waitFences();
+	glUnmapNamedBuffer(bufStaging);
+	glDeleteBuffers(1, &bufStaging);
+}
+
+float* TransformStaging::mapRing(GLuint iSlots)
+{
+	//coherent so writes from bullet callbacks are visible to the copy without explicit flushes
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &bufStaging);
+	glNamedBufferStorage(bufStaging, sizeof(glm::mat4) * iSlots * ciRegions, nullptr, flags);
+	float* ptrRing = (float*)glMapNamedBufferRange(bufStaging, 0, sizeof(glm::mat4) * iSlots * ciRegions, flags);
+	if (ptrRing == nullptr)
+		spdlog::error("Failed to map transform staging buffer");
+	return ptrRing;
+}
+
+void TransformStaging::waitFences()
+{
+	for (auto& fence : fences)
+	{
+		if (fence != nullptr)
+		{
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+}
+
+void TransformStaging::seal()
+{
+	iSealedRegion = iRegion;
+	vcSealed.swap(vcDirty);
+	vcDirty.clear();
+	uFrame++;
+
+	//next region, the copy that last read it was issued ciRegions - 1 frames ago so this rarely waits
+	iRegion = (iRegion + 1) % ciRegions;
+	if (fences[iRegion] != nullptr)
+	{
+		glClientWaitSync(fences[iRegion], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fences[iRegion]);
+		fences[iRegion] = nullptr;
+	}
+	ptrRegion = ptrMapped + static_cast<size_t>(iTotalSlots) * 16 * iRegion;
+}
+
+void TransformStaging::flush(GLuint ssboTransforms)
+{
+	if (vcSealed.empty())
+		return;
+
+	//one copy per run of consecutive slots, instances of a type are contiguous so runs are long
+	std::sort(vcSealed.begin(), vcSealed.end());
+	const GLintptr offsetRegion = sizeof(glm::mat4) * iTotalSlots * iSealedRegion;
+	for (size_t i = 0; i < vcSealed.size();)
+	{
+		size_t iEnd = i + 1;
+		while (iEnd < vcSealed.size() && vcSealed[iEnd] == vcSealed[iEnd - 1] + 1)
+			iEnd++;
+		glCopyNamedBufferSubData(
+			bufStaging,
+			ssboTransforms,
+			offsetRegion + sizeof(glm::mat4) * vcSealed[i],
+			sizeof(glm::mat4) * vcSealed[i],
+			sizeof(glm::mat4) * (iEnd - i));
+		i = iEnd;
+	}
+	fences[iSealedRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	vcSealed.clear();
+}
+
+void TransformStaging::grow(GLuint iNewSlots)
+{
+	if (iNewSlots <= iTotalSlots)
+		return;
+
+	//nothing may still read the old ring, then carry over the slots written this frame and the sealed ones not copied yet
+	waitFences();
+	const GLuint bufOld = bufStaging;
+	float* ptrOld = ptrMapped;
+	float* ptrNew = mapRing(iNewSlots);
+	auto carryOver = [&](const std::vector<GLuint>& vcSlots, unsigned int iSlotRegion)
+	{
+		for (GLuint iSlot : vcSlots)
+			std::memcpy(
+				ptrNew + (static_cast<size_t>(iNewSlots) * iSlotRegion + iSlot) * 16,
+				ptrOld + (static_cast<size_t>(iTotalSlots) * iSlotRegion + iSlot) * 16,
+				sizeof(glm::mat4));
+	};
+	carryOver(vcDirty, iRegion);
+	carryOver(vcSealed, iSealedRegion);
+	glUnmapNamedBuffer(bufOld);
+	glDeleteBuffers(1, &bufOld);
+
+	iTotalSlots = iNewSlots;
+	vcSlotFrame.resize(iNewSlots, 0);
+	ptrMapped = ptrNew;
+	ptrRegion = ptrMapped + static_cast<size_t>(iTotalSlots) * 16 * iRegion;
+}
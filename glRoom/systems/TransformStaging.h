@@ -0,0 +1,56 @@
+//persistent mapped staging ring for instance transforms
+//motion states write gpu ready matrices straight into their slot, only the slots written this frame are copied into the transform ssbo
+//with a pipelined frame the simulation already writes the next region while the gl thread copies the sealed one
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <vector>
+
+class TransformStaging
+{
+public:
+	static constexpr unsigned int ciRegions = 3;									//written, sealed and one the gpu may still be copying from
+
+	TransformStaging(GLuint iTotalSlots);
+	~TransformStaging();
+
+	//column major mat4 of the slot in the region being written this frame
+	float* mapSlot(const GLuint iSlot)
+	{
+		//other regions hold older frames, so only slots actually written here may be copied
+		if (vcSlotFrame[iSlot] != uFrame)
+		{
+			vcSlotFrame[iSlot] = uFrame;
+			vcDirty.emplace_back(iSlot);
+		}
+		return ptrRegion + static_cast<size_t>(iSlot) * 16;
+	}
+
+	GLuint getTotalSlots() const { return iTotalSlots; }
+
+	//frame boundary, nothing may be writing slots
+	//the region written so far is sealed for the next flush and writes move on to the next region
+	void seal();
+
+	//copy the sealed region's dirty slots into ssboTransforms, may overlap writes to the next region
+	void flush(GLuint ssboTransforms);
+
+	//frame boundary only, reallocates the ring for more slots and keeps whatever wasnt copied yet
+	void grow(GLuint iNewSlots);
+
+private:
+	float* mapRing(GLuint iSlots);
+	void waitFences();
+
+	GLuint bufStaging;
+	GLuint iTotalSlots;
+	float* ptrMapped;
+	float* ptrRegion;
+	unsigned int iRegion;
+	GLsync fences[ciRegions];
+	uint32_t uFrame;																//bumped by seal, a slot is dirty if written in the current frame
+	std::vector<uint32_t> vcSlotFrame;
+	std::vector<GLuint> vcDirty;
+	unsigned int iSealedRegion;
+	std::vector<GLuint> vcSealed;
+};
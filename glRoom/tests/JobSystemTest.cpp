@@ -0,0 +1,221 @@
+//JobSystem unit tests, no window or gl context, registered with ctest
+//every check prints what failed, the exit code is the number of failed checks
+#include "../JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static int iFailed = 0;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { fprintf(stderr, "%s:%d CHECK(%s) failed\n", __FILE__, __LINE__, #expr); iFailed++; } } while (0)
+
+//cpu time of the calling thread only, a sleeping thread doesnt add to it
+static double threadCpuMs()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+	const uint64_t uKernel = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+	const uint64_t uUser = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+	return (uKernel + uUser) / 10000.0;
+#else
+	timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+#endif
+}
+
+static void forkJoin(JobSystem& jobSystem, int iDepth, std::atomic<int>& iLeaves)
+{
+	if (iDepth == 0)
+	{
+		iLeaves.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	JobCounter counter;
+	jobSystem.run(counter, [&jobSystem, iDepth, &iLeaves]() { forkJoin(jobSystem, iDepth - 1, iLeaves); });
+	jobSystem.run(counter, [&jobSystem, iDepth, &iLeaves]() { forkJoin(jobSystem, iDepth - 1, iLeaves); });
+	jobSystem.wait(counter);
+}
+
+//every job waits on its children, so this also covers waits nested inside jobs on workers
+static void testForkJoin(unsigned int iThreads)
+{
+	JobSystem jobSystem(iThreads);
+	std::atomic<int> iLeaves(0);
+	forkJoin(jobSystem, 12, iLeaves);
+	CHECK(iLeaves.load() == 1 << 12);
+}
+
+static void testNestedParallelFor()
+{
+	JobSystem jobSystem(4);
+	std::atomic<int> iSum(0);
+	JobCounter counter;
+	for (int i = 0; i < 8; i++)
+		jobSystem.run(counter, [&jobSystem, &iSum]()
+			{
+				jobSystem.parallelFor(0, 100, 7, [&iSum](int iBegin, int iEnd) { iSum.fetch_add(iEnd - iBegin); });
+			});
+	jobSystem.wait(counter);
+	CHECK(iSum.load() == 800);
+}
+
+static void testParallelFor()
+{
+	JobSystem jobSystem(4);
+
+	//empty and inverted ranges never call the body
+	int iCalls = 0;
+	jobSystem.parallelFor(5, 5, 1, [&iCalls](int, int) { iCalls++; });
+	jobSystem.parallelFor(5, 2, 1, [&iCalls](int, int) { iCalls++; });
+	CHECK(iCalls == 0);
+
+	//a grain bigger than the range is one chunk run by the caller
+	std::vector<std::pair<int, int>> vcChunks;
+	jobSystem.parallelFor(3, 10, 100, [&vcChunks](int iBegin, int iEnd) { vcChunks.emplace_back(iBegin, iEnd); });
+	CHECK(vcChunks.size() == 1);
+	CHECK(!vcChunks.empty() && vcChunks[0].first == 3 && vcChunks[0].second == 10);
+
+	//every index exactly once, whatever the thread limit
+	for (unsigned int iMaxThreads : { 0u, 1u, 2u, 16u })
+	{
+		std::vector<std::atomic<int>> vcVisits(1000);
+		std::mutex mtxThreads;
+		std::set<std::thread::id> setThreads;
+		jobSystem.parallelFor(0, 1000, 3,
+			[&](int iBegin, int iEnd)
+			{
+				for (int i = iBegin; i < iEnd; i++)
+					vcVisits[i].fetch_add(1);
+				std::lock_guard<std::mutex> lock(mtxThreads);
+				setThreads.emplace(std::this_thread::get_id());
+				//long enough for helpers to actually pick up chunks
+				std::this_thread::sleep_for(std::chrono::microseconds(20));
+			},
+			iMaxThreads);
+		CHECK(std::all_of(vcVisits.begin(), vcVisits.end(), [](const std::atomic<int>& iVisits) { return iVisits.load() == 1; }));
+		if (iMaxThreads == 1)
+			CHECK(setThreads.size() == 1 && *setThreads.begin() == std::this_thread::get_id());
+		else if (iMaxThreads != 0)
+			CHECK(setThreads.size() <= iMaxThreads);
+	}
+}
+
+static void testRunOnMain()
+{
+	JobSystem jobSystem(3);
+	const std::thread::id idMain = std::this_thread::get_id();
+	std::atomic<int> iOnMain(0);
+	JobCounter counterWorker, counterMain;
+	for (int i = 0; i < 4; i++)
+		jobSystem.run(counterWorker, [&]()
+			{
+				jobSystem.runOnMain(counterMain, [&]() { if (std::this_thread::get_id() == idMain) iOnMain.fetch_add(1); });
+			});
+	jobSystem.wait(counterWorker);
+	jobSystem.wait(counterMain);
+	CHECK(iOnMain.load() == 4);
+	CHECK(!jobSystem.runMainThreadJobs());
+}
+
+static void testRunBackground()
+{
+	//with workers, background jobs stay off the waiting main thread
+	{
+		JobSystem jobSystem(2);
+		std::thread::id idRan;
+		JobCounter counter;
+		jobSystem.runBackground(counter, [&idRan]() { idRan = std::this_thread::get_id(); });
+		jobSystem.wait(counter);
+		CHECK(idRan != std::thread::id() && idRan != std::this_thread::get_id());
+	}
+	//without workers the waiter has to run them itself
+	{
+		JobSystem jobSystem(1);
+		std::thread::id idRan;
+		JobCounter counter;
+		jobSystem.runBackground(counter, [&idRan]() { idRan = std::this_thread::get_id(); });
+		jobSystem.wait(counter);
+		CHECK(idRan == std::this_thread::get_id());
+	}
+	//nobody waits on a level load, polling the main thread jobs has to be enough
+	{
+		JobSystem jobSystem(1);
+		JobCounter counter;
+		jobSystem.runBackground(counter, []() {});
+		for (int i = 0; i < 10 && !counter.isDone(); i++)
+			jobSystem.runMainThreadJobs();
+		CHECK(counter.isDone());
+	}
+}
+
+static void testShutdownDrains()
+{
+	std::atomic<int> iRan(0);
+	JobCounter counter;
+	{
+		JobSystem jobSystem(3);
+		for (int i = 0; i < 100; i++)
+			jobSystem.run(counter, [&iRan]() { iRan.fetch_add(1); });
+		for (int i = 0; i < 10; i++)
+			jobSystem.runBackground(counter, [&iRan]() { iRan.fetch_add(1); });
+		for (int i = 0; i < 10; i++)
+			jobSystem.runOnMain(counter, [&iRan]() { iRan.fetch_add(1); });
+	}
+	CHECK(iRan.load() == 120);
+	CHECK(counter.isDone());
+}
+
+//a background job queued while the main thread waits on something else used to keep it spinning
+static void testWaitDoesntSpin()
+{
+	JobSystem jobSystem(2);
+	std::atomic<bool> bStarted(false);
+	JobCounter counterSlow, counterBackground;
+	jobSystem.run(counterSlow, [&bStarted]()
+		{
+			bStarted = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		});
+	while (!bStarted)
+		std::this_thread::yield();
+
+	//the only worker is busy, the background job stays queued for the whole wait
+	jobSystem.runBackground(counterBackground, []() {});
+	const double fStartMs = threadCpuMs();
+	jobSystem.wait(counterSlow);
+	const double fSpentMs = threadCpuMs() - fStartMs;
+	CHECK(fSpentMs < 50.0);
+	jobSystem.wait(counterBackground);
+}
+
+int main()
+{
+	for (unsigned int iThreads : { 1u, 2u, 4u })
+		testForkJoin(iThreads);
+	testNestedParallelFor();
+	testParallelFor();
+	testRunOnMain();
+	testRunBackground();
+	testShutdownDrains();
+	testWaitDoesntSpin();
+
+	if (iFailed == 0)
+		printf("all JobSystem tests passed\n");
+	return iFailed;
+}